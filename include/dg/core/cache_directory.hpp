@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace dg {
+
+/**
+ * Directory of the given kind of cache files of the user, $XDG_CACHE_HOME/diligent-graph/<name> or
+ * $HOME/.cache/diligent-graph/<name>. Empty (no cache) if neither variable is set. The directory may not exist yet.
+ */
+std::string userCacheDirectory(const std::string& name);
+
+/// Creates the directory and its parents, errors are reported by the following write
+void createDirectories(const std::string& directory);
+
+}
@@ -25,5 +25,11 @@ public:
 
 };
 
+/**
+ * Tests an axis aligned box against the planes of the view frustum given by the (world) view projection matrix.
+ * Returns false only if the box is completely outside, the far plane is not tested.
+ */
+bool isBoxVisible(const Matrix4& view_proj, const Vector3f& min, const Vector3f& max);
+
 
 }
@@ -7,6 +7,7 @@ class IBuffer;
 class IRenderDevice;
 class IDeviceContext;
 class IPipelineState;
+class IShaderResourceBinding;
 class ISwapChain;
 class PipelineStateDesc;
 class ITexture;
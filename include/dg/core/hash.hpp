@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <type_traits>
 
@@ -44,4 +46,46 @@ std::size_t operator()(const T* v) const
 }
 };
 
+// hash of a block of raw memory (e.g. the contents of vertex arrays)
+inline std::size_t hash_bytes(const void* data, std::size_t size, std::size_t seed = 0) // NOLINT
+{
+    // 64 bit variant of murmur hash, processes 8 bytes per iteration
+    const std::uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+
+    std::uint64_t h = std::uint64_t(seed) ^ (size * m);
+
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + (size & ~std::size_t(7));
+
+    for(; p!=end; p+=8)
+    {
+        std::uint64_t k;
+        std::memcpy(&k, p, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    switch(size & 7)
+    {
+    case 7: h ^= std::uint64_t(p[6]) << 48; // fallthrough
+    case 6: h ^= std::uint64_t(p[5]) << 40; // fallthrough
+    case 5: h ^= std::uint64_t(p[4]) << 32; // fallthrough
+    case 4: h ^= std::uint64_t(p[3]) << 24; // fallthrough
+    case 3: h ^= std::uint64_t(p[2]) << 16; // fallthrough
+    case 2: h ^= std::uint64_t(p[1]) << 8;  // fallthrough
+    case 1: h ^= std::uint64_t(p[0]);
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+
+    return static_cast<std::size_t>(h);
+}
+
 }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include <dg/core/common.hpp>
+
+namespace dg {
+
+/**
+ * Read only memory mapping of a whole file. Shared by the views into the file (MeshFile, KTXFile, AssetPack
+ * entries), the mapping is released with the last of them.
+ */
+class MappedFile
+{
+public:
+    DG_PTR(MappedFile)
+
+    /// Maps the file, throws if it cannot be opened or is empty
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+
+    const std::string& getFilename() const { return filename_; }
+
+    const std::uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    /// Reads the pages of the range into memory (blocks until they are read)
+    void prefetch(std::size_t offset, std::size_t size) const;
+    void prefetch() const { prefetch(0, size_); }
+
+private:
+    std::string filename_;
+    int fd_ = -1;
+    std::size_t size_ = 0;
+    const std::uint8_t* data_ = nullptr;
+};
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace dg {
+
+/**
+ * Fixed number of worker threads that run the background work of the asynchronous loaders (e.g. importing meshes,
+ * reading files), so that loading many assets does not create a thread per asset.
+ *
+ * The threads are started with the first task. The destructor discards the queued tasks, waits for the running
+ * ones and joins the threads, hence tasks must keep the state they access alive (e.g. by shared pointers) and
+ * should check for cancellation in long running work. Owned by SceneManager.
+ */
+class WorkerPool
+{
+public:
+
+    /// Number of threads, 0 for the number of cores up to 4
+    explicit WorkerPool(std::size_t thread_count = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+public:
+
+    /// Queues the task, which is run on one of the threads, thread safe
+    void enqueue(std::function<void()> task);
+
+    /**
+     * Calls body(i) for i in [0, count) on the calling thread and up to getThreadCount() threads of the pool and
+     * returns when all calls are finished. The calling thread takes part, hence this can be called from a task
+     * without waiting for busy threads. After an exception the remaining calls are skipped and it is rethrown.
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+    std::size_t getThreadCount() const { return thread_count_; }
+
+private:
+
+    void run();
+
+private:
+    std::size_t thread_count_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> tasks_;
+    std::size_t idle_ = 0; // threads waiting for a task
+    bool stop_ = false;
+};
+
+}
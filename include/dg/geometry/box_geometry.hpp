@@ -1,5 +1,6 @@
 #pragma once
 
+#include <dg/core/hash.hpp>
 #include <dg/geometry/geometry.hpp>
 
 namespace dg {
@@ -32,5 +33,22 @@ private:
 
     void buildPlane(int u, int v, int w, float udir, float vdir, float width, float height, float depth, int gridX, int gridY);
 };
+
+// hash of the box parameters (used as key by the MeshCache)
+template<>
+struct hash<BoxGeometry::Params>
+{
+std::size_t operator()(const BoxGeometry::Params& p) const
+{
+    std::size_t seed = 0;
+    hash_combine(seed, p.width);
+    hash_combine(seed, p.height);
+    hash_combine(seed, p.depth);
+    hash_combine(seed, p.width_segments);
+    hash_combine(seed, p.height_segments);
+    hash_combine(seed, p.depth_segments);
+    return seed;
+}
+};
     
 }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <dg/geometry/geometry.hpp>
+#include <dg/geometry/vertex_format.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/GraphicsTypes.h>
+
+namespace dg {
+
+/// Simplified index list of a mesh, that refers to the vertices of the full resolution mesh
+struct MeshLod
+{
+    std::vector<std::uint32_t> indices;
+    float                      error = 0.0f; // deviation from the full resolution mesh (in the units of the positions)
+};
+
+/**
+ * CPU side representation of an indexed mesh with interleaved vertices, as it is uploaded to the GPU.
+ * The vertices are stored as raw bytes that are described by input_layout and vertex_stride.
+ * Optional levels of detail are stored in lods, ordered from fine to coarse.
+ */
+struct MeshData
+{
+    std::vector<LayoutElement> input_layout;
+    std::uint32_t              vertex_stride = 0; // in bytes
+    std::uint32_t              vertex_count = 0;
+    std::vector<std::uint8_t>  vertices;
+    std::vector<std::uint32_t> indices;
+    PRIMITIVE_TOPOLOGY         primitive_topology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    std::vector<MeshLod>       lods;
+
+    /// Builds interleaved vertices in the given format from the items of the geometry and the optional colors
+    static MeshData fromGeometry(const IGeometry& geometry, const std::vector<Color>& colors = std::vector<Color>(),
+                                 const VertexFormat& format = VertexFormat());
+
+    /// Hash of the whole content (layout, vertices and indices)
+    std::size_t hash() const;
+
+    /// Returns a pointer to the float32 position of the first vertex or nullptr if there are no such positions
+    const std::uint8_t* positions() const;
+};
+
+/**
+ * Computes a bounding sphere of the vertices (Ritter's approximation) from float positions at the given stride.
+ * Returns false if there are no vertices.
+ */
+bool computeBoundingSphere(const std::uint8_t* positions, std::size_t vertex_count, std::size_t position_stride,
+                           Vector3f& center, float& radius);
+
+/// Hash of the content of the geometry, that can be used as key for caching the resulting mesh
+std::size_t hashGeometry(const IGeometry& geometry);
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <cstdio>
+
+#include <dg/core/common.hpp>
+#include <dg/core/mapped_file.hpp>
+#include <dg/geometry/mesh_data.hpp>
+
+namespace dg {
+
+/**
+ * Binary file of prepared meshes (interleaved vertices, indices and levels of detail), that is memory mapped for
+ * reading, so that the meshes can be uploaded directly from the file without any parsing. It is used to cache
+ * the results of expensive imports, the key identifies the source and the settings of the conversion.
+ *
+ * File layout (little endian, all blocks are 4 byte aligned):
+ *   Header | MeshHeader[mesh_count] | per mesh: Element[element_count] Lod[lod_count] vertices indices lod indices
+ */
+class MeshFile
+{
+public:
+    DG_PTR(MeshFile)
+
+    struct Header
+    {
+        char          magic[4];
+        std::uint32_t version;
+        std::uint64_t key;
+        std::uint32_t mesh_count;
+        std::uint32_t reserved;
+    };
+
+    struct MeshHeader
+    {
+        std::uint32_t element_count;
+        std::uint32_t primitive_topology;
+        std::uint32_t vertex_stride;
+        std::uint32_t vertex_count;
+        std::uint32_t index_count;
+        std::uint32_t lod_count;
+        std::uint64_t offset;          ///< of the elements of the mesh in the file
+    };
+
+    struct Element
+    {
+        std::uint32_t input_index;
+        std::uint32_t buffer_slot;
+        std::uint32_t num_components;
+        std::uint32_t value_type;
+        std::uint32_t is_normalized;
+        std::uint32_t relative_offset;
+        std::uint32_t stride;
+        std::uint32_t frequency;
+        std::uint32_t instance_step_rate;
+    };
+
+    struct Lod
+    {
+        std::uint32_t index_count;
+        float         error;
+    };
+
+    /// Mesh in the mapped file, the pointers are valid as long as the file is open
+    struct MeshView
+    {
+        std::vector<LayoutElement> input_layout;
+        PRIMITIVE_TOPOLOGY         primitive_topology;
+        std::uint32_t              vertex_stride;
+        std::uint32_t              vertex_count;
+        const std::uint8_t*        vertices;
+        std::uint32_t              index_count;
+        const std::uint32_t*       indices;
+
+        struct LodView
+        {
+            std::uint32_t        index_count;
+            const std::uint32_t* indices;
+            float                error;
+        };
+        std::vector<LodView>       lods;
+    };
+
+    static constexpr std::uint32_t VERSION = 1;
+
+    /// Maps the file, throws if it cannot be opened or is not a valid mesh file of this version
+    static Ptr open(const std::string& filename);
+
+    /// Writes the meshes to a new file (via a temporary file, so that readers never see a partial file)
+    static void write(const std::string& filename, std::uint64_t key, const std::vector<MeshData>& meshes);
+
+    /// Writes the meshes at the current position of the stream, the offsets are relative to it
+    static bool write(std::FILE* f, std::uint64_t key, const std::vector<MeshData>& meshes);
+
+    MeshFile(const std::string& filename);
+
+    /// Mesh file at the byte range of a mapped file (e.g. in an AssetPack), throws if it is not valid
+    MeshFile(MappedFile::ConstPtr file, std::size_t offset, std::size_t size);
+
+    MeshFile(const MeshFile&) = delete;
+    MeshFile& operator=(const MeshFile&) = delete;
+
+public:
+
+    std::uint64_t getKey() const { return header_->key; }
+
+    std::size_t getMeshCount() const { return header_->mesh_count; }
+    MeshView getMesh(std::size_t i) const;
+
+    /// Bytes of the vertices, indices and levels of detail of the mesh
+    std::size_t getMeshSize(std::size_t i) const;
+
+    /// Reads all pages of the file into memory (blocks until they are read)
+    void prefetch() const;
+
+private:
+    MappedFile::ConstPtr file_;
+    std::size_t offset_ = 0;
+    std::size_t size_ = 0;
+    const std::uint8_t* data_ = nullptr;
+    const Header* header_ = nullptr;
+    const MeshHeader* meshes_ = nullptr;
+};
+
+}
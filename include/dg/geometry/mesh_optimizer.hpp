@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <dg/core/common.hpp>
+#include <dg/geometry/mesh_data.hpp>
+
+namespace dg {
+
+/**
+ * Optimization steps that can be applied to indexed meshes before they are uploaded to the GPU.
+ * The vertex cache and overdraw steps are only applied to triangle lists.
+ */
+enum MeshOptimization {
+    MeshOptimization_None        = 0x0,
+    MeshOptimization_VertexCache = 0x1, ///< reorder triangles for the post-transform vertex cache
+    MeshOptimization_Overdraw    = 0x2, ///< reorder clusters of triangles front to back (requires float32 positions)
+    MeshOptimization_VertexFetch = 0x4, ///< reorder vertices in the order of their first use, removes unused vertices
+    MeshOptimization_All         = 0x7
+};
+DG_ENUM_FLAGS(MeshOptimization)
+
+
+/**
+ * Throws if an index is not below vertex_count. The functions below check their indices with this,
+ * since an index read from a corrupt file would otherwise be used as an array subscript.
+ */
+void checkIndices(const std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count);
+
+/**
+ * Reorders the triangles of a triangle list to improve the hit rate of the post-transform vertex cache
+ * (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+ */
+void optimizeVertexCache(std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count);
+
+/**
+ * Reorders clusters of triangles, so that triangles that are likely to occlude others are drawn first
+ * (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+ * The clusters are formed at the vertex cache boundaries of the current triangle order, hence this should be
+ * called after optimizeVertexCache(). The positions are given as 3 floats at the given stride (in bytes).
+ */
+void optimizeOverdraw(std::uint32_t* indices, std::size_t index_count,
+                      const std::uint8_t* positions, std::size_t vertex_count, std::size_t position_stride);
+
+/**
+ * Reorders the vertices in the order they are referenced by the indices and updates the indices accordingly.
+ * Vertices that are not referenced are removed. Returns the new number of vertices.
+ */
+std::size_t optimizeVertexFetch(std::uint8_t* vertices, std::size_t vertex_count, std::size_t vertex_stride,
+                                std::uint32_t* indices, std::size_t index_count);
+
+/**
+ * Applies the given optimizations to an interleaved mesh, the position is taken from the element with input index 0.
+ * Returns the new number of vertices.
+ */
+std::size_t optimizeMesh(MeshOptimization optimization, PRIMITIVE_TOPOLOGY topology, const std::vector<LayoutElement>& layout,
+                         std::uint8_t* vertices, std::size_t vertex_count, std::size_t vertex_stride,
+                         std::uint32_t* indices, std::size_t index_count);
+
+void optimizeMesh(MeshOptimization optimization, MeshData& data);
+
+/**
+ * Simulates a FIFO post-transform vertex cache of the given size and returns the average cache miss ratio
+ * (number of transformed vertices per triangle) of a triangle list. The optimum is 0.5 for large regular meshes,
+ * the worst case is 3.
+ */
+float computeACMR(const std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count, std::size_t cache_size = 16);
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+#include <dg/geometry/mesh_data.hpp>
+
+namespace dg {
+
+/**
+ * Simplifies a triangle list by quadric error edge collapses (Garland and Heckbert).
+ *
+ * Only the indices are changed: vertices are collapsed onto neighboring vertices, hence the simplified
+ * indices refer to the original vertex buffer and all levels of detail of a mesh can share it. Vertices at
+ * borders and at attribute seams (vertices that are split because of different normals or uvs) are not moved.
+ * The positions are given as 3 floats at the given stride (in bytes).
+ *
+ * Stops when the number of indices reaches target_index_count or no edge can be collapsed with an error
+ * below max_error. Returns the error of the result (a distance in the units of the positions).
+ */
+float simplifyMesh(std::vector<std::uint32_t>& indices, const std::uint8_t* positions, std::size_t vertex_count,
+                   std::size_t position_stride, std::size_t target_index_count,
+                   float max_error = std::numeric_limits<float>::max());
+
+
+struct LodOptions
+{
+    int         max_levels = 4;          ///< maximum number of levels in addition to the full resolution mesh
+    float       reduction = 0.5f;        ///< ratio of the triangle counts of two successive levels
+    std::size_t min_index_count = 3*256; ///< meshes or levels with fewer indices are not simplified further
+};
+
+/**
+ * Generates a chain of successively simplified levels of detail for a triangle list, ordered from fine to coarse.
+ * The positions are given as 3 floats at the given stride (in bytes).
+ */
+std::vector<MeshLod> generateLods(const std::uint32_t* indices, std::size_t index_count, const std::uint8_t* positions,
+                                  std::size_t vertex_count, std::size_t position_stride, const LodOptions& options = LodOptions());
+
+/**
+ * Generates the levels of detail for the triangle list in data and stores them in data.lods.
+ * The position is taken from the element with input index 0, which must be float32.
+ */
+void generateLods(MeshData& data, const LodOptions& options = LodOptions());
+
+}
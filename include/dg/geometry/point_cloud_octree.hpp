@@ -0,0 +1,173 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include <dg/core/common.hpp>
+
+namespace dg {
+
+/**
+ * Octree of a point cloud in a file, that is memory mapped for reading.
+ *
+ * Each node stores a subsample of the points in its cell with a minimum distance (spacing) of cell size / sampling
+ * grid resolution, the remaining points are passed to the children. Drawing a node and any subset of its resident
+ * descendants hence gives a consistent level of detail, and nodes can be loaded (and evicted) independently.
+ *
+ * File layout (little endian):
+ *   Header | points of the nodes (16 bytes each, grouped by node) | node table (Node[node_count])
+ * The root is the first node of the table.
+ */
+class PointCloudOctree
+{
+public:
+    DG_PTR(PointCloudOctree)
+
+    enum class AttributeType : std::uint32_t
+    {
+        Color,    ///< RGBA8 as packed by Color::toUInt32()
+        Intensity ///< float
+    };
+
+    struct Point
+    {
+        float x, y, z;
+        std::uint32_t attribute;
+    };
+
+    struct Header
+    {
+        char          magic[4];
+        std::uint32_t version;
+        AttributeType attribute_type;
+        std::uint32_t node_count;
+        std::uint64_t point_count;
+        std::uint64_t node_table_offset;
+        float         min[3];
+        float         max[3];
+    };
+
+    struct Node
+    {
+        float         min[3];        ///< tight bounds of the points of the node and its descendants
+        float         max[3];
+        float         spacing;       ///< minimum distance of the points of this node
+        std::uint32_t level;
+        std::uint64_t offset;        ///< of the first point in the file
+        std::uint32_t point_count;
+        std::int32_t  children[8];   ///< indices of the children in the node table, -1 for empty octants
+        std::uint32_t padding;
+    };
+
+    static constexpr std::uint32_t VERSION = 1;
+
+    /// Maps the file, throws if it cannot be opened or is not a valid octree file
+    static Ptr open(const std::string& filename);
+
+    PointCloudOctree(const std::string& filename);
+    ~PointCloudOctree();
+
+    PointCloudOctree(const PointCloudOctree&) = delete;
+    PointCloudOctree& operator=(const PointCloudOctree&) = delete;
+
+public:
+
+    const Header& getHeader() const { return *header_; }
+    AttributeType getAttributeType() const { return header_->attribute_type; }
+    std::uint64_t getPointCount() const { return header_->point_count; }
+
+    std::size_t getNodeCount() const { return header_->node_count; }
+    const Node& getNode(std::size_t i) const { return nodes_[i]; }
+
+    /// Points of the node, the pages are read from the file when they are accessed the first time
+    const Point* getPoints(std::size_t i) const;
+
+    /// Reads the pages of the points of the node into memory (blocks until they are read)
+    void prefetch(std::size_t i) const;
+
+private:
+    int fd_ = -1;
+    std::size_t size_ = 0;
+    const std::uint8_t* data_ = nullptr;
+    const Header* header_ = nullptr;
+    const Node* nodes_ = nullptr;
+};
+
+
+struct PointCloudOctreeOptions
+{
+    std::uint32_t max_node_points = 20000;   ///< nodes with more points are split
+    std::uint32_t sampling_grid = 128;       ///< resolution of the sampling grid of a node per axis
+    std::uint32_t bin_level = 3;             ///< level of the bins (8^bin_level bins)
+    std::size_t   memory_budget = 256 << 20; ///< bytes of buffered points, before they are written to the temporary files
+};
+
+/**
+ * Builds a PointCloudOctree file from point clouds that do not fit in memory.
+ *
+ * The points are distributed into the cells of a fixed level (the bins) while they are added and written to
+ * temporary files whenever memory_budget is exceeded. In finish() the subtree of each bin is built in memory,
+ * hence only the points of a single bin have to fit in memory. The inner nodes above the bins are built from
+ * subsamples that are moved out of their children, hence each point is stored in exactly one node.
+ */
+class PointCloudOctreeBuilder
+{
+public:
+
+    using Options = PointCloudOctreeOptions;
+    using AttributeType = PointCloudOctree::AttributeType;
+
+    /// The bounds must contain all points that are added
+    PointCloudOctreeBuilder(const std::string& filename, const Vector3f& min, const Vector3f& max,
+                            AttributeType attribute_type, const Options& options = Options());
+    ~PointCloudOctreeBuilder();
+
+    void addPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count);
+    void addPoints(const Vector3f* positions, const float* intensities, std::size_t count);
+
+    /// Builds the octree and writes the file, the builder cannot be used anymore afterwards
+    void finish();
+
+private:
+
+    using Point = PointCloudOctree::Point;
+    using Node = PointCloudOctree::Node;
+
+    struct Bin
+    {
+        std::vector<Point> points;    // buffered points
+        std::uint64_t      spilled = 0; // number of points in the temporary file
+    };
+
+    template <typename Attribute>
+    void add(const Vector3f* positions, const Attribute* attributes, std::size_t count, AttributeType type);
+
+    void flush();
+    std::string binFilename(std::size_t bin) const;
+    void loadBin(std::size_t bin, std::vector<Point>& points);
+
+    std::int32_t buildSubtree(std::vector<Point>& points, const Vector3f& cell_min, float cell_size,
+                              std::uint32_t level, std::vector<Point>* sampled);
+    void writeNode(Node& node, const Point* points, std::size_t count);
+
+private:
+
+    std::string filename_;
+    Options options_;
+    AttributeType attribute_type_;
+    Vector3f min_;
+    float size_;
+
+    std::vector<Bin> bins_;
+    std::size_t buffered_points_ = 0;
+    std::uint64_t point_count_ = 0;
+
+    std::FILE* file_ = nullptr;
+    std::uint64_t file_offset_ = 0;
+    std::vector<Node> nodes_;
+    bool finished_ = false;
+};
+
+}
@@ -2,6 +2,7 @@
 
 #include <cmath>
 
+#include <dg/core/hash.hpp>
 #include <dg/geometry/geometry.hpp>
 
 namespace dg {
@@ -32,5 +33,23 @@ public:
     explicit SphereGeometry(const Params& params = Params(), bool generate_normals = true, bool generate_uvs = true);
 
 };
+
+// hash of the sphere parameters (used as key by the MeshCache)
+template<>
+struct hash<SphereGeometry::Params>
+{
+std::size_t operator()(const SphereGeometry::Params& p) const
+{
+    std::size_t seed = 0;
+    hash_combine(seed, p.radius);
+    hash_combine(seed, p.width_segments);
+    hash_combine(seed, p.height_segments);
+    hash_combine(seed, p.phi_start);
+    hash_combine(seed, p.phi_end);
+    hash_combine(seed, p.theta_start);
+    hash_combine(seed, p.theta_end);
+    return seed;
+}
+};
     
 }
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <dg/core/common.hpp>
+#include <dg/material/color.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/InputLayout.h>
+
+namespace dg {
+
+/**
+ * Describes how the vertex attributes of ManualObject and GeometryObject are stored in their vertex buffers.
+ *
+ * Positions are always stored as 3 x float32. The compact formats are normalized integer or half float
+ * formats that are expanded to floats by the input assembler, hence they work with all materials
+ * without any changes to their shaders.
+ */
+struct VertexFormat
+{
+    enum class NormalFormat : std::uint8_t
+    {
+        Float32, ///< 3 x float32 (12 bytes)
+        SNorm16  ///< 4 x snorm16 (8 bytes, the 4th component is padding)
+    };
+
+    enum class ColorFormat : std::uint8_t
+    {
+        Float32, ///< 4 x float32 (16 bytes)
+        UNorm8   ///< 4 x unorm8  (4 bytes)
+    };
+
+    enum class UVFormat : std::uint8_t
+    {
+        Float32, ///< 2 x float32 (8 bytes)
+        Float16  ///< 2 x float16 (4 bytes)
+    };
+
+    NormalFormat normal = NormalFormat::Float32;
+    ColorFormat  color  = ColorFormat::Float32;
+    UVFormat     uv     = UVFormat::Float32;
+
+    VertexFormat() = default;
+    VertexFormat(NormalFormat normal, ColorFormat color, UVFormat uv) : normal(normal), color(color), uv(uv) {}
+
+    /// Returns the compact format: snorm16 normals, unorm8 colors and float16 uvs
+    static VertexFormat compact()
+    {
+        return VertexFormat(NormalFormat::SNorm16, ColorFormat::UNorm8, UVFormat::Float16);
+    }
+
+    bool operator==(const VertexFormat& other) const
+    {
+        return normal == other.normal && color == other.color && uv == other.uv;
+    }
+
+    bool operator!=(const VertexFormat& other) const
+    {
+        return !(*this == other);
+    }
+
+public:
+
+    // sizes of the attributes in bytes
+    std::uint32_t positionSize() const { return 3*sizeof(float); }
+    std::uint32_t normalSize() const   { return normal == NormalFormat::Float32 ? 3*sizeof(float) : 4*sizeof(std::int16_t); }
+    std::uint32_t colorSize() const    { return color  == ColorFormat::Float32  ? 4*sizeof(float) : 4*sizeof(std::uint8_t); }
+    std::uint32_t uvSize() const       { return uv     == UVFormat::Float32     ? 2*sizeof(float) : 2*sizeof(std::uint16_t); }
+
+    // input layout elements of the attributes (the input indices match the ATTRIBn semantics of the materials)
+    LayoutElement positionElement() const;
+    LayoutElement normalElement() const;
+    LayoutElement colorElement() const;
+    LayoutElement uvElement() const;
+
+    // write the attributes in this format to dst, returns the pointer behind the written data
+    std::uint8_t* writePosition(std::uint8_t* dst, float x, float y, float z) const;
+    std::uint8_t* writeNormal(std::uint8_t* dst, float x, float y, float z) const;
+    std::uint8_t* writeColor(std::uint8_t* dst, const Color& col) const;
+    std::uint8_t* writeUV(std::uint8_t* dst, float u, float v) const;
+
+    /**
+     * Bulk versions for the conversion of whole meshes: write count attributes from tightly packed float arrays
+     * to the interleaved vertices at dst with the given vertex stride (in bytes). The positions are transformed
+     * by the affine transform, the normals by its upper 3x3 block and normalized. The colors are RGBA, with
+     * to_srgb the RGB channels are converted like Color::toSRGB().
+     */
+    void writePositions(std::uint8_t* dst, std::size_t stride, const float* xyz, std::size_t count, const Matrix4f& transform) const;
+    void writeNormals(std::uint8_t* dst, std::size_t stride, const float* xyz, std::size_t count, const Matrix4f& transform) const;
+    void writeColors(std::uint8_t* dst, std::size_t stride, const float* rgba, std::size_t count, bool to_srgb = false) const;
+};
+
+
+/// Converts a float to an IEEE 754 half float (round to nearest even)
+std::uint16_t floatToHalf(float v);
+
+/// Returns the smallest index type that can address the given number of vertices (VT_UINT16 or VT_UINT32)
+VALUE_TYPE indexTypeForVertexCount(std::size_t vertex_count);
+
+/// Returns the size of a single index of the given type in bytes
+inline std::uint32_t indexSize(VALUE_TYPE index_type)
+{
+    return index_type == VT_UINT16 ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+}
+
+/// Returns the size of a single component of the given value type in bytes
+std::uint32_t valueTypeSize(VALUE_TYPE type);
+
+/**
+ * Returns the byte offset of the element with the given input index within an interleaved vertex (buffer slot 0),
+ * or -1 if the layout does not contain the element. Automatic offsets are resolved like the input assembler does.
+ */
+int findElementOffset(const std::vector<LayoutElement>& layout, std::uint32_t input_index);
+
+/// Returns the byte offset of the position (input index 0) if it is stored as 3 x float32, otherwise -1
+int findPositionOffset(const std::vector<LayoutElement>& layout);
+
+/**
+ * Packs the given 32 bit indices into dst using the given index type.
+ * Returns a pointer to the packed data, which is either dst or the indices themselves if no conversion is necessary.
+ */
+const void* packIndices(const std::uint32_t* indices, std::size_t count, VALUE_TYPE index_type, std::vector<std::uint8_t>& dst);
+
+}
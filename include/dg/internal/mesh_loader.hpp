@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <dg/core/worker_pool.hpp>
+#include <dg/geometry/mesh_data.hpp>
+#include <dg/geometry/mesh_file.hpp>
+#include <dg/geometry/mesh_optimizer.hpp>
+#include <dg/geometry/mesh_simplifier.hpp>
+#include <dg/geometry/vertex_format.hpp>
+#include <dg/scene/mesh_buffers.hpp>
+
+namespace dg {
+
+/// Settings of the conversion of imported meshes
+struct MeshLoadSettings
+{
+    VertexFormat     vertex_format;
+    MeshOptimization mesh_optimization = MeshOptimization_All;
+    bool             generate_lods = true;
+    LodOptions       lod_options;
+    bool             cache_enabled = true;
+    std::string      cache_directory;  ///< empty for MeshLoader::defaultCacheDirectory()
+};
+
+/**
+ * Imports the meshes of a file with Assimp and converts them to prepared (optimized and simplified) meshes,
+ * or maps them from the binary cache (see MeshFile) if it is up to date. Used by AssimpMesh and MeshManager.
+ *
+ * load() does not access the GPU and can run on any thread, upload() must be called on the render thread.
+ */
+class MeshLoader
+{
+public:
+
+    MeshLoader() = default;
+    MeshLoader(const std::string& filename, const MeshLoadSettings& settings);
+
+    /**
+     * Maps the cache or imports the file and writes the cache. With prefetch the mapped cache is read into memory
+     * before returning. Returns early if cancelled is set. The submeshes are imported in parallel on the pool, if one
+     * is given, otherwise on the calling thread.
+     */
+    void load(bool prefetch = false, const std::atomic<bool>* cancelled = nullptr, WorkerPool* pool = nullptr);
+
+    std::size_t getMeshCount() const { return cache_ ? cache_->getMeshCount() : meshes_.size(); }
+
+    /// Bytes of the vertices, indices and levels of detail of the mesh
+    std::size_t getMeshSize(std::size_t i) const;
+
+    /// Uploads mesh i and releases its CPU copy
+    MeshBuffers::Ptr upload(IRenderDevice* device, std::size_t i);
+
+    bool isFromCache() const { return static_cast<bool>(cache_); }
+
+    /// Moves the imported meshes out of the loader (empty if they were mapped from the cache)
+    std::vector<MeshData> takeMeshes() { return std::move(meshes_); }
+
+    /**
+     * Directory of the cache files if none is set, $XDG_CACHE_HOME/diligent-graph/meshes or
+     * $HOME/.cache/diligent-graph/meshes. Empty (no cache) if neither variable is set.
+     */
+    static std::string defaultCacheDirectory();
+
+private:
+
+    void import(const std::atomic<bool>* cancelled, WorkerPool* pool);
+
+    // the cache file and the key, that identifies the version of the source and the settings
+    void initCacheEntry();
+
+private:
+
+    std::string filename_;
+    MeshLoadSettings settings_;
+
+    std::string cache_filename_; // empty if the cache is disabled
+    std::uint64_t cache_key_ = 0;
+
+    std::vector<MeshData> meshes_;
+    MeshFile::Ptr cache_;
+};
+
+}
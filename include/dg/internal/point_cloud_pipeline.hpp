@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include <dg/core/fwds.hpp>
+
+#include <DiligentCore/Common/interface/RefCntAutoPtr.hpp>
+
+namespace dg {
+
+class SceneManager;
+class ShaderProgram;
+
+/**
+ * Shader and pipeline state, that are shared by the point cloud renderables.
+ *
+ * The points are 16 byte instances (3 floats for the position and either a RGBA8 color or a float intensity),
+ * each instance is drawn as a screen aligned quad of 4 vertices.
+ */
+class PointCloudPipeline
+{
+public:
+
+    struct Parameters
+    {
+        bool  use_intensity = false;
+        int   colormap = 1;         ///< 0 = grayscale, 1 = turbo, 2 = viridis
+        float min_intensity = 0.0f;
+        float max_intensity = 1.0f;
+        float point_size = 2.0f;    ///< in pixels
+        bool  round_points = false;
+    };
+
+    PointCloudPipeline();
+    ~PointCloudPipeline();
+
+    /// Creates the pipeline state if necessary, updates the constants and binds the pipeline state to the context
+    void begin(SceneManager* manager, const Parameters& params);
+
+    /// Draws count points from the given vertex buffer (must be called between begin() and the end of the render())
+    void draw(IDeviceContext* context, IBuffer* buffer, std::uint32_t count);
+
+private:
+
+    std::shared_ptr<ShaderProgram> shader_program_;
+    RefCntAutoPtr<IPipelineState>         pso_;
+    RefCntAutoPtr<IShaderResourceBinding> srb_;
+    bool pso_use_intensity_ = false;
+};
+
+}
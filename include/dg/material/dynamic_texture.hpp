@@ -1,9 +1,13 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
+#include <algorithm>
 
 #include <dg/core/fwds.hpp>
 #include <DiligentCore/Common/interface/RefCntAutoPtr.hpp>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Fence.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Texture.h>
 
 namespace dg {
 
@@ -18,6 +22,15 @@ public:
         GREY16,
         RGB8,
         RGBA8,
+        GREY_ALPHA8,
+        GREY_ALPHA16,
+        NV12,       ///< luma plane followed by a plane of interleaved U and V at half the resolution, see ImageData
+        I420,       ///< luma plane followed by a U and a V plane at half the resolution, see ImageData
+        YUYV,       ///< Y0 U Y1 V for each pair of pixels
+        BAYER_RGGB, ///< raw 8 bit sensor data, named by the colors of the first two rows
+        BAYER_BGGR,
+        BAYER_GRBG,
+        BAYER_GBRG,
     };
 
     struct ImageData
@@ -27,19 +40,152 @@ public:
         std::uint32_t width;
         std::uint32_t height;
         DataFormat format;
+
+        /**
+         * Chroma planes of NV12 (UV) and I420 (U, V) images with their strides in bytes. Zero (e.g. if omitted in the
+         * initializer) if the planes follow the luma plane in data, with the stride of the luma plane for NV12 and
+         * half of it for I420. They are read for these formats only, but as they are not initialized by default,
+         * an ImageData that is filled member by member must be value-initialized (ImageData data{};).
+         */
+        const void* planes[2];
+        std::uint32_t plane_strides[2];
+    };
+
+    /// Region of an image in pixels
+    struct Rect
+    {
+        std::uint32_t x;
+        std::uint32_t y;
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    /// Image in the mapped staging texture, that the producer writes in place
+    struct MappedImage
+    {
+        void* data = nullptr; ///< nullptr if no staging texture could be mapped
+        std::uint32_t stride = 0;
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        DataFormat format = RGBA8;
+    };
+
+    /// Implementations of the conversion of the image data to RGBA8
+    enum ConvertKernel
+    {
+        KERNEL_AUTO,   ///< the fastest kernel that the CPU supports
+        KERNEL_SCALAR,
+        KERNEL_SSE2,
+        KERNEL_AVX2,
+        KERNEL_NEON,
     };
 
     DynamicTexture() = default;
 
+    /**
+     * Number of textures with their staging textures, that are used in turn (1 by default, must be set before the
+     * first image). With 3 buffers an image is uploaded while the GPU still draws the previous ones, without stalls.
+     */
+    void setBufferCount(std::uint32_t count) { buffer_count_ = std::max(count, 1u); }
+    std::uint32_t getBufferCount() const { return buffer_count_; }
+
+    /// Kernels that are compiled in and supported by the CPU, starting with KERNEL_SCALAR
+    static std::vector<ConvertKernel> getSupportedKernels();
+    static const char* getKernelName(ConvertKernel kernel);
+
+    /// Converts a GREY8, GREY16, RGB8 or RGBA8 image to RGBA8 rows with the given stride in bytes
+    static void convert(const ImageData& data, void* dest, std::uint32_t dest_stride, ConvertKernel kernel = KERNEL_AUTO);
+
+    /**
+     * Uploads the image, the texture is created on the first call. Grey images (with alpha) are uploaded as single
+     * (dual) channel textures without conversion, UnlitMaterial expands them (see UnlitMaterial::texture_channels).
+     * YUV and Bayer images are uploaded as they are, too, and decoded by UnlitMaterial: NV12 and I420 into an R8
+     * texture with the chroma planes below the luma plane (the U plane left of the V plane), YUYV into an RG8 and
+     * Bayer images into an R8 texture. NV12, I420 and YUYV images must have an even width (and height).
+     * Returns false if the size or texture format differs from the first image.
+     */
     bool update(IRenderDevice* device, IDeviceContext* context, const ImageData& data);
 
-    /// Returns the underlying texture object. NOTE: only valid after first call to update() !
-    RefCntAutoPtr<ITexture> getTexture() { return texture_; }
+    /**
+     * Uploads only the rectangle of the image (data is the complete image), so that the cost scales with the changed
+     * area. With several buffers, the next texture gets the other pixels by a copy of the current texture on the GPU
+     * and becomes the current texture. The first image and NV12 and I420 images are always uploaded completely.
+     * Returns false if the size or texture format differs from the first image.
+     */
+    bool updateRegion(IRenderDevice* device, IDeviceContext* context, const ImageData& data, const Rect& rect);
+
+    /**
+     * Size of the tiles in pixels, in which update() compares the image with the previous one to upload only the
+     * changed tiles (e.g. for maps or overlays), 0 to upload complete images (default). Keeps a copy of the image.
+     * Not used for NV12 and I420 images.
+     */
+    void setChangeDetectionTileSize(std::uint32_t pixels) { change_tile_size_ = pixels; previous_.clear(); }
+    std::uint32_t getChangeDetectionTileSize() const { return change_tile_size_; }
+
+    /**
+     * Maps a staging texture for an image of the given size and format, which the producer fills in place (e.g.
+     * straight from a camera driver callback) and uploads with submit(), such that the image is copied only by the
+     * GPU. RGB8 images are mapped as RGBA8, NV12 and I420 images in the layout of the texture (see update()).
+     * The data is nullptr if the size or texture format differs from the first image or the device does not support
+     * writable staging textures, update() must be used then.
+     */
+    MappedImage acquire(IRenderDevice* device, IDeviceContext* context,
+                        std::uint32_t width, std::uint32_t height, DataFormat format);
+
+    /// Unmaps the staging texture and copies it into its texture, which becomes the current texture
+    bool submit(IDeviceContext* context);
+
+    /// Format of the last image
+    DataFormat getFormat() const { return format_; }
+
+    /// Factor that normalizes the sampled grey values, 16 bit images contain 12 bit camera data
+    float getValueScale() const;
+
+    /// Returns the texture of the newest image. NOTE: only valid after first call to update() !
+    RefCntAutoPtr<ITexture> getTexture() const { return slots_.empty() ? RefCntAutoPtr<ITexture>() : slots_[current_].texture; }
+
+    /// Incremented whenever the current texture changes, which happens with every image if there are several buffers
+    std::uint64_t getVersion() const { return version_; }
+
+private:
+
+    bool updateImage(IRenderDevice* device, IDeviceContext* context, const ImageData& data);
+    bool updatePlanes(IRenderDevice* device, IDeviceContext* context, const ImageData& data);
+    bool updateChangedTiles(IRenderDevice* device, IDeviceContext* context, const ImageData& data);
+    std::size_t copyForward(IDeviceContext* context);
+    void uploadRegion(IDeviceContext* context, std::size_t slot, const ImageData& data, const Rect& rect);
+    void makeCurrent(std::size_t slot, DataFormat format);
+    static Rect clip(const ImageData& data, const Rect& rect);
+    void storePrevious(const ImageData& data, const Rect& rect);
+
+    bool createTexture(IRenderDevice* device, std::uint32_t width, std::uint32_t height, DataFormat format,
+                       TextureSubResData* data);
 
 private:
 
-    RefCntAutoPtr<ITexture> texture_;
-    std::vector<char> buffer_; // temporary buffer
+    struct Slot
+    {
+        RefCntAutoPtr<ITexture> texture;
+        RefCntAutoPtr<ITexture> staging;
+        std::uint64_t fence_value = 0; // of the last copy of the staging texture
+    };
+
+    std::uint32_t buffer_count_ = 1;
+    std::vector<Slot> slots_;
+    std::size_t current_ = 0;     // slot of the newest image
+    int mapped_slot_ = -1;
+    std::uint64_t version_ = 0;
+
+    DataFormat format_ = RGBA8;
+    std::vector<char> buffer_; // temporary buffer for RGB8 images, if there are no staging textures
+
+    RefCntAutoPtr<IFence> staging_fence_; // signaled when the GPU copied a staging texture
+    std::uint64_t staging_fence_value_ = 0;
+    bool staging_failed_ = false;
+
+    std::uint32_t change_tile_size_ = 0;
+    std::vector<std::uint8_t> previous_; // tightly packed rows of the image in the texture, for the change detection
+    ImageData previous_desc_ = {};       // size and format of previous_
 };
 
 
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include <dg/core/common.hpp>
+#include <dg/core/mapped_file.hpp>
+#include <DiligentCore/Common/interface/RefCntAutoPtr.hpp>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Texture.h>
+
+namespace dg {
+
+/**
+ * Texture in the KTX 1.0 or KTX 2.0 container format, that is memory mapped for reading.
+ *
+ * The subresources (all mip levels, array layers and cube faces) point directly into the mapped file, so that the
+ * texture is created from the pages of the file without any copies. Block compressed formats (BC1 - BC7) are
+ * uploaded as they are. Zstd supercompressed KTX 2.0 levels are decompressed into memory, this requires that the
+ * library is built with Zstd (DG_WITH_ZSTD), otherwise opening such files throws. Basis Universal and ZLIB
+ * supercompression are not supported.
+ */
+class KTXFile
+{
+public:
+    DG_PTR(KTXFile)
+
+    enum Supercompression
+    {
+        SUPERCOMPRESSION_NONE = 0,
+        SUPERCOMPRESSION_BASIS_LZ = 1,
+        SUPERCOMPRESSION_ZSTD = 2,
+        SUPERCOMPRESSION_ZLIB = 3,
+    };
+
+    /// Maps the file, throws if it cannot be opened or its format is not supported
+    static Ptr open(const std::string& filename);
+
+    /// Opens the file and creates an immutable shader resource texture from it
+    static RefCntAutoPtr<ITexture> load(IRenderDevice* device, const std::string& filename);
+
+    /// True if the file starts with the KTX 1.0 or 2.0 identifier
+    static bool isKTXFile(const std::string& filename);
+
+    /**
+     * Writes a KTX 2.0 file without supercompression, levels[mip] contains the tightly packed data of all slices
+     * of the mip level. The file has no data format descriptor, which is not needed by KTXFile.
+     */
+    static void write(const std::string& filename, const TextureDesc& desc,
+                      const std::vector<std::vector<std::uint8_t>>& levels);
+
+    /// Writes the KTX 2.0 file at the current position of the stream, the offsets are relative to it
+    static bool write(std::FILE* f, const TextureDesc& desc, const std::vector<std::vector<std::uint8_t>>& levels);
+
+    KTXFile(const std::string& filename);
+
+    /// Texture at the byte range of a mapped file (e.g. in an AssetPack), throws if it is not valid
+    KTXFile(MappedFile::ConstPtr file, std::size_t offset, std::size_t size);
+
+    KTXFile(const KTXFile&) = delete;
+    KTXFile& operator=(const KTXFile&) = delete;
+
+public:
+
+    /// Description of the texture with all mip levels, immutable usage and shader resource binding
+    const TextureDesc& getDesc() const { return desc_; }
+
+    std::uint32_t getVersion() const { return version_; }
+    Supercompression getSupercompression() const { return supercompression_; }
+
+    /// Number of array slices of the subresources (array layers times faces, 1 for 3D textures)
+    std::uint32_t getSliceCount() const { return slice_count_; }
+
+    /**
+     * Reads all pages of the file into memory and decompresses supercompressed levels, so that the texture can
+     * be created without blocking on I/O. May be called on a worker thread, but not concurrently with other calls.
+     */
+    void prefetch();
+
+    /// Reads the pages of the mip levels [first_mip, first_mip+count) into memory, thread safe
+    void prefetchLevels(std::uint32_t first_mip, std::uint32_t count) const;
+
+    /**
+     * Subresources in the order of TextureData (mip + slice*mip_levels), that are valid as long as the file is open.
+     * Decompresses supercompressed levels if prefetch() was not called.
+     */
+    const std::vector<TextureSubResData>& getSubresources();
+
+    /// Size of the data of the mip level for all slices in bytes
+    std::size_t getLevelSize(std::uint32_t mip) const;
+
+    /**
+     * Creates the texture, skipping the first_mip most detailed levels (e.g. to limit the memory of large textures).
+     * The subresource data is copied by the device, the file may be closed afterwards.
+     */
+    RefCntAutoPtr<ITexture> createTexture(IRenderDevice* device, const std::string& name = "KTXFile",
+                                          std::uint32_t first_mip = 0);
+
+private:
+
+    void openKTX1();
+    void openKTX2();
+    void decompressLevels();
+
+private:
+    MappedFile::ConstPtr file_;
+    std::size_t offset_ = 0;
+    std::size_t size_ = 0;
+    const std::uint8_t* data_ = nullptr;
+
+    std::uint32_t version_ = 0;
+    Supercompression supercompression_ = SUPERCOMPRESSION_NONE;
+    TextureDesc desc_;
+    std::uint32_t slice_count_ = 1;
+
+    struct Level
+    {
+        std::uint64_t offset;   ///< in the file
+        std::uint64_t size;     ///< in the file
+        std::uint64_t uncompressed_size;
+    };
+    std::vector<Level> levels_;
+    std::vector<std::vector<std::uint8_t>> decompressed_;
+
+    std::vector<TextureSubResData> subresources_;
+    bool subresources_valid_ = false;
+};
+
+}
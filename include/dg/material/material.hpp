@@ -9,6 +9,8 @@
 namespace dg {
 
 class SceneManager;
+class StreamedTexture;
+class DynamicTexture;
 
 class IMaterial
 {
@@ -23,6 +25,12 @@ public:
     virtual void bindSRB(IShaderResourceBinding* srb) = 0;
     virtual void prepareForRender(IDeviceContext* context) = 0;
 
+    /// Texture whose resolution the SceneManager requests for the renderables of the material, if any
+    virtual StreamedTexture* getStreamedTexture() const { return nullptr; }
+
+    /// Changes when the textures of the material are replaced, the SceneManager binds them again (see bindSRB())
+    virtual std::uint64_t getTextureVersion() const { return 0; }
+
 protected:
     friend class SceneManager;
     std::shared_ptr<ShaderProgram> shader_program_;
@@ -62,6 +70,10 @@ struct Diffuse
     Color color = Color(1.0f,1.0f,1.0f,1.0f);
     float opacity = 1;
     RefCntAutoPtr<ITexture> texture;
+    /// Used instead of texture if set, see TextureStreamer
+    std::shared_ptr<StreamedTexture> streamed_texture;
+    /// Used instead of texture if set, its current texture is bound (must outlive the material)
+    const DynamicTexture* dynamic_texture = nullptr;
 };
 
 
@@ -15,11 +15,37 @@ public:
 
     UnlitMaterial(IRenderDevice* device);
 
+    /**
+     * Interpretation of the channels of the texture, grey values are sRGB encoded like RGBA8 textures. The camera
+     * formats are raw images of DynamicTexture in its texture layout, which are decoded (with BT.601 limited range
+     * YUV) or demosaiced per pixel.
+     */
+    enum TextureChannels
+    {
+        TEXTURE_RGBA,
+        TEXTURE_GREY,       ///< grey value in the red channel (e.g. R8 or R16 images of DynamicTexture)
+        TEXTURE_GREY_ALPHA, ///< grey value in the red and alpha in the green channel
+        TEXTURE_NV12,
+        TEXTURE_I420,
+        TEXTURE_YUYV,
+        TEXTURE_BAYER_RGGB,
+        TEXTURE_BAYER_BGGR,
+        TEXTURE_BAYER_GRBG,
+        TEXTURE_BAYER_GBRG,
+    };
+
+    TextureChannels texture_channels = TEXTURE_RGBA;
+
+    /// Factor of the sampled grey values, e.g. to normalize 12 bit data in 16 bit textures
+    float texture_scale = 1.0f;
+
     virtual void initialize(IRenderDevice* device) override;
     virtual void setupPSODesc(PipelineStateDesc& desc) override;
     virtual void bindPSO(IPipelineState* pso) override;
     virtual void bindSRB(IShaderResourceBinding* srb) override;
     virtual void prepareForRender(IDeviceContext* context) override;
+    virtual StreamedTexture* getStreamedTexture() const override { return streamed_texture.get(); }
+    virtual std::uint64_t getTextureVersion() const override;
 
     void setBlendDesc(const RenderTargetBlendDesc& desc);
 
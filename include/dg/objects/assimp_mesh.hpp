@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <future>
+#include <functional>
 
 #include <dg/objects/manual_object.hpp>
 
@@ -17,8 +19,36 @@ public:
 
 public:
 
+    /// Loads the file synchronously, a pending loadAsync() is cancelled
     void load(const std::string& filename);
 
+    /// Called on the render thread when an asynchronous load has finished, error is empty on success
+    using LoadCallback = std::function<void(bool success, const std::string& error)>;
+
+    /**
+     * Loads the file in the background: the file is imported and the sections are converted, optimized and
+     * simplified on a worker thread, their GPU buffers are created in the following SceneManager::render() calls
+     * within the upload budget of the scene manager.
+     *
+     * The returned future becomes ready (or holds the exception of a failed import) and the callback is called
+     * after the last section was added, i.e. both happen on the render thread: do not wait for the future on the
+     * render thread. Calling load() or loadAsync() again, or destroying the mesh, cancels a pending load without
+     * calling the callback, the future then holds an exception.
+     */
+    std::shared_future<void> loadAsync(const std::string& filename, LoadCallback callback = LoadCallback());
+
+    /// True while an asynchronous load is pending
+    bool isLoading() const;
+
+    /**
+     * Configures the binary cache of the converted meshes (enabled by default). If the cache of a file is up to date
+     * (same file, modification time and mesh settings) it is memory mapped and uploaded directly, otherwise the
+     * file is imported and the cache is written. The cache is stored in the given directory or in the user cache
+     * directory (see MeshLoader::defaultCacheDirectory()), never next to the file. Failures to write the cache are
+     * ignored.
+     */
+    void setMeshCache(bool enable, const std::string& directory = std::string());
+
     void setOpacity(float opacity);
 
 private:
@@ -18,6 +18,9 @@ public:
     float getScale() const;
     void update(const dg::DynamicTexture::ImageData& data);
 
+    /// Buffers of the texture (see DynamicTexture::setBufferCount()), e.g. 3 for live video, before the first update()
+    void setBufferCount(std::uint32_t count) { texture_.setBufferCount(count); }
+
     virtual void render() override;
     virtual void setOpacity(float opacity) override;
     virtual Eigen::Vector2f getSize() const override { return size_; }
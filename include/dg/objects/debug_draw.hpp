@@ -0,0 +1,111 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <dg/core/frustum.hpp>
+#include <dg/material/color.hpp>
+#include <dg/scene/raw_renderable.hpp>
+
+namespace dg {
+
+class Camera;
+
+/**
+ * Immediate mode renderer for debug primitives (lines, points, boxes, spheres, axes, frustums).
+ *
+ * The primitives are collected in CPU side vertex arrays, which keep their capacity between frames, and are
+ * streamed into a dynamic vertex buffer when the object is rendered. Each DISCARD map of the dynamic buffer
+ * allocates a new region of the per-frame upload ring, hence no GPU buffers are created while drawing.
+ * All lines and all points are drawn with one draw call per buffer_vertices vertices each.
+ *
+ * The coordinates are given in the frame of the node the object is attached to. By default, all primitives
+ * are cleared after they were rendered (see setAutoClear()).
+ */
+class DebugDraw : public RawRenderable
+{
+public:
+    DG_PTR(DebugDraw)
+
+    static constexpr std::uint32_t DEFAULT_BUFFER_VERTICES = 1 << 20;
+
+    DebugDraw(SceneManager* manager, std::uint32_t buffer_vertices = DEFAULT_BUFFER_VERTICES);
+    virtual ~DebugDraw();
+
+public:
+
+    void line(const Vector3& p1, const Vector3& p2, const Color& color);
+    void lines(const Vector3* points, std::size_t num_points, const Color& color); // line list (pairs of points)
+    void polyline(const Vector3* points, std::size_t num_points, const Color& color, bool closed = false);
+
+    void point(const Vector3& p, const Color& color);
+    void points(const Vector3* points, std::size_t num_points, const Color& color);
+
+    /// Axis aligned box given by its minimum and maximum corner
+    void box(const Vector3& p_min, const Vector3& p_max, const Color& color);
+    /// Oriented box of the given size, centered at the origin of pose
+    void box(const Transform& pose, const Vector3& size, const Color& color);
+
+    /// Sphere drawn as three orthogonal circles
+    void sphere(const Vector3& center, Real radius, const Color& color, int num_segments = 32);
+    void circle(const Vector3& center, const Vector3& normal, Real radius, const Color& color, int num_segments = 32);
+
+    /// Coordinate axes of pose in red (x), green (y) and blue (z)
+    void axes(const Transform& pose, Real length = 1.0);
+
+    /// Frustum of a camera with the given pose (looking along -z)
+    void frustum(const Transform& pose, const Frustum& frustum, const Color& color);
+    void frustum(const Camera& camera, const Color& color);
+
+    /// Removes all primitives (but keeps the allocated memory)
+    void clear();
+
+    /// Preallocates memory for the given number of lines and points
+    void reserve(std::size_t num_lines, std::size_t num_points);
+
+    std::size_t getLineCount() const { return line_vertices_.size() / 2; }
+    std::size_t getPointCount() const { return point_vertices_.size(); }
+
+public:
+
+    /// If enabled (default), all primitives are removed after each render()
+    void setAutoClear(bool auto_clear) { auto_clear_ = auto_clear; }
+    bool getAutoClear() const { return auto_clear_; }
+
+    void setDepthTest(bool depth_test);
+    bool getDepthTest() const { return depth_test_; }
+
+public:
+
+    virtual void render(SceneManager* manager) override;
+
+private:
+
+    struct Vertex
+    {
+        float x, y, z;
+        std::uint32_t color;
+    };
+
+    static Vertex vertex(const Vector3& p, std::uint32_t color)
+    {
+        return Vertex{float(p.x()), float(p.y()), float(p.z()), color};
+    }
+
+    void draw(const std::vector<Vertex>& vertices, IPipelineState* pso, IShaderResourceBinding* srb);
+
+private:
+
+    SceneManager* manager_;
+
+    std::vector<Vertex> line_vertices_;
+    std::vector<Vertex> point_vertices_;
+
+    bool auto_clear_ = true;
+    bool depth_test_ = true;
+
+    struct Pimpl;
+    std::unique_ptr<Pimpl> d;
+};
+
+}
@@ -3,23 +3,46 @@
 #include <memory>
 
 #include <dg/scene/renderable.hpp>
+#include <dg/scene/mesh_buffers.hpp>
 
 #include <dg/geometry/geometry.hpp>
+#include <dg/geometry/vertex_format.hpp>
+#include <dg/geometry/mesh_optimizer.hpp>
 
 namespace dg {
 
+/**
+ * Renderable for a triangle mesh given by an IGeometry.
+ *
+ * The GPU buffers are obtained from the MeshCache of the SceneManager, hence several objects created from
+ * identical geometries share the same buffers. Use MeshCache::get<G>() together with the constructor taking
+ * the MeshBuffers to avoid building the geometry on the CPU when the mesh is in the cache already.
+ */
 class GeometryObject : public Renderable
 {
 
 public:
 
-    GeometryObject(SceneManager* manager, const IGeometry& geometry, const std::vector<Color>& colors = std::vector<Color>());
+    GeometryObject(SceneManager* manager, const IGeometry& geometry, const std::vector<Color>& colors = std::vector<Color>(),
+                   const VertexFormat& format = VertexFormat(), MeshOptimization optimization = MeshOptimization_None);
+
+    GeometryObject(SceneManager* manager, MeshBuffers::ConstPtr mesh);
 
 public:
 
     void setMaterial(IMaterial::Ptr m);
     IMaterial::ConstPtr getMaterial() const { return material; }
 
+    MeshBuffers::ConstPtr getMesh() const { return mesh_; }
+
+private:
+
+    void setMesh(MeshBuffers::ConstPtr mesh);
+
+private:
+
+    MeshBuffers::ConstPtr mesh_;
+
 };
 
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <future>
+#include <functional>
 
 #include <dg/scene/raw_renderable.hpp>
 
@@ -23,9 +25,25 @@ public:
 
 public:
 
+    /// Sets the file, that is loaded in initialize() or the first render() call
     void load(const std::string& filename);
     void initialize(SceneManager* manager);
 
+    /// Called on the render thread when an asynchronous load has finished, error is empty on success
+    using LoadCallback = std::function<void(bool success, const std::string& error)>;
+
+    /**
+     * Loads the file in the background: the pages of the file and of the buffers and images it references are read
+     * into the page cache on a worker thread, the renderer and the model are created in two slices in the following
+     * SceneManager::render() calls. Only the I/O is hidden, the model is parsed and its images are decoded on the
+     * render thread, as GLTF::Model creates its GPU resources while it loads. The mesh is not drawn until then. The future becomes ready and the callback is called on the render thread,
+     * do not wait for the future on the render thread.
+     */
+    std::shared_future<void> loadAsync(SceneManager* manager, const std::string& filename, LoadCallback callback = LoadCallback());
+
+    /// True while an asynchronous load is pending
+    bool isLoading() const;
+
     void useLocalWorldFrame(bool use_local_frame=true);
 
     virtual void render(SceneManager* manager) override;
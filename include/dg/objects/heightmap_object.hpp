@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <dg/material/color.hpp>
+#include <dg/scene/raw_renderable.hpp>
+
+namespace dg {
+
+/**
+ * Renderable for large regular height grids, e.g. elevation maps.
+ *
+ * The heights are stored in a float texture and read in the vertex shader, the geometry is a small grid mesh per
+ * level of detail that is shared by all tiles of the map. The map is divided into square tiles of tile_size cells
+ * with individual bounds: tiles outside of the view frustum are skipped and the level of detail of each tile is
+ * selected from its distance to the camera, such that the cells are approximately lod_pixel_size pixels large on
+ * the screen. The visible tiles of each level are drawn with a single instanced draw call. The tiles have skirts
+ * to hide the cracks between tiles of different levels.
+ *
+ * The sample (i,j) of the grid is placed at (i*cell_size_x, j*cell_size_y, height) in the local coordinate system.
+ */
+class HeightmapObject : public RawRenderable
+{
+public:
+    DG_PTR(HeightmapObject)
+
+    static constexpr std::uint32_t DEFAULT_TILE_SIZE = 64;
+
+    /// The tile size (in cells) is rounded to a power of two between 4 and 128
+    HeightmapObject(SceneManager* manager, std::uint32_t tile_size = DEFAULT_TILE_SIZE);
+    virtual ~HeightmapObject();
+
+public:
+
+    /// Replaces the map by columns x rows samples, stride is the distance of the rows in floats (0 = columns)
+    void setHeights(const float* heights, std::uint32_t columns, std::uint32_t rows, std::size_t stride = 0);
+
+    /**
+     * Changes a region of the map, only the affected tiles are uploaded in the next render().
+     * The region must be inside of the map.
+     */
+    void updateHeights(std::uint32_t x, std::uint32_t y, std::uint32_t columns, std::uint32_t rows,
+                       const float* heights, std::size_t stride = 0);
+
+    float getHeight(std::uint32_t x, std::uint32_t y) const { return heights_[std::size_t(y)*columns_ + x]; }
+
+    std::uint32_t getColumns() const { return columns_; }
+    std::uint32_t getRows() const { return rows_; }
+
+    void setCellSize(float x, float y) { cell_size_ = Vector2f(x, y); }
+    const Vector2f& getCellSize() const { return cell_size_; }
+
+public:
+
+    void setColor(const Color& color) { color_ = color; }
+    const Color& getColor() const { return color_; }
+
+    /// Target size of the cells on the screen in pixels for the selection of the levels of detail
+    void setLodPixelSize(float pixels) { lod_pixel_size_ = pixels; }
+    float getLodPixelSize() const { return lod_pixel_size_; }
+
+    std::size_t getVisibleTileCount() const { return visible_tile_count_; }
+
+public:
+
+    virtual void render(SceneManager* manager) override;
+
+private:
+
+    struct Tile
+    {
+        float min_height;
+        float max_height;
+        bool  dirty;
+    };
+
+    void updateTileBounds(std::uint32_t tx, std::uint32_t ty);
+    void uploadDirtyTiles(SceneManager* manager);
+
+private:
+
+    SceneManager* manager_;
+
+    std::uint32_t tile_size_;
+    std::uint32_t lod_levels_;
+
+    std::vector<float> heights_;
+    std::uint32_t columns_ = 0;
+    std::uint32_t rows_ = 0;
+
+    std::vector<Tile> tiles_;
+    std::uint32_t tiles_x_ = 0;
+    std::uint32_t tiles_y_ = 0;
+    bool recreate_texture_ = false;
+    bool has_dirty_tiles_ = false;
+
+    Vector2f cell_size_ = Vector2f(1.0f, 1.0f);
+    Color color_ = Color(0.6f, 0.6f, 0.6f);
+    float lod_pixel_size_ = 4.0f;
+
+    std::size_t visible_tile_count_ = 0;
+
+    struct Pimpl;
+    std::unique_ptr<Pimpl> d;
+};
+
+}
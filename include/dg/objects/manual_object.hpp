@@ -1,9 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 
 #include <dg/scene/renderable.hpp>
 #include <dg/material/color.hpp>
+#include <dg/geometry/vertex_format.hpp>
+#include <dg/geometry/mesh_data.hpp>
+#include <dg/geometry/mesh_optimizer.hpp>
+#include <dg/geometry/mesh_simplifier.hpp>
+#include <dg/scene/mesh_buffers.hpp>
 
 namespace dg {
 
@@ -39,6 +45,52 @@ public:
         render_order_ = order;
     }
 
+    /// Sets the format of the vertex attributes for all sections that are started after this call
+    void setVertexFormat(const VertexFormat& format)
+    {
+        vertex_format_ = format;
+    }
+
+    const VertexFormat& getVertexFormat() const { return vertex_format_; }
+
+    /// Sets the optimizations that are applied to the sections in end() before they are uploaded (none by default)
+    void setMeshOptimization(MeshOptimization optimization)
+    {
+        mesh_optimization_ = optimization;
+    }
+
+    MeshOptimization getMeshOptimization() const { return mesh_optimization_; }
+
+    /**
+     * Enables the generation of levels of detail for the triangle list sections in end() (disabled by default).
+     * The SceneManager selects the level of each section from its projected size on the screen.
+     */
+    void setLodGeneration(bool enable, const LodOptions& options = LodOptions())
+    {
+        generate_lods_ = enable;
+        lod_options_ = options;
+    }
+
+    bool getLodGeneration() const { return generate_lods_; }
+    const LodOptions& getLodOptions() const { return lod_options_; }
+
+    /**
+     * Applies the mesh optimization and level of detail settings of this object to the mesh. This does not access
+     * the GPU, hence the meshes can be prepared on other threads (with settings captured by prepareFunction()).
+     */
+    void prepare(MeshData& data) const { prepareFunction()(data); }
+
+    /// Returns a function with a copy of the current settings, that prepares meshes like prepare()
+    std::function<void(MeshData&)> prepareFunction() const;
+
+    /// Uploads a prepared mesh and adds it as section
+    void addSection(IMaterial::Ptr material, const MeshData& data,
+                    const DepthStencilStateDesc& depth_stencil_desc = DepthStencilStateDesc());
+
+    /// Adds a section, that draws a mesh that was already uploaded
+    void addSection(IMaterial::Ptr material, MeshBuffers::ConstPtr mesh,
+                    const DepthStencilStateDesc& depth_stencil_desc = DepthStencilStateDesc());
+
 
 public:
 
@@ -61,6 +113,7 @@ protected:
 private:
 
     void addVertex();
+    void addSection(std::unique_ptr<Section> section, const MeshBuffers& mesh);
 
 private:
 
@@ -70,10 +123,15 @@ private:
     Sections sections_;
     std::unique_ptr<Section> current_section_;
 
-    std::size_t vertex_size_ = 0;
+    VertexFormat vertex_format_;
+    MeshOptimization mesh_optimization_ = MeshOptimization_None;
+    bool generate_lods_ = false;
+    LodOptions lod_options_;
+
+    std::size_t vertex_size_ = 0; // in bytes
     std::size_t vertex_count_ = 0;
-    float* buf_ptr_ = nullptr;
-    std::vector<float> buf_;
+    std::uint8_t* buf_ptr_ = nullptr;
+    std::vector<std::uint8_t> buf_;
 
     std::size_t index_count_ = 0;
     std::vector<std::uint32_t> idxbuf_;
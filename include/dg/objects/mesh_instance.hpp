@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <dg/scene/renderable.hpp>
+#include <dg/scene/mesh_manager.hpp>
+
+namespace dg {
+
+/**
+ * Lightweight instance of a SharedMesh of the MeshManager.
+ *
+ * The instance only creates a renderable per section, that refers to the shared GPU buffers, hence any number of
+ * instances of the same file can be attached to different nodes for the cost of a single import and upload.
+ * The materials can be overridden per instance, instances without material use the default material of the
+ * MeshManager.
+ */
+class MeshInstance : public Object
+{
+public:
+    DG_PTR(MeshInstance)
+
+    MeshInstance(SceneManager* manager, SharedMesh::Ptr mesh, IMaterial::Ptr material = IMaterial::Ptr());
+
+    /// Uses the mesh of the file from the MeshManager, which is loaded synchronously if necessary
+    MeshInstance(SceneManager* manager, const std::string& filename, IMaterial::Ptr material = IMaterial::Ptr());
+
+    virtual ~MeshInstance();
+
+public:
+
+    const SharedMesh::Ptr& getMesh() const { return mesh_; }
+
+    /// Sets the material of all sections, null restores the default material
+    void setMaterial(IMaterial::Ptr material);
+
+    /// Sets the material of a single section, null restores the default material
+    void setMaterial(std::size_t section, IMaterial::Ptr material);
+
+    IMaterial::Ptr getMaterial(std::size_t section) const { return sections_[section]->material; }
+
+    std::size_t getSectionCount() const { return sections_.size(); }
+
+    void setRenderOrder(RenderOrder order);
+
+protected:
+
+    virtual void onAttached(Node* node) override;
+    virtual void onDetached(Node* node) override;
+
+private:
+
+    struct Section : public Renderable
+    {
+    friend class MeshInstance;
+    };
+
+private:
+
+    SceneManager* manager_;
+    SharedMesh::Ptr mesh_;
+    std::vector<std::unique_ptr<Section>> sections_;
+};
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <dg/material/color.hpp>
+#include <dg/scene/raw_renderable.hpp>
+
+namespace dg {
+
+/**
+ * Renderable for large point clouds (e.g. lidar scans or depth images).
+ *
+ * The points are stored in GPU vertex buffers of a fixed number of points (chunks), which are allocated once and
+ * reused when the points are replaced, hence updating a whole scan per frame does not create any GPU resources.
+ * Each point has either a color or an intensity, that is mapped to a color by a colormap in the shader.
+ *
+ * The points are drawn as screen aligned squares or discs of a fixed size in pixels. The quads are expanded in
+ * the vertex shader from one instance per point, hence only the 16 bytes per point are uploaded.
+ * Chunks outside of the view frustum are skipped.
+ */
+class PointCloudObject : public RawRenderable
+{
+public:
+    DG_PTR(PointCloudObject)
+
+    static constexpr std::uint32_t DEFAULT_CHUNK_SIZE = 1 << 18;
+
+    PointCloudObject(SceneManager* manager, std::uint32_t chunk_size = DEFAULT_CHUNK_SIZE);
+    virtual ~PointCloudObject();
+
+public:
+
+    /// Replaces all points by points with the given colors (as packed by Color::toUInt32())
+    void setPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count);
+
+    /// Replaces all points by points with the given intensities, that are mapped by the colormap
+    void setPoints(const Vector3f* positions, const float* intensities, std::size_t count);
+
+    /// Replaces all points by points of the same color
+    void setPoints(const Vector3f* positions, std::size_t count, const Color& color);
+
+    /// Adds points to the existing ones, throws if the existing points have intensities instead of colors
+    void appendPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count);
+
+    /// Adds points to the existing ones, throws if the existing points have colors instead of intensities
+    void appendPoints(const Vector3f* positions, const float* intensities, std::size_t count);
+
+    /// Removes all points, the GPU buffers are kept for the next points unless release_memory is true
+    void clear(bool release_memory = false);
+
+    std::size_t getPointCount() const { return point_count_; }
+
+public:
+
+    enum class Colormap
+    {
+        Grayscale,
+        Turbo,
+        Viridis
+    };
+
+    /// Sets the colormap and the range of the intensities, that is mapped to the colormap
+    void setColormap(Colormap colormap, float min_intensity = 0.0f, float max_intensity = 1.0f);
+    Colormap getColormap() const { return colormap_; }
+
+    /// Size of the points in pixels
+    void setPointSize(float pixels) { point_size_ = pixels; }
+    float getPointSize() const { return point_size_; }
+
+    /// Draws discs instead of squares
+    void setRoundPoints(bool round) { round_points_ = round; }
+    bool getRoundPoints() const { return round_points_; }
+
+public:
+
+    virtual void render(SceneManager* manager) override;
+
+private:
+
+    struct Point
+    {
+        float x, y, z;
+        std::uint32_t attribute; // RGBA8 color or float intensity
+    };
+
+    enum class AttributeType
+    {
+        Color,
+        Intensity
+    };
+
+    template <typename Attribute>
+    void append(const Vector3f* positions, const Attribute* attributes, std::size_t count, AttributeType type);
+
+    void upload(std::size_t first, std::size_t count);
+
+private:
+
+    SceneManager* manager_;
+
+    std::uint32_t chunk_size_;
+    std::size_t point_count_ = 0;
+    AttributeType attribute_type_ = AttributeType::Color;
+
+    Colormap colormap_ = Colormap::Turbo;
+    float min_intensity_ = 0.0f;
+    float max_intensity_ = 1.0f;
+
+    float point_size_ = 2.0f;
+    bool round_points_ = false;
+
+    std::vector<Point> staging_;
+
+    struct Chunk;
+    struct Pimpl;
+    std::unique_ptr<Pimpl> d;
+};
+
+}
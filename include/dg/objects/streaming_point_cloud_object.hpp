@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <dg/geometry/point_cloud_octree.hpp>
+#include <dg/objects/point_cloud_object.hpp>
+#include <dg/scene/raw_renderable.hpp>
+
+namespace dg {
+
+/**
+ * Renderable for point clouds that do not fit in memory, that are streamed from a PointCloudOctree file.
+ *
+ * In each frame the octree is traversed from the root: nodes outside of the view frustum are skipped and the
+ * children of a node are visited while the spacing of its points projected to the screen exceeds the screen space
+ * error. Nodes that are not on the GPU are read by a background thread (from the memory mapped file), the nodes
+ * with the largest projected size first, and uploaded by the render thread. Nodes that were not drawn recently are
+ * evicted when the GPU memory budget would be exceeded.
+ *
+ * The points are drawn like the points of the PointCloudObject.
+ */
+class StreamingPointCloudObject : public RawRenderable
+{
+public:
+    DG_PTR(StreamingPointCloudObject)
+
+    using Colormap = PointCloudObject::Colormap;
+
+    StreamingPointCloudObject(SceneManager* manager, const std::string& filename);
+    StreamingPointCloudObject(SceneManager* manager, PointCloudOctree::Ptr octree);
+    virtual ~StreamingPointCloudObject();
+
+    const PointCloudOctree& getOctree() const { return *octree_; }
+
+public:
+
+    /// Maximum size of the point buffers on the GPU in bytes (512 MiB by default)
+    void setGpuMemoryBudget(std::size_t bytes) { gpu_memory_budget_ = bytes; }
+    std::size_t getGpuMemoryBudget() const { return gpu_memory_budget_; }
+
+    /// Nodes are refined until the spacing of their points on the screen is below this number of pixels
+    void setScreenSpaceError(float pixels) { screen_space_error_ = pixels; }
+    float getScreenSpaceError() const { return screen_space_error_; }
+
+    /// Maximum number of nodes that are uploaded to the GPU per frame
+    void setMaxUploadsPerFrame(std::uint32_t nodes) { max_uploads_per_frame_ = nodes; }
+    std::uint32_t getMaxUploadsPerFrame() const { return max_uploads_per_frame_; }
+
+    std::size_t getGpuMemoryUsage() const;
+    std::size_t getResidentNodeCount() const;
+    std::size_t getVisibleNodeCount() const { return visible_node_count_; }
+    std::uint64_t getVisiblePointCount() const { return visible_point_count_; }
+
+public:
+
+    /// Sets the colormap and the range of the intensities, if the points have intensities
+    void setColormap(Colormap colormap, float min_intensity = 0.0f, float max_intensity = 1.0f);
+    Colormap getColormap() const { return colormap_; }
+
+    /// Size of the points in pixels
+    void setPointSize(float pixels) { point_size_ = pixels; }
+    float getPointSize() const { return point_size_; }
+
+    /// Draws discs instead of squares
+    void setRoundPoints(bool round) { round_points_ = round; }
+    bool getRoundPoints() const { return round_points_; }
+
+public:
+
+    virtual void render(SceneManager* manager) override;
+
+private:
+
+    void upload(SceneManager* manager);
+    void traverse(SceneManager* manager);
+    void request();
+    bool makeRoom(std::size_t bytes);
+
+private:
+
+    SceneManager* manager_;
+    PointCloudOctree::Ptr octree_;
+
+    std::size_t gpu_memory_budget_ = std::size_t(512) << 20;
+    float screen_space_error_ = 2.0f;
+    std::uint32_t max_uploads_per_frame_ = 16;
+
+    Colormap colormap_ = Colormap::Turbo;
+    float min_intensity_ = 0.0f;
+    float max_intensity_ = 1.0f;
+
+    float point_size_ = 2.0f;
+    bool round_points_ = false;
+
+    std::size_t visible_node_count_ = 0;
+    std::uint64_t visible_point_count_ = 0;
+
+    struct Pimpl;
+    std::unique_ptr<Pimpl> d;
+};
+
+}
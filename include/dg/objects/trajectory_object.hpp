@@ -0,0 +1,95 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <dg/material/color.hpp>
+#include <dg/scene/raw_renderable.hpp>
+
+namespace dg {
+
+/**
+ * Renderable for polylines that grow by appending points, e.g. the trajectory of a robot.
+ *
+ * The points are stored in a GPU ring buffer. Appended points are uploaded once in the next render(), hence the
+ * cost of an append does not depend on the length of the line. Without a maximum number of points the buffer grows
+ * (the existing points are copied on the GPU), otherwise the oldest points are overwritten.
+ *
+ * The segments are drawn as screen aligned quads of a fixed width in pixels, that are expanded in the vertex shader.
+ */
+class TrajectoryObject : public RawRenderable
+{
+public:
+    DG_PTR(TrajectoryObject)
+
+    static constexpr std::uint32_t DEFAULT_CAPACITY = 1024;
+
+    /// A max_points of 0 keeps all points
+    TrajectoryObject(SceneManager* manager, std::uint32_t max_points = 0);
+    virtual ~TrajectoryObject();
+
+public:
+
+    /// Appends a point with the current color
+    void append(const Vector3& position);
+    void append(const Vector3& position, const Color& color);
+
+    /// Appends points with colors as packed by Color::toUInt32(), or the current color if colors is null
+    void append(const Vector3f* positions, const std::uint32_t* colors, std::size_t count);
+
+    /// Replaces all points
+    void setPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count);
+
+    /// Removes all points, the GPU buffer is kept
+    void clear();
+
+    std::size_t getPointCount() const;
+
+    /// Maximum number of points, older points are removed (0 = unlimited)
+    void setMaxPoints(std::uint32_t max_points) { max_points_ = max_points; }
+    std::uint32_t getMaxPoints() const { return max_points_; }
+
+public:
+
+    /// Color of points that are appended without a color
+    void setColor(const Color& color) { color_ = color.toUInt32(); }
+
+    /// Width of the line in pixels
+    void setLineWidth(float pixels) { line_width_ = pixels; }
+    float getLineWidth() const { return line_width_; }
+
+public:
+
+    virtual void render(SceneManager* manager) override;
+
+private:
+
+    struct Point
+    {
+        float x, y, z;
+        std::uint32_t color;
+    };
+
+    void update(SceneManager* manager);
+    void reallocate(SceneManager* manager, std::uint32_t capacity);
+    void draw(SceneManager* manager, std::uint32_t first_segment, std::uint32_t segment_count);
+
+private:
+
+    SceneManager* manager_;
+
+    std::uint32_t max_points_;
+    std::uint32_t capacity_ = 0; // of the ring buffer, in points
+    std::uint32_t start_ = 0;    // index of the oldest point in the ring buffer
+    std::uint32_t count_ = 0;    // number of points in the ring buffer
+
+    std::vector<Point> pending_; // appended points, that are uploaded in the next render()
+
+    std::uint32_t color_ = 0xFFFFFFFF;
+    float line_width_ = 2.0f;
+
+    struct Pimpl;
+    std::unique_ptr<Pimpl> d;
+};
+
+}
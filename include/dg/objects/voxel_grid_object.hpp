@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include <dg/material/color.hpp>
+#include <dg/scene/raw_renderable.hpp>
+
+namespace dg {
+
+/**
+ * Renderable for sparse voxel grids, e.g. occupancy maps.
+ *
+ * The voxels are stored in bricks of BRICK_SIZE^3 voxels, that only exist where voxels are occupied. For each brick
+ * the faces between occupied and free voxels (including the voxels of the neighboring bricks) are collected and
+ * uploaded to a GPU buffer of the brick, hidden faces between neighbors are not drawn. When voxels change, only
+ * the affected bricks (and their neighbors if the voxels are at the border) are updated in the next render().
+ *
+ * The faces are drawn as instanced quads, that are expanded in the vertex shader. Bricks outside of the view
+ * frustum are skipped.
+ *
+ * The voxel (x,y,z) occupies the cube from origin + (x,y,z)*voxel_size to origin + (x+1,y+1,z+1)*voxel_size.
+ * The coordinates must be in the range of 16 bit integers.
+ */
+class VoxelGridObject : public RawRenderable
+{
+public:
+    DG_PTR(VoxelGridObject)
+
+    static constexpr int BRICK_SIZE = 16;
+
+    VoxelGridObject(SceneManager* manager, float voxel_size = 1.0f);
+    virtual ~VoxelGridObject();
+
+public:
+
+    void setVoxel(int x, int y, int z, const Color& color) { setVoxel(x, y, z, color.toUInt32()); }
+
+    /// Marks the voxel as occupied with the color as packed by Color::toUInt32()
+    void setVoxel(int x, int y, int z, std::uint32_t color);
+
+    /// Marks the voxels as occupied with the given colors, or the current color if colors is null
+    void setVoxels(const Eigen::Vector3i* voxels, const std::uint32_t* colors, std::size_t count);
+
+    void clearVoxel(int x, int y, int z);
+    void clearVoxels(const Eigen::Vector3i* voxels, std::size_t count);
+
+    bool isOccupied(int x, int y, int z) const;
+
+    /// Removes all voxels
+    void clear();
+
+    std::size_t getVoxelCount() const { return voxel_count_; }
+    std::size_t getBrickCount() const { return bricks_.size(); }
+
+    /// Number of faces that are drawn if all bricks are visible
+    std::size_t getFaceCount() const { return face_count_; }
+
+public:
+
+    void setVoxelSize(float size) { voxel_size_ = size; }
+    float getVoxelSize() const { return voxel_size_; }
+
+    void setOrigin(const Vector3f& origin) { origin_ = origin; }
+    const Vector3f& getOrigin() const { return origin_; }
+
+    /// Color of voxels that are set without a color
+    void setColor(const Color& color) { color_ = color.toUInt32(); }
+
+public:
+
+    virtual void render(SceneManager* manager) override;
+
+private:
+
+    struct Brick;
+
+    static std::uint64_t brickKey(int bx, int by, int bz);
+
+    Brick* findBrick(int bx, int by, int bz);
+    const Brick* findBrick(int bx, int by, int bz) const;
+    void markDirty(int bx, int by, int bz, int lx, int ly, int lz);
+    void updateBrick(SceneManager* manager, Brick& brick);
+
+private:
+
+    SceneManager* manager_;
+
+    float voxel_size_;
+    Vector3f origin_ = Vector3f::Zero();
+    std::uint32_t color_ = 0xFFFFFFFF;
+
+    std::unordered_map<std::uint64_t, std::unique_ptr<Brick>> bricks_;
+    std::vector<Brick*> dirty_bricks_;
+
+    std::size_t voxel_count_ = 0;
+    std::size_t face_count_ = 0;
+
+    struct Pimpl;
+    std::unique_ptr<Pimpl> d;
+};
+
+}
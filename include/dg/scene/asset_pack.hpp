@@ -0,0 +1,141 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <functional>
+
+#include <dg/core/common.hpp>
+#include <dg/core/mapped_file.hpp>
+#include <dg/geometry/mesh_data.hpp>
+#include <dg/geometry/mesh_file.hpp>
+#include <dg/material/ktx_file.hpp>
+#include <dg/scene/mesh_buffers.hpp>
+
+namespace dg {
+
+class SceneManager;
+
+/**
+ * Archive of baked assets (see the dg-bake tool), that is memory mapped at runtime, so that the assets are uploaded
+ * directly from the pages of the file without any parsing or conversion.
+ *
+ * Each entry has a type and a name and is stored in the format of its loader: meshes as MeshFile (prepared vertices,
+ * indices and levels of detail), textures as KTXFile. An environment consists of the entries of the environment map
+ * and its prefiltered IBL cubemaps with the same name.
+ *
+ * File layout (little endian): Header | Entry[entry_count] | names | entries, each aligned to ALIGNMENT bytes
+ */
+class AssetPack
+{
+public:
+    DG_PTR(AssetPack)
+
+    enum EntryType
+    {
+        ENTRY_MESH = 1,
+        ENTRY_TEXTURE = 2,
+        ENTRY_ENVIRONMENT_MAP = 3,
+        ENTRY_IRRADIANCE_MAP = 4,  ///< diffuse IBL cubemap of an environment map
+        ENTRY_PREFILTERED_MAP = 5, ///< specular IBL cubemap of an environment map, the roughness increases with the mips
+    };
+
+    struct Header
+    {
+        char          magic[4];
+        std::uint32_t version;
+        std::uint32_t entry_count;
+        std::uint32_t reserved;
+        std::uint64_t names_offset;
+        std::uint64_t names_size;
+    };
+
+    struct Entry
+    {
+        std::uint32_t type;
+        std::uint32_t name_offset; ///< relative to the names
+        std::uint32_t name_size;
+        std::uint32_t reserved;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    static constexpr std::uint32_t VERSION = 1;
+
+    /// Alignment of the entries, a page, such that entries can be prefetched individually
+    static constexpr std::uint64_t ALIGNMENT = 4096;
+
+    /// Maps the file, throws if it cannot be opened or is not a valid asset pack of this version
+    static Ptr open(const std::string& filename);
+
+    AssetPack(const std::string& filename);
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+public:
+
+    const std::string& getFilename() const { return file_->getFilename(); }
+
+    std::size_t getEntryCount() const { return header_->entry_count; }
+    const Entry& getEntry(std::size_t i) const { return entries_[i]; }
+    std::string getEntryName(std::size_t i) const;
+
+    /// Index of the entry, -1 if there is none
+    int find(EntryType type, const std::string& name) const;
+
+    /// The entry must exist, the views keep the file mapped
+    MeshFile::Ptr getMeshFile(const std::string& name) const;
+    KTXFile::Ptr getTexture(const std::string& name, EntryType type = ENTRY_TEXTURE) const;
+
+    /// Uploads the meshes of the entry, must be called on the render thread
+    std::vector<MeshBuffers::Ptr> createMeshes(IRenderDevice* device, const std::string& name) const;
+
+    /// Sets the environment map of the scene manager together with its IBL cubemaps, if they are in the pack
+    void applyEnvironment(SceneManager* manager, const std::string& name) const;
+
+    /// Reads all pages of the file into memory (blocks until they are read)
+    void prefetch() const { file_->prefetch(); }
+
+public:
+
+    /// Collects entries and writes them as asset pack
+    class Writer
+    {
+    public:
+
+        void addMeshes(const std::string& name, std::vector<MeshData> meshes);
+
+        /// levels as for KTXFile::write()
+        void addTexture(EntryType type, const std::string& name, const TextureDesc& desc,
+                        std::vector<std::vector<std::uint8_t>> levels);
+
+        /// Copies a file that is already in the format of the entry (e.g. a KTX file) into the pack
+        void addFile(EntryType type, const std::string& name, const std::string& filename);
+
+        std::size_t getEntryCount() const { return items_.size(); }
+
+        /// Writes the pack via a temporary file, throws if it cannot be written
+        void write(const std::string& filename) const;
+
+    private:
+
+        struct Item
+        {
+            EntryType type;
+            std::string name;
+            std::function<bool(std::FILE*)> write;
+        };
+
+        std::vector<Item> items_;
+    };
+
+private:
+    MappedFile::ConstPtr file_;
+    const Header* header_ = nullptr;
+    const Entry* entries_ = nullptr;
+    const char* names_ = nullptr;
+};
+
+}
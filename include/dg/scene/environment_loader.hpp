@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <dg/core/common.hpp>
+
+#include <DiligentCore/Common/interface/RefCntAutoPtr.hpp>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Texture.h>
+
+namespace dg {
+
+class SceneManager;
+
+/**
+ * Loads environment maps on a worker thread and caches them together with their prefiltered IBL cubemaps on disk,
+ * so that later runs neither decode the image nor compute the cubemaps on the GPU again.
+ *
+ * The cache entries are keyed by the hash of the contents of the source file. Each entry is an AssetPack with the
+ * decoded environment map (unless the source is a KTX file, which is memory mapped directly) and the irradiance and
+ * prefiltered cubemaps, which are read back from the GPU after GLTFMesh computed them for the first time.
+ *
+ * Owned by SceneManager, must be used from the render thread.
+ *
+ * Example:
+ * \code
+ *   manager->getEnvironmentLoader().setCacheDirectory("/tmp/dg_cache");
+ *   manager->getEnvironmentLoader().loadAsync("papermill.ktx");
+ * \endcode
+ */
+class EnvironmentLoader
+{
+public:
+
+    EnvironmentLoader(SceneManager* manager);
+
+    EnvironmentLoader(const EnvironmentLoader&) = delete;
+    EnvironmentLoader& operator=(const EnvironmentLoader&) = delete;
+
+public:
+
+    /// Directory of the cache files, empty for defaultCacheDirectory() (default)
+    void setCacheDirectory(const std::string& directory) { cache_directory_ = directory; }
+    const std::string& getCacheDirectory() const { return cache_directory_; }
+
+    /**
+     * Directory of the cache files if none is set, $XDG_CACHE_HOME/diligent-graph/environments or
+     * $HOME/.cache/diligent-graph/environments. Empty (no cache) if neither variable is set. The cache is never
+     * written next to the environment maps, as asset directories are often shared or read-only.
+     */
+    static std::string defaultCacheDirectory();
+
+    /// Called on the render thread when the environment map is set, error is empty on success
+    using LoadCallback = std::function<void(const std::string& error)>;
+
+    /**
+     * Loads the environment map (a KTX file or an image that Diligent can load) on a worker thread and sets it as
+     * environment map of the scene manager, with its cached IBL cubemaps if there are any. A load that is still
+     * running is superseded.
+     */
+    void loadAsync(const std::string& filename, LoadCallback callback = LoadCallback());
+
+    /**
+     * Stores the IBL cubemaps that were computed for the current environment map of the scene manager in the cache,
+     * if it was loaded by loadAsync() and is not cached yet (called by GLTFMesh after computing them). The cubemaps
+     * are copied immediately, the cache file is written when the copies are ready.
+     */
+    void store(ITexture* irradiance_map, ITexture* prefiltered_map);
+
+private:
+
+    struct PendingLoad;
+    struct CacheEntry;
+
+    void finishLoad(const std::shared_ptr<PendingLoad>& load);
+
+private:
+    SceneManager* manager_;
+    std::string cache_directory_;
+    std::uint64_t load_count_ = 0;
+
+    // environment map that was loaded without cached cubemaps, with the data to write its cache entry
+    RefCntAutoPtr<ITexture> uncached_map_;
+    std::shared_ptr<CacheEntry> uncached_entry_;
+};
+
+}
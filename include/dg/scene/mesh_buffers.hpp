@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include <dg/core/common.hpp>
+#include <dg/geometry/mesh_data.hpp>
+#include <dg/scene/renderable.hpp>
+
+#include <DiligentCore/Common/interface/RefCntAutoPtr.hpp>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Buffer.h>
+
+namespace dg {
+
+/**
+ * Immutable GPU vertex and index buffers of a mesh together with their input layout.
+ * MeshBuffers can be shared by any number of renderables (see MeshCache), the buffers are released
+ * when the last reference is gone.
+ */
+struct MeshBuffers
+{
+    DG_PTR(MeshBuffers)
+
+    RefCntAutoPtr<IBuffer>     vertex_buffer;
+    RefCntAutoPtr<IBuffer>     index_buffer;
+    std::uint32_t              vertex_count = 0;
+    std::uint32_t              index_count = 0;
+    VALUE_TYPE                 index_type = VT_UINT32;
+    std::vector<LayoutElement> input_layout;
+    PRIMITIVE_TOPOLOGY         primitive_topology = PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+    Vector3f                   bounds_center = Vector3f::Zero();
+    float                      bounds_radius = 0.0f;
+
+    std::vector<Renderable::LodLevel> lods;
+
+    /**
+     * Uploads the given vertices and indices, 16 bit indices are used whenever they are sufficient.
+     * The bounding sphere is computed from the float32 positions (input index 0) if there are any.
+     */
+    static Ptr create(IRenderDevice* device, const std::string& name,
+                      const std::vector<LayoutElement>& input_layout, PRIMITIVE_TOPOLOGY topology,
+                      const void* vertices, std::uint32_t vertex_stride, std::uint32_t vertex_count,
+                      const std::uint32_t* indices, std::uint32_t index_count);
+
+    /// Uploads the mesh including its levels of detail
+    static Ptr create(IRenderDevice* device, const std::string& name, const MeshData& data);
+
+    /// Uploads an additional level of detail, that uses the vertex buffer of this mesh
+    void addLod(IRenderDevice* device, const std::string& name, const std::uint32_t* indices, std::uint32_t index_count, float error);
+
+    /// Assigns the buffers, layout, topology, bounds and levels of detail to the renderable
+    void applyTo(Renderable& r) const;
+
+    /// GPU memory used by the vertex and index buffer in bytes
+    std::size_t getSizeInBytes() const;
+};
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include <dg/core/fwds.hpp>
+#include <dg/core/hash.hpp>
+#include <dg/core/type_id.hpp>
+#include <dg/geometry/geometry.hpp>
+#include <dg/geometry/mesh_optimizer.hpp>
+#include <dg/geometry/vertex_format.hpp>
+#include <dg/scene/mesh_buffers.hpp>
+
+namespace dg {
+
+/**
+ * Cache of shared GPU meshes.
+ *
+ * Meshes are identified by a type and a hash, e.g. the geometry class and the hash of its Params, or
+ * type_id<IGeometry>() and the hash of the content for arbitrary geometries. The cache only keeps weak
+ * references, hence a mesh is released as soon as the last renderable that uses it is destroyed.
+ * All methods are thread safe.
+ *
+ * Example:
+ * \code
+ *   MeshBuffers::Ptr mesh = manager->getMeshCache().get<SphereGeometry>(manager->device(), SphereGeometry::Params(0.5f));
+ *   GeometryObject sphere(manager, mesh);
+ * \endcode
+ */
+class MeshCache
+{
+public:
+
+    /**
+     * Returns the mesh of the geometry G with the given parameters.
+     * The geometry is built and uploaded only if it is not in the cache yet.
+     * G must be constructible from its Params and dg::hash must be specialized for G::Params.
+     */
+    template <typename G>
+    MeshBuffers::Ptr get(IRenderDevice* device, const typename G::Params& params,
+                         const std::vector<Color>& colors = std::vector<Color>(), const VertexFormat& format = VertexFormat(),
+                         MeshOptimization optimization = MeshOptimization_None)
+    {
+        std::size_t key_hash = hash_value(params);
+        hash_combine(key_hash, hashOptions(colors, format, optimization));
+
+        // the parameters are compared byte by byte, in case of a collision of the hashes
+        static_assert(std::is_trivially_copyable<typename G::Params>::value, "G::Params must be trivially copyable");
+        Signature signature = optionsSignature(colors, format, optimization);
+        signature.byte_size = sizeof(params);
+        signature.params.assign(reinterpret_cast<const std::uint8_t*>(&params),
+                                reinterpret_cast<const std::uint8_t*>(&params) + sizeof(params));
+
+        MeshBuffers::Ptr mesh = find(type_id<G>(), key_hash, signature);
+        if(mesh)
+            return mesh;
+
+        G geometry(params);
+        return insert(type_id<G>(), key_hash, signature, create(device, geometry, colors, format, optimization));
+    }
+
+    /// Returns the mesh of an arbitrary geometry, which is identified by the hash of its content
+    MeshBuffers::Ptr get(IRenderDevice* device, const IGeometry& geometry,
+                         const std::vector<Color>& colors = std::vector<Color>(), const VertexFormat& format = VertexFormat(),
+                         MeshOptimization optimization = MeshOptimization_None);
+
+public:
+
+    /**
+     * Describes the source of a mesh beyond the hash of its key, so that meshes whose keys collide are not mixed up:
+     * the vertex and index count and the size of the source data, a second hash of the content with a different seed
+     * and the parameters of the geometry, if any.
+     */
+    struct Signature
+    {
+        std::uint64_t vertex_count = 0;
+        std::uint64_t index_count = 0;
+        std::uint64_t byte_size = 0;
+        std::size_t content_hash = 0;
+        std::vector<std::uint8_t> params;
+
+        bool operator==(const Signature& other) const
+        {
+            return vertex_count == other.vertex_count && index_count == other.index_count &&
+                   byte_size == other.byte_size && content_hash == other.content_hash && params == other.params;
+        }
+    };
+
+    /// Returns the mesh with the given key or nullptr if it is not in the cache (anymore) or its signature differs
+    MeshBuffers::Ptr find(TypeId type, std::size_t key_hash, const Signature& signature);
+
+    /**
+     * Adds the mesh with the given key. If another thread added a mesh with the same key and signature in the
+     * meantime, that mesh is returned instead, otherwise the given mesh is returned. A mesh whose key collides with
+     * a mesh in use with another signature is not cached.
+     */
+    MeshBuffers::Ptr insert(TypeId type, std::size_t key_hash, const Signature& signature, MeshBuffers::Ptr mesh);
+
+    /// Number of meshes in the cache that are still in use
+    std::size_t size() const;
+
+    /// Removes the entries of meshes that are not used anymore
+    void purge();
+
+private:
+
+    static MeshBuffers::Ptr create(IRenderDevice* device, const IGeometry& geometry,
+                                   const std::vector<Color>& colors, const VertexFormat& format, MeshOptimization optimization);
+
+    static std::size_t hashOptions(const std::vector<Color>& colors, const VertexFormat& format, MeshOptimization optimization);
+    static Signature optionsSignature(const std::vector<Color>& colors, const VertexFormat& format, MeshOptimization optimization);
+
+    void purgeLocked();
+
+private:
+
+    using Key = std::pair<TypeId, std::size_t>;
+
+    struct Entry
+    {
+        MeshBuffers::WeakPtr mesh;
+        Signature signature;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<Key, Entry> meshes_;
+    std::size_t inserts_since_purge_ = 0;
+};
+
+}
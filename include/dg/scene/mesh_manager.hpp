@@ -0,0 +1,112 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <future>
+#include <functional>
+
+#include <dg/core/fwds.hpp>
+#include <dg/material/material.hpp>
+#include <dg/scene/asset_pack.hpp>
+#include <dg/scene/mesh_buffers.hpp>
+#include <dg/internal/mesh_loader.hpp>
+
+namespace dg {
+
+class SceneManager;
+
+/// Sections of a mesh file, that were uploaded once and are shared by all MeshInstances of the file
+struct SharedMesh
+{
+    DG_PTR(SharedMesh)
+
+    std::string                        filename;
+    std::vector<MeshBuffers::ConstPtr> sections;
+
+    /// GPU memory used by the sections in bytes
+    std::size_t getSizeInBytes() const;
+};
+
+/**
+ * Loads mesh files (with the same pipeline and cache as AssimpMesh) and shares them between MeshInstances.
+ *
+ * The meshes are identified by their resource key, which is the canonical path of the file, hence each file is
+ * imported and uploaded only once, no matter how many instances use it. The manager only keeps weak references,
+ * a mesh is released as soon as the last instance (or other user) is destroyed. Must be used from the render thread.
+ *
+ * Example:
+ * \code
+ *   SharedMesh::Ptr mesh = manager->getMeshManager().load("robot.dae");
+ *   for(int i=0; i<200; ++i)
+ *       nodes[i]->attach(new MeshInstance(manager, mesh));
+ * \endcode
+ */
+class MeshManager
+{
+public:
+
+    MeshManager(SceneManager* manager);
+    ~MeshManager();
+
+    MeshManager(const MeshManager&) = delete;
+    MeshManager& operator=(const MeshManager&) = delete;
+
+public:
+
+    /// Settings of the conversion, they only apply to meshes that are loaded afterwards
+    void setLoadSettings(const MeshLoadSettings& settings) { settings_ = settings; }
+    const MeshLoadSettings& getLoadSettings() const { return settings_; }
+
+    /// Returns the mesh of the file, which is loaded synchronously if it is not loaded yet
+    SharedMesh::Ptr load(const std::string& filename);
+
+    /// Returns the mesh entry of the asset pack, which is uploaded directly from the mapped pack
+    SharedMesh::Ptr load(const AssetPack& pack, const std::string& name);
+
+    /// Called on the render thread when an asynchronous load has finished, mesh is null if it failed
+    using LoadCallback = std::function<void(SharedMesh::Ptr mesh, const std::string& error)>;
+
+    /**
+     * Returns the mesh of the file asynchronously like AssimpMesh::loadAsync(). Requests for a file, that is
+     * already loading, share the pending load. The future becomes ready on the render thread, do not wait for
+     * it there.
+     */
+    std::shared_future<SharedMesh::Ptr> loadAsync(const std::string& filename, LoadCallback callback = LoadCallback());
+
+    /// Returns the mesh of the file if it is loaded and still in use, nullptr otherwise
+    SharedMesh::Ptr find(const std::string& filename);
+
+    /// Number of meshes that are still in use
+    std::size_t size() const;
+
+    /// Removes the entries of meshes that are not used anymore
+    void purge();
+
+    /// Material of instances without an own material, shared by all of them
+    IMaterial::Ptr getDefaultMaterial();
+
+private:
+
+    struct PendingLoad;
+
+    static std::string resourceKey(const std::string& filename);
+
+    SharedMesh::Ptr insert(const std::string& key, SharedMesh::Ptr mesh);
+
+    // render task of an asynchronous load, returns true when done
+    bool uploadSections(PendingLoad& load);
+
+private:
+
+    SceneManager* manager_;
+    MeshLoadSettings settings_;
+
+    std::map<std::string, SharedMesh::WeakPtr> meshes_;
+    std::map<std::string, std::shared_ptr<PendingLoad>> pending_;
+
+    IMaterial::Ptr default_material_;
+};
+
+}
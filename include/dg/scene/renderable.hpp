@@ -50,14 +50,29 @@ public:
     RefCntAutoPtr<IBuffer>     vertex_buffer;
     RefCntAutoPtr<IBuffer>     index_buffer;
     std::uint32_t              index_count = 0;
+    VALUE_TYPE                 index_type = VT_UINT32;
     std::vector<LayoutElement> input_layout;
     PRIMITIVE_TOPOLOGY         primitive_topology = PRIMITIVE_TOPOLOGY_UNDEFINED;
 
+    // bounding sphere in the local frame, a radius of 0 means unknown bounds
+    Vector3f                   bounds_center = Vector3f::Zero();
+    float                      bounds_radius = 0.0f;
+
+    // optional coarser levels of detail, that use the vertex_buffer with their own index buffers
+    struct LodLevel
+    {
+        RefCntAutoPtr<IBuffer> index_buffer;
+        std::uint32_t          index_count = 0;
+        float                  error = 0.0f; // deviation from the full resolution mesh in local units
+    };
+    std::vector<LodLevel>      lods; // ordered from fine to coarse
+
 private:
     // managed by SceneManager
     bool pso_needs_update_ = true;
     IPipelineState* pso_ = nullptr;
     RefCntAutoPtr<IShaderResourceBinding> srb_;
+    std::uint64_t texture_version_ = 0; // of the material textures bound to srb_
 };
 
 
@@ -1,16 +1,25 @@
 #pragma once
 
 #include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include "node.hpp"
 
 #include <dg/core/fwds.hpp>
+#include <dg/core/worker_pool.hpp>
 
 #include <dg/material/color.hpp>
 #include <dg/scene/camera.hpp>
 #include <dg/scene/node.hpp>
 #include <dg/scene/render_order.hpp>
 
+#include <dg/scene/environment_loader.hpp>
+#include <dg/scene/mesh_cache.hpp>
+#include <dg/scene/mesh_manager.hpp>
+#include <dg/scene/texture_streamer.hpp>
+
 #include <dg/internal/pso_manager.hpp>
 
 #include <DiligentCore/Common/interface/RefCntAutoPtr.hpp>
@@ -20,6 +29,7 @@ namespace dg {
 class Renderable;
 class RawRenderable;
 class IMaterial;
+struct GLTFSharedRenderer;
 
 
 class SceneManager
@@ -66,6 +76,9 @@ public:
 
     void render();
 
+    /// Number of render() calls so far, e.g. to update shared per frame data only once per frame
+    std::uint64_t getFrameNumber() const { return frame_number_; }
+
 
     struct Matrices
     {
@@ -99,19 +112,86 @@ public:
 
     unsigned int requestStencilId() { return next_free_stencil_id_++; }
 
+    /**
+     * Maximum error of the levels of detail of renderables in pixels (1 by default). The level of each renderable
+     * is selected from the projected size of its bounding sphere, the coarsest level whose error does not exceed
+     * this value on the screen is drawn. A value of 0 disables the levels of detail.
+     */
+    void setLodPixelError(float pixels) { lod_pixel_error_ = pixels; }
+    float getLodPixelError() const { return lod_pixel_error_; }
+
+    /// Cache of GPU meshes that are shared between renderables (e.g. GeometryObjects with identical geometry)
+    MeshCache& getMeshCache() { return mesh_cache_; }
+
+    /// Meshes loaded from files, that are shared by MeshInstances
+    MeshManager& getMeshManager() { return mesh_manager_; }
+
+    /// Textures whose mip levels are streamed according to their size on the screen
+    TextureStreamer& getTextureStreamer() { return texture_streamer_; }
+
+    /// Renderer shared by the GLTFMeshes, weak so that it is released with the last mesh. Render thread only.
+    std::weak_ptr<GLTFSharedRenderer>& getGLTFRenderer() { return gltf_renderer_; }
+
+public:
+
+    /**
+     * Adds a task, that is called at the beginning of each render() until it returns true. This is used to finish
+     * work on the render thread in slices, e.g. to create the GPU resources of asynchronously loaded meshes.
+     * Must be called from the render thread.
+     */
+    void addRenderTask(std::function<bool(SceneManager*)> task) { render_tasks_.push_back(std::move(task)); }
+
+    /**
+     * Number of bytes that the render tasks may upload to the GPU per frame (32 MiB by default). A task always
+     * uploads at least one resource per frame, hence large resources may exceed the budget.
+     */
+    void setUploadBudget(std::size_t bytes) { upload_budget_ = bytes; }
+    std::size_t getUploadBudget() const { return upload_budget_; }
+
+    /// Bytes of the upload budget that are left in the current frame
+    std::size_t getRemainingUploadBudget() const { return uploaded_in_frame_ < upload_budget_ ? upload_budget_ - uploaded_in_frame_ : 0; }
+
+    /// Reports bytes uploaded by a render task
+    void consumeUploadBudget(std::size_t bytes) { uploaded_in_frame_ += bytes; }
+
+    /// Threads of the background work of the asynchronous loaders, joined when the scene manager is destroyed
+    WorkerPool& getWorkerPool() { return worker_pool_; }
+
 public:
 
     void setEnvironmentMap(const std::string& filename);
+
+    /**
+     * Sets the environment map together with its IBL cubemaps (see AssetPack), which GLTFMesh uses instead of
+     * computing them, if they match the size and format of its renderer. Without them they are computed on the GPU.
+     */
+    void setEnvironmentMap(RefCntAutoPtr<ITexture> map,
+                           RefCntAutoPtr<ITexture> irradiance_map = RefCntAutoPtr<ITexture>(),
+                           RefCntAutoPtr<ITexture> prefiltered_map = RefCntAutoPtr<ITexture>());
+
     RefCntAutoPtr<ITexture> getEnvironmentMap() const;
 
+    /// Loads environment maps asynchronously and caches their IBL cubemaps
+    EnvironmentLoader& getEnvironmentLoader() { return environment_loader_; }
+    RefCntAutoPtr<ITexture> getIrradianceMap() const { return irradiance_map_; }
+    RefCntAutoPtr<ITexture> getPrefilteredEnvironmentMap() const { return prefiltered_map_; }
+
 private:
 
     void collectRenderables(Node* node);
+    Real pixelsPerUnit(const Renderable* r, const Matrices& matrices) const;
+    int selectLod(const Renderable* r, const Matrices& matrices) const;
     void clearRenderQueues();
+    void runRenderTasks();
 
 private:
 
     dg::PSOManager pso_manager_;
+    MeshCache mesh_cache_;
+    MeshManager mesh_manager_;
+    TextureStreamer texture_streamer_;
+    EnvironmentLoader environment_loader_;
+    std::weak_ptr<GLTFSharedRenderer> gltf_renderer_;
 
     IRenderDevice*  device_ = nullptr;
     IDeviceContext* context_ = nullptr;
@@ -136,8 +216,20 @@ private:
 
     unsigned int next_free_stencil_id_=10;
 
+    float lod_pixel_error_ = 1.0f;
+
+    std::uint64_t frame_number_ = 0;
+
+    std::vector<std::function<bool(SceneManager*)>> render_tasks_;
+    std::size_t upload_budget_ = 32 << 20;
+    std::size_t uploaded_in_frame_ = 0;
+
     RefCntAutoPtr<ITexture> environment_map_;
+    RefCntAutoPtr<ITexture> irradiance_map_;
+    RefCntAutoPtr<ITexture> prefiltered_map_;
 
+    // destroyed first, so that no task runs while the other members are destroyed
+    WorkerPool worker_pool_;
 
 };
 
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <dg/core/common.hpp>
+#include <dg/material/ktx_file.hpp>
+
+#include <DiligentCore/Common/interface/RefCntAutoPtr.hpp>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Texture.h>
+
+namespace dg {
+
+class SceneManager;
+
+/**
+ * Texture of a KTX file, of which only the mip levels that are needed for the current view are resident on the GPU.
+ *
+ * The texture is replaced by a texture with more or fewer mip levels when the TextureStreamer streams levels in or
+ * out, hence users must not keep the texture, but get it again when the version changes (UnlitMaterial does this
+ * via SceneManager).
+ */
+class StreamedTexture
+{
+public:
+    DG_PTR(StreamedTexture)
+
+    StreamedTexture(KTXFile::Ptr file, const std::string& name);
+
+    StreamedTexture(const StreamedTexture&) = delete;
+    StreamedTexture& operator=(const StreamedTexture&) = delete;
+
+public:
+
+    const std::string& getName() const { return name_; }
+    const KTXFile::Ptr& getFile() const { return file_; }
+
+    /// Texture with the resident mip levels
+    RefCntAutoPtr<ITexture> getTexture() const { return texture_; }
+
+    /// Incremented whenever the texture is replaced
+    std::uint64_t getVersion() const { return version_; }
+
+    /// Most detailed resident mip level of the file
+    std::uint32_t getResidentMip() const { return resident_mip_; }
+
+    /// GPU memory of the resident mip levels in bytes
+    std::size_t getResidentSize() const { return getSize(resident_mip_); }
+
+    /**
+     * Reports that the texture is drawn with a size of about pixels on the screen in the current frame (called by
+     * SceneManager for the materials of renderables). The maximum of all requests of a frame is used.
+     */
+    void requestResolution(float pixels, std::uint64_t frame);
+
+private:
+    friend class TextureStreamer;
+
+    std::size_t getSize(std::uint32_t first_mip) const;
+
+private:
+    KTXFile::Ptr file_;
+    std::string name_;
+
+    RefCntAutoPtr<ITexture> texture_;
+    std::uint64_t version_ = 0;
+    std::uint32_t resident_mip_ = 0;
+    std::uint32_t base_mip_ = 0; ///< always resident
+
+    float requested_pixels_ = 0.0f;
+    std::uint64_t request_frame_ = 0;
+
+    std::uint32_t target_mip_ = 0;
+
+    // first mip level whose pages were read by a prefetch task, prefetch_pending_ is set while one runs
+    std::atomic<std::uint32_t> prefetched_mip_;
+    std::atomic<bool> prefetch_pending_;
+};
+
+/**
+ * Streams the mip levels of textures in and out, such that each texture is resident at the resolution at which it is
+ * visible on the screen and the textures together fit into a GPU memory budget.
+ *
+ * Textures are created with their coarse mip levels only (up to getInitialSize() pixels). Each frame, the streamer
+ * selects the mip level of each texture from the resolution requested by the renderables and reduces the least
+ * recently used textures until the budget is met. More detailed levels are read from the memory mapped file on a
+ * worker thread and uploaded within the upload budget of the SceneManager, as the pages are read. Textures that are
+ * not drawn for a while fall back to their coarse levels.
+ *
+ * Owned by SceneManager, must be used from the render thread.
+ *
+ * Example:
+ * \code
+ *   material->streamed_texture = manager->getTextureStreamer().load("bricks.ktx2");
+ *   material->initialize(manager->device());
+ * \endcode
+ */
+class TextureStreamer
+{
+public:
+
+    TextureStreamer(SceneManager* manager);
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+public:
+
+    /// Opens the KTX file and creates its coarse mip levels, throws if it cannot be opened
+    StreamedTexture::Ptr load(const std::string& filename);
+
+    /// Streams a texture of an opened file (e.g. of an AssetPack)
+    StreamedTexture::Ptr load(KTXFile::Ptr file, const std::string& name);
+
+    /// GPU memory for all streamed textures in bytes (256 MiB by default), the coarse levels are always resident
+    void setMemoryBudget(std::size_t bytes) { memory_budget_ = bytes; }
+    std::size_t getMemoryBudget() const { return memory_budget_; }
+
+    /// Maximum size of the mip levels that are created on load and are always resident (64 by default)
+    void setInitialSize(std::uint32_t pixels) { initial_size_ = pixels; }
+    std::uint32_t getInitialSize() const { return initial_size_; }
+
+    /// GPU memory of the resident mip levels of all textures in bytes
+    std::size_t getResidentSize() const;
+
+    /// Selects the mip levels and streams them in and out, called by SceneManager::render()
+    void update();
+
+private:
+
+    void replaceTexture(StreamedTexture& texture, std::uint32_t first_mip);
+    void prefetch(const StreamedTexture::Ptr& texture, std::uint32_t first_mip);
+
+private:
+    SceneManager* manager_;
+    std::vector<StreamedTexture::WeakPtr> textures_;
+
+    std::size_t memory_budget_ = 256 << 20;
+    std::uint32_t initial_size_ = 64;
+};
+
+}
@@ -0,0 +1,32 @@
+#include <dg/core/cache_directory.hpp>
+
+#include <sys/stat.h>
+
+#include <cstdlib>
+
+namespace dg {
+
+std::string userCacheDirectory(const std::string& name)
+{
+    const char* cache_home = std::getenv("XDG_CACHE_HOME");
+    if(cache_home && *cache_home)
+        return std::string(cache_home) + "/diligent-graph/" + name;
+
+    const char* home = std::getenv("HOME");
+    if(home && *home)
+        return std::string(home) + "/.cache/diligent-graph/" + name;
+
+    return std::string();
+}
+
+void createDirectories(const std::string& directory)
+{
+    for(std::size_t slash = directory.find('/', 1); ; slash = directory.find('/', slash + 1))
+    {
+        ::mkdir(directory.substr(0, slash).c_str(), 0755);
+        if(slash == std::string::npos)
+            break;
+    }
+}
+
+}
@@ -64,4 +64,29 @@ Eigen::Matrix4f Frustum::computeProjectionMatrix() const
     return proj_mat;
 }
 
+// the planes are extracted from the clip space (Gribb and Hartmann)
+bool isBoxVisible(const Matrix4& view_proj, const Vector3f& min, const Vector3f& max)
+{
+    const Matrix4& m = view_proj;
+    Vector4 planes[5] =
+    {
+        m.row(3) + m.row(0), // left
+        m.row(3) - m.row(0), // right
+        m.row(3) + m.row(1), // bottom
+        m.row(3) - m.row(1), // top
+        m.row(3) + m.row(2)  // near (conservative for clip space depths in [0,w] and [-w,w])
+    };
+
+    for(const Vector4& p : planes)
+    {
+        // the corner of the box, that is farthest in direction of the plane normal
+        Vector3 c(p.x() >= 0 ? max.x() : min.x(),
+                  p.y() >= 0 ? max.y() : min.y(),
+                  p.z() >= 0 ? max.z() : min.z());
+        if(p.head<3>().dot(c) + p.w() < 0)
+            return false;
+    }
+    return true;
+}
+
 }
@@ -0,0 +1,61 @@
+#include <dg/core/mapped_file.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace dg {
+
+MappedFile::MappedFile(const std::string& filename) :
+    filename_(filename)
+{
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if(fd_ < 0)
+        DG_THROW("Cannot open file " + filename);
+
+    struct stat st;
+    if(fstat(fd_, &st) != 0 || st.st_size <= 0)
+    {
+        ::close(fd_);
+        DG_THROW("Cannot map empty file " + filename);
+    }
+
+    size_ = std::size_t(st.st_size);
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if(data == MAP_FAILED)
+    {
+        ::close(fd_);
+        DG_THROW("Cannot map file " + filename);
+    }
+
+    data_ = static_cast<const std::uint8_t*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<std::uint8_t*>(data_), size_);
+    ::close(fd_);
+}
+
+void MappedFile::prefetch(std::size_t offset, std::size_t size) const
+{
+    if(offset >= size_)
+        return;
+    size = std::min(size, size_ - offset);
+
+    // madvise needs a page aligned address
+    std::size_t page_size = std::size_t(sysconf(_SC_PAGESIZE));
+    std::size_t begin = offset / page_size * page_size;
+    madvise(const_cast<std::uint8_t*>(data_) + begin, offset + size - begin, MADV_WILLNEED);
+
+    // touch every page, so that it is read here and not during the upload
+    volatile std::uint8_t sum = 0;
+    for(std::size_t p = begin; p < offset + size; p += page_size)
+        sum += data_[p];
+    (void)sum;
+}
+
+}
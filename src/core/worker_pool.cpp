@@ -0,0 +1,131 @@
+#include <dg/core/worker_pool.hpp>
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <exception>
+
+namespace dg {
+
+WorkerPool::WorkerPool(std::size_t thread_count) :
+    thread_count_(thread_count > 0 ? thread_count : std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), 4))
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        tasks_.clear();
+    }
+    condition_.notify_all();
+
+    for(std::thread& thread : threads_)
+        thread.join();
+}
+
+void WorkerPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+
+        // another thread if all are busy, up to the thread count
+        if(threads_.size() < thread_count_ && idle_ < tasks_.size())
+            threads_.emplace_back(&WorkerPool::run, this);
+    }
+    condition_.notify_one();
+}
+
+void WorkerPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body)
+{
+    if(count == 0)
+        return;
+
+    // shared with the helper tasks, a helper that starts after all indices are taken returns without touching body
+    struct State
+    {
+        std::atomic<std::size_t> next;
+        std::atomic<bool> failed;
+        std::size_t count;
+        const std::function<void(std::size_t)>* body;
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::size_t finished = 0;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+    state->next = 0;
+    state->failed = false;
+    state->count = count;
+    state->body = &body;
+
+    auto work = [state]()
+    {
+        for(std::size_t i = state->next++; i < state->count; i = state->next++)
+        {
+            std::exception_ptr error;
+            if(!state->failed)
+            {
+                try
+                {
+                    (*state->body)(i);
+                }
+                catch(...)
+                {
+                    error = std::current_exception();
+                    state->failed = true;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if(error && !state->error)
+                state->error = error;
+            if(++state->finished == state->count)
+                state->condition.notify_all();
+        }
+    };
+
+    for(std::size_t i=1; i<std::min(count, thread_count_ + 1); ++i)
+        enqueue(work);
+    work();
+
+    // wait for the indices taken by the helpers
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&]() { return state->finished == state->count; });
+
+    if(state->error)
+        std::rethrow_exception(state->error);
+}
+
+void WorkerPool::run()
+{
+    for(;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++idle_;
+            condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            --idle_;
+            if(stop_)
+                return;
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        // the tasks report their errors through their shared state
+        try
+        {
+            task();
+        }
+        catch(...)
+        {
+        }
+    }
+}
+
+}
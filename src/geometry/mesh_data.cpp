@@ -0,0 +1,175 @@
+#include <dg/geometry/mesh_data.hpp>
+
+#include <dg/core/hash.hpp>
+
+#include <cstring>
+#include <algorithm>
+
+namespace dg {
+
+MeshData MeshData::fromGeometry(const IGeometry& geometry, const std::vector<Color>& colors, const VertexFormat& format)
+{
+    const std::vector<Vector3>& positions = geometry.getPositions();
+    const std::vector<Vector3>& normals = geometry.getNormals();
+    const std::vector<Vector2f>& uvs = geometry.getUVs();
+
+    MeshData data;
+
+    std::size_t vertex_count = std::max(positions.size(), normals.size());
+
+    if(!positions.empty())
+    {
+        if(positions.size()!=vertex_count)
+            DG_THROW("Number of positions does not match count of other items");
+
+        data.input_layout.push_back(format.positionElement());
+        data.vertex_stride += format.positionSize();
+    }
+
+    if(!normals.empty())
+    {
+        if(normals.size()!=vertex_count)
+            DG_THROW("Number of normals does not match count of other items");
+
+        data.input_layout.push_back(format.normalElement());
+        data.vertex_stride += format.normalSize();
+    }
+
+    if(!colors.empty())
+    {
+        if(colors.size()!=vertex_count)
+            DG_THROW("Number of colors does not match count of other items");
+
+        data.input_layout.push_back(format.colorElement());
+        data.vertex_stride += format.colorSize();
+    }
+
+    if(!uvs.empty())
+    {
+        if(uvs.size()!=vertex_count)
+            DG_THROW("Number of uv texture coordinates does not match count of other items");
+
+        data.input_layout.push_back(format.uvElement());
+        data.vertex_stride += format.uvSize();
+    }
+
+    data.vertex_count = static_cast<std::uint32_t>(vertex_count);
+    data.vertices.resize(data.vertex_stride*vertex_count);
+
+    std::uint8_t* ptr = data.vertices.data();
+    for(std::size_t i=0; i<vertex_count; ++i)
+    {
+        if(!positions.empty())
+            ptr = format.writePosition(ptr, positions[i].x(), positions[i].y(), positions[i].z());
+
+        if(!normals.empty())
+            ptr = format.writeNormal(ptr, normals[i].x(), normals[i].y(), normals[i].z());
+
+        if(!colors.empty())
+            ptr = format.writeColor(ptr, colors[i]);
+
+        if(!uvs.empty())
+            ptr = format.writeUV(ptr, uvs[i].x(), uvs[i].y());
+    }
+
+    data.indices = geometry.getIndices();
+    data.primitive_topology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    return data;
+}
+
+std::size_t MeshData::hash() const
+{
+    std::size_t seed = 0;
+    for(const LayoutElement& e : input_layout)
+    {
+        hash_combine(seed, e.InputIndex);
+        hash_combine(seed, e.NumComponents);
+        hash_combine(seed, e.ValueType);
+        hash_combine(seed, e.IsNormalized);
+    }
+    hash_combine(seed, vertex_stride);
+    hash_combine(seed, vertex_count);
+    hash_combine(seed, primitive_topology);
+    hash_combine(seed, hash_bytes(vertices.data(), vertices.size()));
+    hash_combine(seed, hash_bytes(indices.data(), indices.size()*sizeof(std::uint32_t)));
+    return seed;
+}
+
+const std::uint8_t* MeshData::positions() const
+{
+    int offset = findPositionOffset(input_layout);
+    if(offset < 0 || vertices.empty())
+        return nullptr;
+
+    return vertices.data() + offset;
+}
+
+bool computeBoundingSphere(const std::uint8_t* positions, std::size_t vertex_count, std::size_t position_stride,
+                           Vector3f& center, float& radius)
+{
+    if(!positions || vertex_count == 0)
+        return false;
+
+    auto position = [&](std::size_t i) {
+        float p[3];
+        std::memcpy(p, positions + i*position_stride, sizeof(p));
+        return Vector3f(p[0], p[1], p[2]);
+    };
+
+    // initial sphere through the point farthest from the first point and the point farthest from that one
+    Vector3f p0 = position(0);
+    Vector3f a = p0, b = p0;
+    float max_dist = 0.0f;
+    for(std::size_t i=0; i<vertex_count; ++i)
+    {
+        float d = (position(i)-p0).squaredNorm();
+        if(d > max_dist) { max_dist = d; a = position(i); }
+    }
+    max_dist = 0.0f;
+    for(std::size_t i=0; i<vertex_count; ++i)
+    {
+        float d = (position(i)-a).squaredNorm();
+        if(d > max_dist) { max_dist = d; b = position(i); }
+    }
+
+    center = 0.5f*(a+b);
+    radius = 0.5f*(b-a).norm();
+
+    // grow the sphere to include all points
+    for(std::size_t i=0; i<vertex_count; ++i)
+    {
+        Vector3f p = position(i);
+        float d = (p-center).norm();
+        if(d > radius)
+        {
+            float new_radius = 0.5f*(radius+d);
+            center += (p-center) * ((new_radius-radius)/d);
+            radius = new_radius;
+        }
+    }
+
+    return true;
+}
+
+std::size_t hashGeometry(const IGeometry& geometry)
+{
+    const std::vector<Vector3>& positions = geometry.getPositions();
+    const std::vector<Vector3>& normals = geometry.getNormals();
+    const std::vector<Vector2f>& uvs = geometry.getUVs();
+    const std::vector<std::uint32_t>& indices = geometry.getIndices();
+
+    // the sizes are hashed separately, so that e.g. missing normals and missing uvs result in different hashes
+    std::size_t seed = 0;
+    hash_combine(seed, positions.size());
+    hash_combine(seed, hash_bytes(positions.data(), positions.size()*sizeof(Vector3)));
+    hash_combine(seed, normals.size());
+    hash_combine(seed, hash_bytes(normals.data(), normals.size()*sizeof(Vector3)));
+    hash_combine(seed, uvs.size());
+    hash_combine(seed, hash_bytes(uvs.data(), uvs.size()*sizeof(Vector2f)));
+    hash_combine(seed, indices.size());
+    hash_combine(seed, hash_bytes(indices.data(), indices.size()*sizeof(std::uint32_t)));
+    return seed;
+}
+
+}
@@ -0,0 +1,232 @@
+#include <dg/geometry/mesh_file.hpp>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+namespace dg {
+
+static const char g_mesh_file_magic[4] = {'D','G','M','F'};
+
+static_assert(sizeof(MeshFile::Header) == 24, "unexpected mesh file header size");
+static_assert(sizeof(MeshFile::MeshHeader) == 32, "unexpected mesh header size");
+static_assert(sizeof(MeshFile::Element) == 36, "unexpected mesh file element size");
+static_assert(sizeof(MeshFile::Lod) == 8, "unexpected mesh file lod size");
+
+// makes the temporary file names unique per write, two threads may write the cache of the same source at once
+static std::atomic<unsigned int> g_tmp_counter(0);
+
+static std::uint64_t align4(std::uint64_t size)
+{
+    return (size + 3) & ~std::uint64_t(3);
+}
+
+// size of the data block of a mesh (elements, lods, vertices and indices)
+static std::uint64_t dataSize(const MeshFile::MeshHeader& mesh, std::uint64_t lod_index_count)
+{
+    return std::uint64_t(mesh.element_count)*sizeof(MeshFile::Element) +
+           std::uint64_t(mesh.lod_count)*sizeof(MeshFile::Lod) +
+           align4(std::uint64_t(mesh.vertex_stride)*mesh.vertex_count) +
+           (std::uint64_t(mesh.index_count) + lod_index_count)*sizeof(std::uint32_t);
+}
+
+
+MeshFile::Ptr MeshFile::open(const std::string& filename)
+{
+    return make(filename);
+}
+
+MeshFile::MeshFile(const std::string& filename) :
+    MeshFile(std::make_shared<MappedFile>(filename), 0, std::size_t(-1))
+{
+}
+
+MeshFile::MeshFile(MappedFile::ConstPtr file, std::size_t offset, std::size_t size) :
+    file_(std::move(file)), offset_(offset)
+{
+    if(offset_ > file_->size())
+        DG_THROW("Invalid mesh file " + file_->getFilename());
+
+    size_ = std::min(size, file_->size() - offset_);
+    data_ = file_->data() + offset_;
+    header_ = reinterpret_cast<const Header*>(data_);
+    meshes_ = reinterpret_cast<const MeshHeader*>(data_ + sizeof(Header));
+
+    bool valid = size_ >= sizeof(Header) &&
+                 std::memcmp(header_->magic, g_mesh_file_magic, sizeof(g_mesh_file_magic)) == 0 &&
+                 header_->version == VERSION &&
+                 sizeof(Header) + std::uint64_t(header_->mesh_count)*sizeof(MeshHeader) <= size_;
+
+    // the lod headers are needed for the size of the data block, hence the blocks are checked in two steps,
+    // the offsets and counts are read from the file, hence the lengths are compared to the remaining size
+    for(std::uint32_t i=0; valid && i<header_->mesh_count; ++i)
+    {
+        const MeshHeader& mesh = meshes_[i];
+        valid = mesh.offset % 4 == 0 && mesh.offset <= size_;
+        if(!valid)
+            break;
+
+        std::uint64_t available = size_ - mesh.offset;
+        std::uint64_t lods_size = std::uint64_t(mesh.element_count)*sizeof(Element) + std::uint64_t(mesh.lod_count)*sizeof(Lod);
+        valid = lods_size <= available;
+        if(!valid)
+            break;
+
+        const Lod* lods = reinterpret_cast<const Lod*>(data_ + mesh.offset + std::uint64_t(mesh.element_count)*sizeof(Element));
+        std::uint64_t lod_index_count = 0;
+        for(std::uint32_t l=0; valid && l<mesh.lod_count; ++l)
+        {
+            lod_index_count += lods[l].index_count;
+            valid = lod_index_count <= available / sizeof(std::uint32_t);
+        }
+
+        // with the vertices and indices bounded by the size, the sum in dataSize() cannot overflow
+        valid = valid && align4(std::uint64_t(mesh.vertex_stride)*mesh.vertex_count) <= available &&
+                dataSize(mesh, lod_index_count) <= available;
+    }
+
+    if(!valid)
+        DG_THROW("Invalid mesh file " + file_->getFilename());
+}
+
+MeshFile::MeshView MeshFile::getMesh(std::size_t i) const
+{
+    const MeshHeader& mesh = meshes_[i];
+    const std::uint8_t* ptr = data_ + mesh.offset;
+
+    MeshView view;
+    view.primitive_topology = static_cast<PRIMITIVE_TOPOLOGY>(mesh.primitive_topology);
+    view.vertex_stride = mesh.vertex_stride;
+    view.vertex_count = mesh.vertex_count;
+    view.index_count = mesh.index_count;
+
+    const Element* elements = reinterpret_cast<const Element*>(ptr);
+    for(std::uint32_t e=0; e<mesh.element_count; ++e)
+    {
+        LayoutElement element{elements[e].input_index, elements[e].buffer_slot, elements[e].num_components,
+                              static_cast<VALUE_TYPE>(elements[e].value_type), elements[e].is_normalized != 0,
+                              static_cast<INPUT_ELEMENT_FREQUENCY>(elements[e].frequency), elements[e].instance_step_rate};
+        element.RelativeOffset = elements[e].relative_offset;
+        element.Stride = elements[e].stride;
+        view.input_layout.push_back(element);
+    }
+    ptr += std::size_t(mesh.element_count)*sizeof(Element);
+
+    const Lod* lods = reinterpret_cast<const Lod*>(ptr);
+    ptr += std::size_t(mesh.lod_count)*sizeof(Lod);
+
+    view.vertices = ptr;
+    ptr += align4(std::uint64_t(mesh.vertex_stride)*mesh.vertex_count);
+
+    view.indices = reinterpret_cast<const std::uint32_t*>(ptr);
+    ptr += std::size_t(mesh.index_count)*sizeof(std::uint32_t);
+
+    for(std::uint32_t l=0; l<mesh.lod_count; ++l)
+    {
+        view.lods.push_back(MeshView::LodView{lods[l].index_count, reinterpret_cast<const std::uint32_t*>(ptr), lods[l].error});
+        ptr += std::size_t(lods[l].index_count)*sizeof(std::uint32_t);
+    }
+
+    return view;
+}
+
+std::size_t MeshFile::getMeshSize(std::size_t i) const
+{
+    MeshView view = getMesh(i);
+    std::size_t size = std::size_t(view.vertex_stride)*view.vertex_count + std::size_t(view.index_count)*sizeof(std::uint32_t);
+    for(const MeshView::LodView& lod : view.lods)
+        size += std::size_t(lod.index_count)*sizeof(std::uint32_t);
+    return size;
+}
+
+void MeshFile::prefetch() const
+{
+    file_->prefetch(offset_, size_);
+}
+
+bool MeshFile::write(std::FILE* f, std::uint64_t key, const std::vector<MeshData>& meshes)
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, g_mesh_file_magic, sizeof(g_mesh_file_magic));
+    header.version = VERSION;
+    header.key = key;
+    header.mesh_count = static_cast<std::uint32_t>(meshes.size());
+
+    std::vector<MeshHeader> mesh_headers(meshes.size());
+    std::uint64_t offset = sizeof(Header) + meshes.size()*sizeof(MeshHeader);
+    for(std::size_t i=0; i<meshes.size(); ++i)
+    {
+        const MeshData& data = meshes[i];
+        MeshHeader& mesh = mesh_headers[i];
+        std::memset(&mesh, 0, sizeof(mesh));
+        mesh.element_count = static_cast<std::uint32_t>(data.input_layout.size());
+        mesh.primitive_topology = data.primitive_topology;
+        mesh.vertex_stride = data.vertex_stride;
+        mesh.vertex_count = data.vertex_count;
+        mesh.index_count = static_cast<std::uint32_t>(data.indices.size());
+        mesh.lod_count = static_cast<std::uint32_t>(data.lods.size());
+        mesh.offset = offset;
+
+        std::uint64_t lod_index_count = 0;
+        for(const MeshLod& lod : data.lods)
+            lod_index_count += lod.indices.size();
+
+        offset += dataSize(mesh, lod_index_count);
+    }
+
+    const std::uint8_t padding[4] = {0, 0, 0, 0};
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              (mesh_headers.empty() || std::fwrite(mesh_headers.data(), sizeof(MeshHeader), mesh_headers.size(), f) == mesh_headers.size());
+
+    for(std::size_t i=0; ok && i<meshes.size(); ++i)
+    {
+        const MeshData& data = meshes[i];
+
+        for(const LayoutElement& e : data.input_layout)
+        {
+            Element element = {e.InputIndex, e.BufferSlot, e.NumComponents, std::uint32_t(e.ValueType),
+                               std::uint32_t(e.IsNormalized), e.RelativeOffset, e.Stride, std::uint32_t(e.Frequency),
+                               e.InstanceDataStepRate};
+            ok = ok && std::fwrite(&element, sizeof(element), 1, f) == 1;
+        }
+
+        for(const MeshLod& lod : data.lods)
+        {
+            Lod l = {static_cast<std::uint32_t>(lod.indices.size()), lod.error};
+            ok = ok && std::fwrite(&l, sizeof(l), 1, f) == 1;
+        }
+
+        std::size_t vertex_bytes = std::size_t(data.vertex_stride)*data.vertex_count;
+        ok = ok && std::fwrite(data.vertices.data(), 1, vertex_bytes, f) == vertex_bytes;
+        std::size_t pad = align4(vertex_bytes) - vertex_bytes;
+        ok = ok && std::fwrite(padding, 1, pad, f) == pad;
+
+        ok = ok && std::fwrite(data.indices.data(), sizeof(std::uint32_t), data.indices.size(), f) == data.indices.size();
+        for(const MeshLod& lod : data.lods)
+            ok = ok && std::fwrite(lod.indices.data(), sizeof(std::uint32_t), lod.indices.size(), f) == lod.indices.size();
+    }
+
+    return ok;
+}
+
+void MeshFile::write(const std::string& filename, std::uint64_t key, const std::vector<MeshData>& meshes)
+{
+    std::string tmp_filename = filename + ".tmp" + std::to_string(::getpid()) + "." + std::to_string(g_tmp_counter++);
+    std::FILE* f = std::fopen(tmp_filename.c_str(), "wb");
+    if(!f)
+        DG_THROW("Cannot create mesh file " + filename);
+
+    bool ok = write(f, key, meshes);
+
+    ok = std::fclose(f) == 0 && ok;
+    if(!ok || std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmp_filename.c_str());
+        DG_THROW("Cannot write mesh file " + filename);
+    }
+}
+
+}
@@ -0,0 +1,393 @@
+#include <dg/geometry/mesh_optimizer.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <numeric>
+#include <algorithm>
+
+namespace dg {
+
+namespace {
+
+// parameters of the vertex scoring function (see Forsyth)
+const int   kCacheSize         = 32;
+const float kCacheDecayPower   = 1.5f;
+const float kLastTriScore      = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+const int   kMaxValence        = 32;
+
+struct VertexScoreTable
+{
+    float cache[kCacheSize];
+    float valence[kMaxValence+1];
+
+    VertexScoreTable()
+    {
+        for(int i=0; i<kCacheSize; ++i)
+        {
+            if(i < 3)
+                cache[i] = kLastTriScore; // the vertices of the last triangle get a fixed score
+            else
+                cache[i] = std::pow(1.0f - float(i-3) / float(kCacheSize-3), kCacheDecayPower);
+        }
+
+        valence[0] = 0.0f;
+        for(int i=1; i<=kMaxValence; ++i)
+            valence[i] = kValenceBoostScale * std::pow(float(i), -kValenceBoostPower);
+    }
+
+    float score(int cache_pos, std::uint32_t remaining) const
+    {
+        // vertices without remaining triangles are irrelevant
+        if(remaining == 0)
+            return -1.0f;
+
+        float s = valence[std::min<std::uint32_t>(remaining, kMaxValence)];
+        if(cache_pos >= 0)
+            s += cache[cache_pos];
+        return s;
+    }
+};
+
+Vector3f readPosition(const std::uint8_t* positions, std::size_t stride, std::uint32_t v)
+{
+    float p[3];
+    std::memcpy(p, positions + v*stride, sizeof(p));
+    return Vector3f(p[0], p[1], p[2]);
+}
+
+
+void reorderForVertexCache(std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count)
+{
+    static const VertexScoreTable table;
+
+    const std::size_t tri_count = index_count / 3;
+    if(tri_count == 0)
+        return;
+
+    // triangles adjacent to each vertex (compressed rows), the first remaining[v] entries are not emitted yet
+    std::vector<std::uint32_t> remaining(vertex_count, 0);
+    for(std::size_t i=0; i<tri_count*3; ++i)
+        ++remaining[indices[i]];
+
+    std::vector<std::uint32_t> offsets(vertex_count+1, 0);
+    for(std::size_t v=0; v<vertex_count; ++v)
+        offsets[v+1] = offsets[v] + remaining[v];
+
+    std::vector<std::uint32_t> adjacency(tri_count*3);
+    {
+        std::vector<std::uint32_t> fill(offsets.begin(), offsets.end()-1);
+        for(std::size_t t=0; t<tri_count; ++t)
+            for(int k=0; k<3; ++k)
+                adjacency[fill[indices[3*t+k]]++] = static_cast<std::uint32_t>(t);
+    }
+
+    std::vector<int> cache_pos(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for(std::size_t v=0; v<vertex_count; ++v)
+        vertex_score[v] = table.score(-1, remaining[v]);
+
+    std::vector<float> tri_score(tri_count);
+    for(std::size_t t=0; t<tri_count; ++t)
+        tri_score[t] = vertex_score[indices[3*t]] + vertex_score[indices[3*t+1]] + vertex_score[indices[3*t+2]];
+
+    std::vector<bool> emitted(tri_count, false);
+    std::vector<std::uint32_t> output;
+    output.reserve(tri_count*3);
+
+    std::vector<std::uint32_t> cache, new_cache;
+    cache.reserve(kCacheSize+3);
+    new_cache.reserve(kCacheSize+3);
+
+    std::size_t best_tri = std::max_element(tri_score.begin(), tri_score.end()) - tri_score.begin();
+    std::size_t next_unemitted = 0;
+
+    for(std::size_t n=0; n<tri_count; ++n)
+    {
+        // no candidate in the cache: continue with the next triangle that was not emitted yet
+        if(best_tri == std::numeric_limits<std::size_t>::max())
+        {
+            while(emitted[next_unemitted])
+                ++next_unemitted;
+            best_tri = next_unemitted;
+        }
+
+        const std::uint32_t* tri = indices + 3*best_tri;
+        output.insert(output.end(), tri, tri+3);
+        emitted[best_tri] = true;
+
+        // remove the triangle from the adjacency of its vertices
+        for(int k=0; k<3; ++k)
+        {
+            std::uint32_t v = tri[k];
+            std::uint32_t* begin = adjacency.data() + offsets[v];
+            std::uint32_t* end = begin + remaining[v];
+            std::uint32_t* it = std::find(begin, end, static_cast<std::uint32_t>(best_tri));
+            std::swap(*it, *(end-1));
+            --remaining[v];
+        }
+
+        // move the vertices of the triangle to the front of the LRU cache
+        new_cache.assign(tri, tri+3);
+        for(std::uint32_t v : cache)
+            if(v!=tri[0] && v!=tri[1] && v!=tri[2])
+                new_cache.push_back(v);
+
+        // update the scores of all vertices whose cache position changed and propagate them to their triangles
+        for(std::size_t i=0; i<new_cache.size(); ++i)
+        {
+            std::uint32_t v = new_cache[i];
+            cache_pos[v] = i < std::size_t(kCacheSize) ? int(i) : -1;
+
+            float score = table.score(cache_pos[v], remaining[v]);
+            float delta = score - vertex_score[v];
+            vertex_score[v] = score;
+
+            const std::uint32_t* adj = adjacency.data() + offsets[v];
+            for(std::uint32_t j=0; j<remaining[v]; ++j)
+                tri_score[adj[j]] += delta;
+        }
+
+        if(new_cache.size() > std::size_t(kCacheSize))
+            new_cache.resize(kCacheSize);
+        std::swap(cache, new_cache);
+
+        // the next triangle is the best one among the triangles of the cached vertices
+        best_tri = std::numeric_limits<std::size_t>::max();
+        float best_score = -1.0f;
+        for(std::uint32_t v : cache)
+        {
+            const std::uint32_t* adj = adjacency.data() + offsets[v];
+            for(std::uint32_t j=0; j<remaining[v]; ++j)
+            {
+                if(tri_score[adj[j]] > best_score)
+                {
+                    best_score = tri_score[adj[j]];
+                    best_tri = adj[j];
+                }
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+
+void reorderForOverdraw(std::uint32_t* indices, std::size_t index_count,
+                     const std::uint8_t* positions, std::size_t vertex_count, std::size_t position_stride)
+{
+    const std::size_t tri_count = index_count / 3;
+    if(tri_count == 0)
+        return;
+
+    // split into clusters at the triangles that miss the (simulated) vertex cache with all their vertices,
+    // the order within the clusters is kept, hence their vertex cache efficiency is preserved
+    const std::uint32_t cache_size = 16;
+    std::vector<std::uint32_t> timestamps(vertex_count, 0);
+    std::uint32_t time = cache_size + 1;
+
+    std::vector<std::size_t> cluster_begin;
+    for(std::size_t t=0; t<tri_count; ++t)
+    {
+        int misses = 0;
+        for(int k=0; k<3; ++k)
+        {
+            std::uint32_t v = indices[3*t+k];
+            if(time - timestamps[v] > cache_size)
+            {
+                timestamps[v] = time++;
+                ++misses;
+            }
+        }
+
+        if(t==0 || misses==3)
+            cluster_begin.push_back(t);
+    }
+    cluster_begin.push_back(tri_count);
+
+    const std::size_t cluster_count = cluster_begin.size()-1;
+    if(cluster_count < 2)
+        return;
+
+    // area weighted centroids and normals of the clusters
+    std::vector<Vector3f> centroids(cluster_count, Vector3f::Zero());
+    std::vector<Vector3f> normals(cluster_count, Vector3f::Zero());
+    std::vector<float> areas(cluster_count, 0.0f);
+
+    Vector3f mesh_centroid = Vector3f::Zero();
+    float mesh_area = 0.0f;
+
+    for(std::size_t c=0; c<cluster_count; ++c)
+    {
+        for(std::size_t t=cluster_begin[c]; t<cluster_begin[c+1]; ++t)
+        {
+            Vector3f p0 = readPosition(positions, position_stride, indices[3*t]);
+            Vector3f p1 = readPosition(positions, position_stride, indices[3*t+1]);
+            Vector3f p2 = readPosition(positions, position_stride, indices[3*t+2]);
+
+            Vector3f n = (p1-p0).cross(p2-p0);
+            float area = n.norm();
+
+            centroids[c] += (p0+p1+p2) * (area / 3.0f);
+            normals[c] += n;
+            areas[c] += area;
+        }
+
+        mesh_centroid += centroids[c];
+        mesh_area += areas[c];
+
+        if(areas[c] > 0.0f)
+            centroids[c] /= areas[c];
+    }
+
+    if(mesh_area > 0.0f)
+        mesh_centroid /= mesh_area;
+
+    // clusters that face away from the center are likely to occlude the others, hence they are drawn first
+    std::vector<float> sort_key(cluster_count);
+    for(std::size_t c=0; c<cluster_count; ++c)
+    {
+        float len = normals[c].norm();
+        sort_key[c] = len > 0.0f ? (centroids[c] - mesh_centroid).dot(normals[c] / len) : 0.0f;
+    }
+
+    std::vector<std::size_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sort_key[a] > sort_key[b]; });
+
+    std::vector<std::uint32_t> output;
+    output.reserve(tri_count*3);
+    for(std::size_t c : order)
+        output.insert(output.end(), indices + 3*cluster_begin[c], indices + 3*cluster_begin[c+1]);
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+
+std::size_t reorderVertices(std::uint8_t* vertices, std::size_t vertex_count, std::size_t vertex_stride,
+                            std::uint32_t* indices, std::size_t index_count)
+{
+    const std::uint32_t unused = std::numeric_limits<std::uint32_t>::max();
+
+    std::vector<std::uint32_t> remap(vertex_count, unused);
+    std::uint32_t next = 0;
+
+    for(std::size_t i=0; i<index_count; ++i)
+    {
+        std::uint32_t& r = remap[indices[i]];
+        if(r == unused)
+            r = next++;
+        indices[i] = r;
+    }
+
+    std::vector<std::uint8_t> reordered(next*vertex_stride);
+    for(std::size_t v=0; v<vertex_count; ++v)
+        if(remap[v] != unused)
+            std::memcpy(reordered.data() + remap[v]*vertex_stride, vertices + v*vertex_stride, vertex_stride);
+
+    std::memcpy(vertices, reordered.data(), reordered.size());
+    return next;
+}
+
+}
+
+
+void checkIndices(const std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count)
+{
+    for(std::size_t i=0; i<index_count; ++i)
+        if(indices[i] >= vertex_count)
+            DG_THROW("Index " + std::to_string(indices[i]) + " out of range for " + std::to_string(vertex_count) + " vertices");
+}
+
+
+void optimizeVertexCache(std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count)
+{
+    checkIndices(indices, index_count, vertex_count);
+    reorderForVertexCache(indices, index_count, vertex_count);
+}
+
+void optimizeOverdraw(std::uint32_t* indices, std::size_t index_count,
+                      const std::uint8_t* positions, std::size_t vertex_count, std::size_t position_stride)
+{
+    checkIndices(indices, index_count, vertex_count);
+    reorderForOverdraw(indices, index_count, positions, vertex_count, position_stride);
+}
+
+std::size_t optimizeVertexFetch(std::uint8_t* vertices, std::size_t vertex_count, std::size_t vertex_stride,
+                                std::uint32_t* indices, std::size_t index_count)
+{
+    checkIndices(indices, index_count, vertex_count);
+    return reorderVertices(vertices, vertex_count, vertex_stride, indices, index_count);
+}
+
+
+std::size_t optimizeMesh(MeshOptimization optimization, PRIMITIVE_TOPOLOGY topology, const std::vector<LayoutElement>& layout,
+                         std::uint8_t* vertices, std::size_t vertex_count, std::size_t vertex_stride,
+                         std::uint32_t* indices, std::size_t index_count)
+{
+    if(index_count == 0)
+        return vertex_count;
+
+    checkIndices(indices, index_count, vertex_count);
+
+    if(topology == PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+    {
+        if(optimization & MeshOptimization_VertexCache)
+            reorderForVertexCache(indices, index_count, vertex_count);
+
+        if(optimization & MeshOptimization_Overdraw)
+        {
+            int position_offset = findPositionOffset(layout);
+            if(position_offset >= 0)
+                reorderForOverdraw(indices, index_count, vertices + position_offset, vertex_count, vertex_stride);
+        }
+    }
+
+    // the vertex order does not change the primitives, hence this works for all topologies
+    if(optimization & MeshOptimization_VertexFetch)
+        vertex_count = reorderVertices(vertices, vertex_count, vertex_stride, indices, index_count);
+
+    return vertex_count;
+}
+
+void optimizeMesh(MeshOptimization optimization, MeshData& data)
+{
+    data.vertex_count = static_cast<std::uint32_t>(
+        optimizeMesh(optimization, data.primitive_topology, data.input_layout,
+                     data.vertices.data(), data.vertex_count, data.vertex_stride,
+                     data.indices.data(), data.indices.size()));
+
+    data.vertices.resize(std::size_t(data.vertex_count)*data.vertex_stride);
+}
+
+
+float computeACMR(const std::uint32_t* indices, std::size_t index_count, std::size_t vertex_count, std::size_t cache_size)
+{
+    const std::size_t tri_count = index_count / 3;
+    if(tri_count == 0)
+        return 0.0f;
+
+    checkIndices(indices, tri_count*3, vertex_count);
+
+    // FIFO cache: a vertex is in the cache if less than cache_size vertices were transformed since it was transformed
+    std::vector<std::size_t> timestamps(vertex_count, 0);
+    std::size_t time = cache_size + 1;
+    std::size_t misses = 0;
+
+    for(std::size_t i=0; i<tri_count*3; ++i)
+    {
+        std::uint32_t v = indices[i];
+        if(time - timestamps[v] > cache_size)
+        {
+            timestamps[v] = time++;
+            ++misses;
+        }
+    }
+
+    return float(misses) / float(tri_count);
+}
+
+}
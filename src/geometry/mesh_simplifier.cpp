@@ -0,0 +1,283 @@
+#include <dg/geometry/mesh_simplifier.hpp>
+#include <dg/geometry/mesh_optimizer.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+namespace dg {
+
+namespace {
+
+// symmetric 4x4 matrix of the squared distances to a set of planes, weighted by the areas of the triangles
+struct Quadric
+{
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double          a11 = 0, a12 = 0, a13 = 0;
+    double                   a22 = 0, a23 = 0;
+    double                            a33 = 0;
+    double w = 0;
+
+    static Quadric fromPlane(const Vector3& n, double d, double weight)
+    {
+        Quadric q;
+        q.a00 = weight*n.x()*n.x(); q.a01 = weight*n.x()*n.y(); q.a02 = weight*n.x()*n.z(); q.a03 = weight*n.x()*d;
+        q.a11 = weight*n.y()*n.y(); q.a12 = weight*n.y()*n.z(); q.a13 = weight*n.y()*d;
+        q.a22 = weight*n.z()*n.z(); q.a23 = weight*n.z()*d;
+        q.a33 = weight*d*d;
+        q.w = weight;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& o)
+    {
+        a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+        a11 += o.a11; a12 += o.a12; a13 += o.a13;
+        a22 += o.a22; a23 += o.a23;
+        a33 += o.a33;
+        w += o.w;
+        return *this;
+    }
+
+    // mean squared distance of p to the planes
+    double error(const Vector3& p) const
+    {
+        const double x = p.x(), y = p.y(), z = p.z();
+        double e = a00*x*x + 2*a01*x*y + 2*a02*x*z + 2*a03*x
+                 + a11*y*y + 2*a12*y*z + 2*a13*y
+                 + a22*z*z + 2*a23*z
+                 + a33;
+        return w > 0 ? std::max(e, 0.0) / w : 0.0;
+    }
+};
+
+struct Collapse
+{
+    std::uint32_t from, to;
+    double cost;
+};
+
+std::uint64_t edgeKey(std::uint32_t a, std::uint32_t b)
+{
+    if(a > b)
+        std::swap(a, b);
+    return (std::uint64_t(a) << 32) | b;
+}
+
+}
+
+
+float simplifyMesh(std::vector<std::uint32_t>& indices, const std::uint8_t* positions, std::size_t vertex_count,
+                   std::size_t position_stride, std::size_t target_index_count, float max_error)
+{
+    checkIndices(indices.data(), indices.size(), vertex_count);
+
+    std::vector<Vector3> p(vertex_count);
+    for(std::size_t i=0; i<vertex_count; ++i)
+    {
+        float v[3];
+        std::memcpy(v, positions + i*position_stride, sizeof(v));
+        p[i] = Vector3(v[0], v[1], v[2]);
+    }
+
+    // vertices on borders (edges with a single triangle) are locked, this includes attribute seams,
+    // since split vertices are not connected in the index topology
+    std::vector<bool> locked(vertex_count, false);
+    {
+        std::unordered_map<std::uint64_t, int> edge_count;
+        edge_count.reserve(indices.size());
+        for(std::size_t i=0; i+2<indices.size(); i+=3)
+            for(int k=0; k<3; ++k)
+                ++edge_count[edgeKey(indices[i+k], indices[i+(k+1)%3])];
+
+        for(const auto& e : edge_count)
+        {
+            if(e.second == 1)
+            {
+                locked[e.first >> 32] = true;
+                locked[e.first & 0xffffffff] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count);
+    for(std::size_t i=0; i+2<indices.size(); i+=3)
+    {
+        const Vector3& p0 = p[indices[i]];
+        Vector3 n = (p[indices[i+1]]-p0).cross(p[indices[i+2]]-p0);
+        double area = n.norm();
+        if(area <= 0.0)
+            continue;
+        n /= area;
+
+        Quadric q = Quadric::fromPlane(n, -n.dot(p0), area);
+        for(int k=0; k<3; ++k)
+            quadrics[indices[i+k]] += q;
+    }
+
+    const double max_cost = double(max_error)*double(max_error);
+    double result_cost = 0.0;
+
+    std::vector<std::uint32_t> remap(vertex_count);
+    std::vector<bool> touched(vertex_count);
+    std::vector<std::uint32_t> offsets(vertex_count+1);
+    std::vector<std::uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    while(indices.size() > target_index_count)
+    {
+        const std::size_t tri_count = indices.size()/3;
+
+        // triangles adjacent to each vertex
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for(std::uint32_t v : indices)
+            ++offsets[v+1];
+        for(std::size_t v=0; v<vertex_count; ++v)
+            offsets[v+1] += offsets[v];
+        adjacency.resize(indices.size());
+        {
+            std::vector<std::uint32_t> fill(offsets.begin(), offsets.end()-1);
+            for(std::size_t t=0; t<tri_count; ++t)
+                for(int k=0; k<3; ++k)
+                    adjacency[fill[indices[3*t+k]]++] = static_cast<std::uint32_t>(t);
+        }
+
+        // candidate collapses of all edges in both directions, sorted by their cost
+        collapses.clear();
+        for(std::size_t t=0; t<tri_count; ++t)
+        {
+            for(int k=0; k<3; ++k)
+            {
+                std::uint32_t a = indices[3*t+k];
+                std::uint32_t b = indices[3*t+(k+1)%3];
+
+                Quadric q = quadrics[a];
+                q += quadrics[b];
+
+                if(!locked[a])
+                    collapses.push_back(Collapse{a, b, q.error(p[b])});
+                if(!locked[b])
+                    collapses.push_back(Collapse{b, a, q.error(p[a])});
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        // apply the cheapest collapses, each vertex is changed only once per pass
+        for(std::size_t v=0; v<vertex_count; ++v)
+            remap[v] = static_cast<std::uint32_t>(v);
+        std::fill(touched.begin(), touched.end(), false);
+
+        // an interior edge collapse removes two triangles
+        const std::size_t max_collapses = (indices.size() - target_index_count) / 6 + 1;
+        std::size_t num_collapses = 0;
+
+        for(const Collapse& c : collapses)
+        {
+            if(num_collapses >= max_collapses || c.cost > max_cost)
+                break;
+
+            if(touched[c.from] || touched[c.to])
+                continue;
+
+            // reject collapses that would flip triangles around the moved vertex
+            bool flips = false;
+            for(std::uint32_t j=offsets[c.from]; j<offsets[c.from+1] && !flips; ++j)
+            {
+                const std::uint32_t* tri = &indices[3*adjacency[j]];
+                if(tri[0]==c.to || tri[1]==c.to || tri[2]==c.to)
+                    continue;
+
+                Vector3 q[3] = {p[tri[0]], p[tri[1]], p[tri[2]]};
+                Vector3 n0 = (q[1]-q[0]).cross(q[2]-q[0]);
+                for(int k=0; k<3; ++k)
+                    if(tri[k]==c.from)
+                        q[k] = p[c.to];
+                Vector3 n1 = (q[1]-q[0]).cross(q[2]-q[0]);
+
+                if(n0.dot(n1) <= 0.25*n0.norm()*n1.norm())
+                    flips = true;
+            }
+            if(flips)
+                continue;
+
+            remap[c.from] = c.to;
+            quadrics[c.to] += quadrics[c.from];
+            result_cost = std::max(result_cost, c.cost);
+            ++num_collapses;
+
+            // the neighborhood of the collapsed vertex changed, hence it is locked for the rest of this pass
+            for(std::uint32_t j=offsets[c.from]; j<offsets[c.from+1]; ++j)
+            {
+                const std::uint32_t* tri = &indices[3*adjacency[j]];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+            }
+        }
+
+        if(num_collapses == 0)
+            break;
+
+        // remap the indices and remove the degenerated triangles
+        std::size_t out = 0;
+        for(std::size_t t=0; t<tri_count; ++t)
+        {
+            std::uint32_t a = remap[indices[3*t]], b = remap[indices[3*t+1]], c = remap[indices[3*t+2]];
+            if(a==b || b==c || a==c)
+                continue;
+
+            indices[out++] = a;
+            indices[out++] = b;
+            indices[out++] = c;
+        }
+        indices.resize(out);
+    }
+
+    return static_cast<float>(std::sqrt(result_cost));
+}
+
+
+std::vector<MeshLod> generateLods(const std::uint32_t* indices, std::size_t index_count, const std::uint8_t* positions,
+                                  std::size_t vertex_count, std::size_t position_stride, const LodOptions& options)
+{
+    std::vector<MeshLod> lods;
+    std::vector<std::uint32_t> lod_indices(indices, indices+index_count);
+    float error = 0.0f;
+
+    for(int level=0; level<options.max_levels; ++level)
+    {
+        if(lod_indices.size() < options.min_index_count)
+            break;
+
+        std::size_t target = std::size_t(lod_indices.size()/3 * options.reduction) * 3;
+        std::size_t prev_size = lod_indices.size();
+
+        // each level is simplified from the previous one, hence the errors add up
+        error += simplifyMesh(lod_indices, positions, vertex_count, position_stride, target);
+
+        // stop when the mesh cannot be simplified significantly anymore
+        if(lod_indices.size() > prev_size * 9 / 10)
+            break;
+
+        MeshLod lod;
+        lod.indices = lod_indices;
+        lod.error = error;
+        optimizeVertexCache(lod.indices.data(), lod.indices.size(), vertex_count);
+        lods.push_back(std::move(lod));
+    }
+
+    return lods;
+}
+
+void generateLods(MeshData& data, const LodOptions& options)
+{
+    data.lods.clear();
+
+    const std::uint8_t* positions = data.positions();
+    if(!positions || data.primitive_topology != PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+        return;
+
+    data.lods = generateLods(data.indices.data(), data.indices.size(), positions, data.vertex_count, data.vertex_stride, options);
+}
+
+}
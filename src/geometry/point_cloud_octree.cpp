@@ -0,0 +1,525 @@
+#include <dg/geometry/point_cloud_octree.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+
+namespace dg {
+
+static const char g_octree_magic[4] = {'D','G','P','C'};
+
+static_assert(sizeof(PointCloudOctree::Point) == 16, "unexpected point size");
+static_assert(sizeof(PointCloudOctree::Header) == 56, "unexpected octree header size");
+static_assert(sizeof(PointCloudOctree::Node) == 80, "unexpected octree node size");
+
+// nodes are not split below this level, e.g. if there are more than max_node_points identical points
+static constexpr std::uint32_t MAX_OCTREE_LEVEL = 24;
+
+
+PointCloudOctree::Ptr PointCloudOctree::open(const std::string& filename)
+{
+    return make(filename);
+}
+
+PointCloudOctree::PointCloudOctree(const std::string& filename)
+{
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if(fd_ < 0)
+        DG_THROW("Cannot open point cloud octree " + filename);
+
+    struct stat st;
+    if(fstat(fd_, &st) != 0 || std::size_t(st.st_size) < sizeof(Header))
+    {
+        ::close(fd_);
+        DG_THROW("Invalid point cloud octree " + filename);
+    }
+
+    size_ = std::size_t(st.st_size);
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if(data == MAP_FAILED)
+    {
+        ::close(fd_);
+        DG_THROW("Cannot map point cloud octree " + filename);
+    }
+
+    // nodes are loaded in the order of their screen space error, not sequentially
+    madvise(data, size_, MADV_RANDOM);
+
+    data_ = static_cast<const std::uint8_t*>(data);
+    header_ = reinterpret_cast<const Header*>(data_);
+
+    // the ranges are checked without sums of values from the file, which could wrap around
+    bool valid = std::memcmp(header_->magic, g_octree_magic, sizeof(g_octree_magic)) == 0 &&
+                 header_->version == VERSION && header_->node_count > 0 &&
+                 header_->node_table_offset <= size_ &&
+                 std::uint64_t(header_->node_count) <= (size_ - header_->node_table_offset) / sizeof(Node);
+
+    if(valid)
+    {
+        // the points and children of every node, so that reading a node cannot access memory outside of the mapping,
+        // each node except the root must be the child of one node, so that traversals end
+        nodes_ = reinterpret_cast<const Node*>(data_ + header_->node_table_offset);
+        std::vector<bool> referenced(header_->node_count, false);
+        referenced[0] = true;
+        for(std::uint32_t i=0; i<header_->node_count && valid; ++i)
+        {
+            const Node& node = nodes_[i];
+            valid = node.offset <= size_ && std::uint64_t(node.point_count) <= (size_ - node.offset) / sizeof(Point);
+            for(std::int32_t child : node.children)
+            {
+                if(!valid || child == -1)
+                    continue;
+                valid = child >= 0 && child < std::int64_t(header_->node_count) && !referenced[child];
+                if(valid)
+                    referenced[child] = true;
+            }
+        }
+    }
+
+    if(!valid)
+    {
+        munmap(data, size_);
+        ::close(fd_);
+        DG_THROW("Invalid point cloud octree " + filename);
+    }
+}
+
+PointCloudOctree::~PointCloudOctree()
+{
+    munmap(const_cast<std::uint8_t*>(data_), size_);
+    ::close(fd_);
+}
+
+const PointCloudOctree::Point* PointCloudOctree::getPoints(std::size_t i) const
+{
+    return reinterpret_cast<const Point*>(data_ + nodes_[i].offset);
+}
+
+void PointCloudOctree::prefetch(std::size_t i) const
+{
+    const Node& node = nodes_[i];
+    if(node.point_count == 0)
+        return;
+
+    std::size_t page_size = std::size_t(sysconf(_SC_PAGESIZE));
+    std::size_t begin = node.offset / page_size * page_size;
+    std::size_t end = node.offset + std::size_t(node.point_count)*sizeof(Point);
+
+    madvise(const_cast<std::uint8_t*>(data_) + begin, end - begin, MADV_WILLNEED);
+
+    // touch every page, so that it is read here and not when the points are accessed
+    volatile std::uint8_t sum = 0;
+    for(std::size_t p = begin; p < end; p += page_size)
+        sum += data_[p];
+    (void)sum;
+}
+
+
+// keeps the first point in each cell of a grid of resolution^3 cells over the cube and passes the others to rejected
+static void sampleGrid(const std::vector<PointCloudOctree::Point>& points, const Vector3f& cell_min, float cell_size,
+                       std::uint32_t resolution, std::vector<PointCloudOctree::Point>& selected,
+                       std::vector<PointCloudOctree::Point>* rejected)
+{
+    std::unordered_set<std::uint64_t> occupied;
+    occupied.reserve(points.size());
+
+    float scale = float(resolution) / cell_size;
+    std::int64_t max_cell = std::int64_t(resolution) - 1;
+
+    for(const PointCloudOctree::Point& p : points)
+    {
+        std::int64_t x = std::min(std::max(std::int64_t((p.x - cell_min.x())*scale), std::int64_t(0)), max_cell);
+        std::int64_t y = std::min(std::max(std::int64_t((p.y - cell_min.y())*scale), std::int64_t(0)), max_cell);
+        std::int64_t z = std::min(std::max(std::int64_t((p.z - cell_min.z())*scale), std::int64_t(0)), max_cell);
+
+        std::uint64_t key = (std::uint64_t(x)*resolution + std::uint64_t(y))*resolution + std::uint64_t(z);
+        if(occupied.insert(key).second)
+            selected.push_back(p);
+        else if(rejected)
+            rejected->push_back(p);
+    }
+}
+
+static void initBounds(PointCloudOctree::Node& node)
+{
+    for(int k=0; k<3; ++k)
+    {
+        node.min[k] = std::numeric_limits<float>::max();
+        node.max[k] = -std::numeric_limits<float>::max();
+    }
+}
+
+static void extendBounds(PointCloudOctree::Node& node, const float* min, const float* max)
+{
+    for(int k=0; k<3; ++k)
+    {
+        node.min[k] = std::min(node.min[k], min[k]);
+        node.max[k] = std::max(node.max[k], max[k]);
+    }
+}
+
+
+PointCloudOctreeBuilder::PointCloudOctreeBuilder(const std::string& filename, const Vector3f& min, const Vector3f& max,
+                                                 AttributeType attribute_type, const Options& options) :
+    filename_(filename), options_(options), attribute_type_(attribute_type), min_(min)
+{
+    // more bins than this would exceed the limits of open files and directory sizes
+    options_.bin_level = std::min<std::uint32_t>(options_.bin_level, 5);
+    options_.sampling_grid = std::max<std::uint32_t>(options_.sampling_grid, 2);
+    options_.max_node_points = std::max<std::uint32_t>(options_.max_node_points, 1);
+
+    // the octree is a cube, that is slightly enlarged to keep the points at max inside
+    size_ = std::max((max - min).maxCoeff(), std::numeric_limits<float>::min()) * 1.0001f;
+
+    bins_.resize(std::size_t(1) << (3*options_.bin_level));
+}
+
+PointCloudOctreeBuilder::~PointCloudOctreeBuilder()
+{
+    if(file_)
+        std::fclose(file_);
+
+    for(std::size_t i=0; i<bins_.size(); ++i)
+        if(bins_[i].spilled > 0)
+            std::remove(binFilename(i).c_str());
+}
+
+void PointCloudOctreeBuilder::addPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count)
+{
+    add(positions, colors, count, AttributeType::Color);
+}
+
+void PointCloudOctreeBuilder::addPoints(const Vector3f* positions, const float* intensities, std::size_t count)
+{
+    add(positions, intensities, count, AttributeType::Intensity);
+}
+
+template <typename Attribute>
+void PointCloudOctreeBuilder::add(const Vector3f* positions, const Attribute* attributes, std::size_t count, AttributeType type)
+{
+    static_assert(sizeof(Attribute) == sizeof(std::uint32_t), "point attributes must have 4 bytes");
+
+    if(finished_)
+        DG_THROW("Points cannot be added after the octree was finished");
+
+    if(type != attribute_type_)
+        DG_THROW("The attributes of the points do not match the attribute type of the octree");
+
+    std::int64_t resolution = std::int64_t(1) << options_.bin_level;
+    float scale = float(resolution) / size_;
+
+    for(std::size_t i=0; i<count; ++i)
+    {
+        Vector3f c = (positions[i] - min_) * scale;
+        std::int64_t x = std::min(std::max(std::int64_t(c.x()), std::int64_t(0)), resolution-1);
+        std::int64_t y = std::min(std::max(std::int64_t(c.y()), std::int64_t(0)), resolution-1);
+        std::int64_t z = std::min(std::max(std::int64_t(c.z()), std::int64_t(0)), resolution-1);
+
+        Point p;
+        p.x = positions[i].x();
+        p.y = positions[i].y();
+        p.z = positions[i].z();
+        std::memcpy(&p.attribute, &attributes[i], sizeof(p.attribute));
+
+        bins_[std::size_t((x*resolution + y)*resolution + z)].points.push_back(p);
+    }
+
+    buffered_points_ += count;
+    point_count_ += count;
+
+    if(buffered_points_*sizeof(Point) > options_.memory_budget)
+        flush();
+}
+
+std::string PointCloudOctreeBuilder::binFilename(std::size_t bin) const
+{
+    return filename_ + ".bin" + std::to_string(bin) + ".tmp";
+}
+
+void PointCloudOctreeBuilder::flush()
+{
+    for(std::size_t i=0; i<bins_.size(); ++i)
+    {
+        Bin& bin = bins_[i];
+        if(bin.points.empty())
+            continue;
+
+        // the files are only opened while writing, as there may be more bins than open files are allowed
+        std::FILE* f = std::fopen(binFilename(i).c_str(), "ab");
+        if(!f || std::fwrite(bin.points.data(), sizeof(Point), bin.points.size(), f) != bin.points.size())
+        {
+            if(f)
+                std::fclose(f);
+            DG_THROW("Cannot write temporary file " + binFilename(i));
+        }
+        std::fclose(f);
+
+        bin.spilled += bin.points.size();
+        std::vector<Point>().swap(bin.points);
+    }
+
+    buffered_points_ = 0;
+}
+
+void PointCloudOctreeBuilder::loadBin(std::size_t i, std::vector<Point>& points)
+{
+    Bin& bin = bins_[i];
+
+    points.clear();
+    points.reserve(bin.spilled + bin.points.size());
+
+    if(bin.spilled > 0)
+    {
+        std::string bin_filename = binFilename(i);
+        std::FILE* f = std::fopen(bin_filename.c_str(), "rb");
+        points.resize(bin.spilled);
+        if(!f || std::fread(points.data(), sizeof(Point), points.size(), f) != points.size())
+        {
+            if(f)
+                std::fclose(f);
+            DG_THROW("Cannot read temporary file " + bin_filename);
+        }
+        std::fclose(f);
+        std::remove(bin_filename.c_str());
+        bin.spilled = 0;
+    }
+
+    points.insert(points.end(), bin.points.begin(), bin.points.end());
+    std::vector<Point>().swap(bin.points);
+}
+
+void PointCloudOctreeBuilder::writeNode(Node& node, const Point* points, std::size_t count)
+{
+    node.offset = file_offset_;
+    node.point_count = static_cast<std::uint32_t>(count);
+
+    if(count > 0 && std::fwrite(points, sizeof(Point), count, file_) != count)
+        DG_THROW("Cannot write point cloud octree " + filename_);
+
+    file_offset_ += count*sizeof(Point);
+}
+
+std::int32_t PointCloudOctreeBuilder::buildSubtree(std::vector<Point>& points, const Vector3f& cell_min, float cell_size,
+                                                   std::uint32_t level, std::vector<Point>* sampled)
+{
+    if(points.empty())
+        return -1;
+
+    Node node;
+    std::memset(&node, 0, sizeof(node));
+    std::fill(node.children, node.children+8, -1);
+    node.spacing = cell_size / float(options_.sampling_grid);
+    node.level = level;
+    initBounds(node);
+
+    std::vector<Point> own;
+    std::vector<Point> rest;
+    if(points.size() <= options_.max_node_points || level >= MAX_OCTREE_LEVEL)
+        own.swap(points);
+    else
+        sampleGrid(points, cell_min, cell_size, options_.sampling_grid, own, &rest);
+    std::vector<Point>().swap(points);
+
+    for(const Point& p : own)
+    {
+        float pos[3] = {p.x, p.y, p.z};
+        extendBounds(node, pos, pos);
+    }
+
+    // the subsample is moved to the parent (a point is stored in a single node), the spacing of the coarser grid
+    // is the one of the parent
+    if(sampled)
+    {
+        std::vector<Point> kept;
+        sampleGrid(own, cell_min, cell_size, options_.sampling_grid/2, *sampled, &kept);
+        own.swap(kept);
+    }
+
+    writeNode(node, own.data(), own.size());
+    std::vector<Point>().swap(own);
+
+    std::int32_t index = static_cast<std::int32_t>(nodes_.size());
+    nodes_.push_back(node);
+
+    if(rest.empty())
+        return index;
+
+    // octant bits: 1 = upper x half, 2 = upper y half, 4 = upper z half
+    float half = cell_size * 0.5f;
+    Vector3f center = cell_min + Vector3f::Constant(half);
+
+    std::vector<Point> children[8];
+    for(const Point& p : rest)
+        children[(p.x >= center.x() ? 1 : 0) | (p.y >= center.y() ? 2 : 0) | (p.z >= center.z() ? 4 : 0)].push_back(p);
+    std::vector<Point>().swap(rest);
+
+    for(int c=0; c<8; ++c)
+    {
+        Vector3f child_min = cell_min + Vector3f((c & 1) ? half : 0.0f, (c & 2) ? half : 0.0f, (c & 4) ? half : 0.0f);
+        std::int32_t child = buildSubtree(children[c], child_min, half, level+1, nullptr);
+        nodes_[index].children[c] = child;
+        if(child >= 0)
+            extendBounds(nodes_[index], nodes_[child].min, nodes_[child].max);
+    }
+
+    return index;
+}
+
+void PointCloudOctreeBuilder::finish()
+{
+    if(finished_)
+        DG_THROW("The octree was already finished");
+
+    file_ = std::fopen(filename_.c_str(), "wb");
+    if(!file_)
+        DG_THROW("Cannot create point cloud octree " + filename_);
+
+    PointCloudOctree::Header header;
+    std::memset(&header, 0, sizeof(header));
+    if(std::fwrite(&header, sizeof(header), 1, file_) != 1)
+        DG_THROW("Cannot write point cloud octree " + filename_);
+    file_offset_ = sizeof(header);
+
+    nodes_.clear();
+
+    // cells of the current level, starting with the bins, with the subsample of the points for the parent
+    struct Cell
+    {
+        std::int32_t node = -1;
+        std::vector<Point> sampled;
+    };
+
+    std::uint32_t level = options_.bin_level;
+    std::uint32_t resolution = 1u << level;
+    std::vector<Cell> cells(bins_.size());
+
+    std::vector<Point> points;
+    for(std::uint32_t x=0; x<resolution; ++x)
+    for(std::uint32_t y=0; y<resolution; ++y)
+    for(std::uint32_t z=0; z<resolution; ++z)
+    {
+        std::size_t i = (std::size_t(x)*resolution + y)*resolution + z;
+        float cell_size = size_ / float(resolution);
+
+        loadBin(i, points);
+        cells[i].node = buildSubtree(points, min_ + Vector3f(float(x), float(y), float(z))*cell_size, cell_size, level, &cells[i].sampled);
+    }
+
+    // build the levels above the bins from the subsamples that were moved out of their children
+    while(level > 0)
+    {
+        --level;
+        resolution >>= 1;
+        float cell_size = size_ / float(resolution);
+
+        std::vector<Cell> parents(std::size_t(resolution)*resolution*resolution);
+        for(std::uint32_t x=0; x<resolution; ++x)
+        for(std::uint32_t y=0; y<resolution; ++y)
+        for(std::uint32_t z=0; z<resolution; ++z)
+        {
+            Node node;
+            std::memset(&node, 0, sizeof(node));
+            std::fill(node.children, node.children+8, -1);
+            node.spacing = cell_size / float(options_.sampling_grid);
+            node.level = level;
+            initBounds(node);
+
+            std::vector<Point> candidates;
+            for(int c=0; c<8; ++c)
+            {
+                std::uint32_t cx = 2*x + ((c & 1) ? 1 : 0);
+                std::uint32_t cy = 2*y + ((c & 2) ? 1 : 0);
+                std::uint32_t cz = 2*z + ((c & 4) ? 1 : 0);
+                Cell& child = cells[(std::size_t(cx)*2*resolution + cy)*2*resolution + cz];
+                if(child.node < 0)
+                    continue;
+
+                node.children[c] = child.node;
+                extendBounds(node, nodes_[child.node].min, nodes_[child.node].max);
+                candidates.insert(candidates.end(), child.sampled.begin(), child.sampled.end());
+                std::vector<Point>().swap(child.sampled);
+            }
+
+            if(candidates.empty())
+                continue;
+
+            Cell& parent = parents[(std::size_t(x)*resolution + y)*resolution + z];
+            Vector3f cell_min = min_ + Vector3f(float(x), float(y), float(z))*cell_size;
+
+            // the candidates were moved out of the children, hence all are kept, there are at most sampling_grid^3
+            std::vector<Point> own;
+            if(level > 0)
+                sampleGrid(candidates, cell_min, cell_size, options_.sampling_grid/2, parent.sampled, &own);
+            else
+                own.swap(candidates);
+
+            writeNode(node, own.data(), own.size());
+            parent.node = static_cast<std::int32_t>(nodes_.size());
+            nodes_.push_back(node);
+        }
+
+        cells.swap(parents);
+    }
+
+    std::int32_t root = cells[0].node;
+    if(root < 0)
+    {
+        // no points
+        Node node;
+        std::memset(&node, 0, sizeof(node));
+        std::fill(node.children, node.children+8, -1);
+        node.spacing = size_ / float(options_.sampling_grid);
+        node.offset = file_offset_;
+        float min[3] = {min_.x(), min_.y(), min_.z()};
+        std::copy(min, min+3, node.min);
+        std::copy(min, min+3, node.max);
+        root = static_cast<std::int32_t>(nodes_.size());
+        nodes_.push_back(node);
+    }
+
+    // the root is the first node in the file
+    if(root != 0)
+    {
+        std::swap(nodes_[0], nodes_[root]);
+        for(Node& node : nodes_)
+            for(std::int32_t& child : node.children)
+            {
+                if(child == 0)
+                    child = root;
+                else if(child == root)
+                    child = 0;
+            }
+    }
+
+    std::memcpy(header.magic, g_octree_magic, sizeof(g_octree_magic));
+    header.version = PointCloudOctree::VERSION;
+    header.attribute_type = attribute_type_;
+    header.node_count = static_cast<std::uint32_t>(nodes_.size());
+    header.point_count = 0;
+    for(const Node& node : nodes_)
+        header.point_count += node.point_count;
+    header.node_table_offset = file_offset_;
+    std::copy(nodes_[0].min, nodes_[0].min+3, header.min);
+    std::copy(nodes_[0].max, nodes_[0].max+3, header.max);
+
+    bool ok = std::fwrite(nodes_.data(), sizeof(Node), nodes_.size(), file_) == nodes_.size() &&
+              std::fseek(file_, 0, SEEK_SET) == 0 &&
+              std::fwrite(&header, sizeof(header), 1, file_) == 1;
+
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+
+    if(!ok)
+        DG_THROW("Cannot write point cloud octree " + filename_);
+
+    nodes_ = std::vector<Node>();
+    finished_ = true;
+}
+
+}
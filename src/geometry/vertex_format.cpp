@@ -0,0 +1,321 @@
+#include <dg/geometry/vertex_format.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace dg {
+
+LayoutElement VertexFormat::positionElement() const
+{
+    return LayoutElement{0, 0, 3, VT_FLOAT32, false};
+}
+
+LayoutElement VertexFormat::normalElement() const
+{
+    if(normal == NormalFormat::SNorm16)
+        return LayoutElement{1, 0, 4, VT_INT16, true};
+
+    return LayoutElement{1, 0, 3, VT_FLOAT32, false};
+}
+
+LayoutElement VertexFormat::colorElement() const
+{
+    if(color == ColorFormat::UNorm8)
+        return LayoutElement{2, 0, 4, VT_UINT8, true};
+
+    return LayoutElement{2, 0, 4, VT_FLOAT32, false};
+}
+
+LayoutElement VertexFormat::uvElement() const
+{
+    if(uv == UVFormat::Float16)
+        return LayoutElement{3, 0, 2, VT_FLOAT16, false};
+
+    return LayoutElement{3, 0, 2, VT_FLOAT32, false};
+}
+
+
+template <typename T>
+static std::uint8_t* write(std::uint8_t* dst, T v)
+{
+    std::memcpy(dst, &v, sizeof(T));
+    return dst + sizeof(T);
+}
+
+static std::int16_t toSNorm16(float v)
+{
+    v = std::min(std::max(v, -1.0f), 1.0f);
+    return static_cast<std::int16_t>(std::lround(v * 32767.0f));
+}
+
+static std::uint8_t toUNorm8(float v)
+{
+    v = std::min(std::max(v, 0.0f), 1.0f);
+    return static_cast<std::uint8_t>(std::lround(v * 255.0f));
+}
+
+std::uint8_t* VertexFormat::writePosition(std::uint8_t* dst, float x, float y, float z) const
+{
+    dst = write(dst, x);
+    dst = write(dst, y);
+    dst = write(dst, z);
+    return dst;
+}
+
+std::uint8_t* VertexFormat::writeNormal(std::uint8_t* dst, float x, float y, float z) const
+{
+    if(normal == NormalFormat::SNorm16)
+    {
+        dst = write(dst, toSNorm16(x));
+        dst = write(dst, toSNorm16(y));
+        dst = write(dst, toSNorm16(z));
+        dst = write(dst, std::int16_t(0));
+        return dst;
+    }
+
+    dst = write(dst, x);
+    dst = write(dst, y);
+    dst = write(dst, z);
+    return dst;
+}
+
+std::uint8_t* VertexFormat::writeColor(std::uint8_t* dst, const Color& col) const
+{
+    if(color == ColorFormat::UNorm8)
+    {
+        *dst++ = toUNorm8(col.r);
+        *dst++ = toUNorm8(col.g);
+        *dst++ = toUNorm8(col.b);
+        *dst++ = toUNorm8(col.a);
+        return dst;
+    }
+
+    dst = write(dst, col.r);
+    dst = write(dst, col.g);
+    dst = write(dst, col.b);
+    dst = write(dst, col.a);
+    return dst;
+}
+
+std::uint8_t* VertexFormat::writeUV(std::uint8_t* dst, float u, float v) const
+{
+    if(uv == UVFormat::Float16)
+    {
+        dst = write(dst, floatToHalf(u));
+        dst = write(dst, floatToHalf(v));
+        return dst;
+    }
+
+    dst = write(dst, u);
+    dst = write(dst, v);
+    return dst;
+}
+
+
+// the vertices are converted in batches, that are transformed with 4 component vectors, so that Eigen can use SIMD
+static const std::size_t BATCH_SIZE = 256;
+
+using Batch = Eigen::Matrix<float, 4, Eigen::Dynamic>;
+
+static void loadBatch(const float* xyz, std::size_t count, float w, Batch& batch)
+{
+    batch.resize(4, count);
+    for(std::size_t i=0; i<count; ++i)
+        batch.col(i) << xyz[3*i], xyz[3*i+1], xyz[3*i+2], w;
+}
+
+void VertexFormat::writePositions(std::uint8_t* dst, std::size_t stride, const float* xyz, std::size_t count, const Matrix4f& transform) const
+{
+    Batch batch, result;
+    for(std::size_t first=0; first<count; first+=BATCH_SIZE)
+    {
+        std::size_t n = std::min(BATCH_SIZE, count-first);
+        loadBatch(xyz + 3*first, n, 1.0f, batch);
+        result.noalias() = transform * batch;
+
+        std::uint8_t* ptr = dst + first*stride;
+        for(std::size_t i=0; i<n; ++i, ptr += stride)
+            std::memcpy(ptr, result.col(i).data(), 3*sizeof(float));
+    }
+}
+
+void VertexFormat::writeNormals(std::uint8_t* dst, std::size_t stride, const float* xyz, std::size_t count, const Matrix4f& transform) const
+{
+    Matrix4f linear = Matrix4f::Zero();
+    linear.block<3,3>(0,0) = transform.block<3,3>(0,0);
+
+    Batch batch, result;
+    for(std::size_t first=0; first<count; first+=BATCH_SIZE)
+    {
+        std::size_t n = std::min(BATCH_SIZE, count-first);
+        loadBatch(xyz + 3*first, n, 0.0f, batch);
+        result.noalias() = linear * batch;
+        result.colwise().normalize();
+
+        std::uint8_t* ptr = dst + first*stride;
+        if(normal == NormalFormat::SNorm16)
+        {
+            for(std::size_t i=0; i<n; ++i, ptr += stride)
+            {
+                std::int16_t v[4] = {toSNorm16(result(0,i)), toSNorm16(result(1,i)), toSNorm16(result(2,i)), 0};
+                std::memcpy(ptr, v, sizeof(v));
+            }
+        }
+        else
+        {
+            for(std::size_t i=0; i<n; ++i, ptr += stride)
+                std::memcpy(ptr, result.col(i).data(), 3*sizeof(float));
+        }
+    }
+}
+
+// linear interpolation in a table of pow(v, 2.2), which is much faster than std::pow per channel
+static float toSRGBFast(float v)
+{
+    static const int TABLE_SIZE = 1024;
+    static const std::vector<float> table = []() {
+        std::vector<float> t(TABLE_SIZE+2);
+        for(int i=0; i<=TABLE_SIZE; ++i)
+            t[i] = Color::toSRGB(float(i)/TABLE_SIZE);
+        t[TABLE_SIZE+1] = t[TABLE_SIZE];
+        return t;
+    }();
+
+    if(!(v > 0.0f)) // also catches nan
+        return 0.0f;
+
+    v = std::min(v, 1.0f) * TABLE_SIZE;
+    int i = static_cast<int>(v);
+    float f = v - i;
+    return table[i] + f*(table[i+1]-table[i]);
+}
+
+void VertexFormat::writeColors(std::uint8_t* dst, std::size_t stride, const float* rgba, std::size_t count, bool to_srgb) const
+{
+    for(std::size_t i=0; i<count; ++i, dst += stride, rgba += 4)
+    {
+        float c[4] = {rgba[0], rgba[1], rgba[2], rgba[3]};
+        if(to_srgb)
+        {
+            c[0] = toSRGBFast(c[0]);
+            c[1] = toSRGBFast(c[1]);
+            c[2] = toSRGBFast(c[2]);
+        }
+
+        if(color == ColorFormat::UNorm8)
+        {
+            std::uint8_t v[4] = {toUNorm8(c[0]), toUNorm8(c[1]), toUNorm8(c[2]), toUNorm8(c[3])};
+            std::memcpy(dst, v, sizeof(v));
+        }
+        else
+            std::memcpy(dst, c, sizeof(c));
+    }
+}
+
+
+std::uint16_t floatToHalf(float v)
+{
+    std::uint32_t f;
+    std::memcpy(&f, &v, sizeof(f));
+
+    std::uint32_t sign = (f >> 16) & 0x8000;
+    std::uint32_t exp  = (f >> 23) & 0xff;
+    std::uint32_t mant = f & 0x7fffff;
+
+    if(exp == 0xff) // inf / nan
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+
+    int e = int(exp) - 127 + 15;
+
+    if(e >= 0x1f) // overflow -> inf
+        return sign | 0x7c00;
+
+    if(e <= 0) // subnormal or zero
+    {
+        if(e < -10)
+            return sign;
+
+        mant |= 0x800000;
+        std::uint32_t shift = 14 - e;
+        std::uint32_t half_mant = mant >> shift;
+        std::uint32_t rem = mant & ((1u << shift) - 1);
+        std::uint32_t halfway = 1u << (shift - 1);
+        if(rem > halfway || (rem == halfway && (half_mant & 1)))
+            ++half_mant;
+        return sign | half_mant;
+    }
+
+    std::uint32_t h = sign | (std::uint32_t(e) << 10) | (mant >> 13);
+    std::uint32_t rem = mant & 0x1fff;
+    if(rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+        ++h; // may carry into the exponent, which correctly rounds up to the next power of two / inf
+
+    return static_cast<std::uint16_t>(h);
+}
+
+
+VALUE_TYPE indexTypeForVertexCount(std::size_t vertex_count)
+{
+    // 0xFFFF is not used as index, since it is the primitive restart index for 16 bit strips on some backends
+    return vertex_count < 0xFFFF ? VT_UINT16 : VT_UINT32;
+}
+
+std::uint32_t valueTypeSize(VALUE_TYPE type)
+{
+    switch(type)
+    {
+    case VT_INT8:
+    case VT_UINT8:   return 1;
+    case VT_INT16:
+    case VT_UINT16:
+    case VT_FLOAT16: return 2;
+    case VT_INT32:
+    case VT_UINT32:
+    case VT_FLOAT32: return 4;
+    default:         return 0;
+    }
+}
+
+int findElementOffset(const std::vector<LayoutElement>& layout, std::uint32_t input_index)
+{
+    std::uint32_t offset = 0;
+    for(const LayoutElement& e : layout)
+    {
+        if(e.BufferSlot != 0)
+            continue;
+
+        if(e.RelativeOffset != LAYOUT_ELEMENT_AUTO_OFFSET)
+            offset = e.RelativeOffset;
+
+        if(e.InputIndex == input_index)
+            return static_cast<int>(offset);
+
+        offset += e.NumComponents * valueTypeSize(e.ValueType);
+    }
+    return -1;
+}
+
+int findPositionOffset(const std::vector<LayoutElement>& layout)
+{
+    for(const LayoutElement& e : layout)
+        if(e.BufferSlot == 0 && e.InputIndex == 0 && (e.ValueType != VT_FLOAT32 || e.NumComponents < 3))
+            return -1;
+
+    return findElementOffset(layout, 0);
+}
+
+const void* packIndices(const std::uint32_t* indices, std::size_t count, VALUE_TYPE index_type, std::vector<std::uint8_t>& dst)
+{
+    if(index_type != VT_UINT16)
+        return indices;
+
+    dst.resize(count*sizeof(std::uint16_t));
+    std::uint16_t* out = reinterpret_cast<std::uint16_t*>(dst.data());
+    for(std::size_t i=0; i<count; ++i)
+        out[i] = static_cast<std::uint16_t>(indices[i]);
+
+    return dst.data();
+}
+
+}
@@ -0,0 +1,319 @@
+#include <dg/internal/mesh_loader.hpp>
+
+#include <dg/core/cache_directory.hpp>
+#include <dg/core/hash.hpp>
+
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/Importer.hpp>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+namespace dg {
+
+namespace {
+
+const unsigned int IMPORT_FLAGS = aiProcess_CalcTangentSpace      |
+                                  aiProcess_Triangulate           |
+                                  aiProcess_GenSmoothNormals      |
+                                  aiProcess_JoinIdenticalVertices |
+                                  aiProcess_SortByPType;
+
+struct SubMesh
+{
+    const aiMesh* mesh;
+    aiMatrix4x4   transform;
+};
+
+void collectSubMeshes(const aiScene* scene, const aiNode* n, const aiMatrix4x4& parentTransform, bool skipNodesTransform,
+                      std::vector<SubMesh>& submeshes)
+{
+    aiMatrix4x4 transform;
+    if(!skipNodesTransform)
+        transform = parentTransform * n->mTransformation;
+    else
+        transform = parentTransform;
+
+    for(unsigned int k = 0; k<n->mNumMeshes; ++k)
+    {
+        assert(n->mMeshes[k]<scene->mNumMeshes);
+        submeshes.push_back(SubMesh{scene->mMeshes[n->mMeshes[k]], transform});
+    }
+
+    // process child nodes
+    for(unsigned int i=0; i<n->mNumChildren; ++i)
+        collectSubMeshes(scene, n->mChildren[i], transform, false, submeshes);
+}
+
+Matrix4f toMatrix(const aiMatrix4x4& m)
+{
+    Matrix4f t;
+    t << m.a1, m.a2, m.a3, m.a4,
+         m.b1, m.b2, m.b3, m.b4,
+         m.c1, m.c2, m.c3, m.c4,
+         m.d1, m.d2, m.d3, m.d4;
+    return t;
+}
+
+// converts the submesh directly into the final interleaved vertex and index arrays
+MeshData convertSubMesh(const aiMesh* m, const aiMatrix4x4& transform, const VertexFormat& format)
+{
+    static_assert(sizeof(aiVector3D) == 3*sizeof(float) && sizeof(aiColor4D) == 4*sizeof(float),
+                  "Assimp must be built with single precision");
+
+    bool use_normals = m->mNormals!=nullptr;
+    bool use_color = m->mColors[0]!=nullptr;
+
+    MeshData data;
+    data.primitive_topology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    data.input_layout.push_back(format.positionElement());
+    data.vertex_stride += format.positionSize();
+    std::uint32_t normal_offset = data.vertex_stride;
+    if(use_normals)
+    {
+        data.input_layout.push_back(format.normalElement());
+        data.vertex_stride += format.normalSize();
+    }
+    std::uint32_t color_offset = data.vertex_stride;
+    if(use_color)
+    {
+        data.input_layout.push_back(format.colorElement());
+        data.vertex_stride += format.colorSize();
+    }
+
+    // fill in the vertex data
+    Matrix4f t = toMatrix(transform);
+    data.vertex_count = m->mNumVertices;
+    data.vertices.resize(std::size_t(data.vertex_count)*data.vertex_stride);
+
+    format.writePositions(data.vertices.data(), data.vertex_stride, &m->mVertices[0].x, data.vertex_count, t);
+    if(use_normals)
+        format.writeNormals(data.vertices.data() + normal_offset, data.vertex_stride, &m->mNormals[0].x, data.vertex_count, t);
+    if(use_color)
+        format.writeColors(data.vertices.data() + color_offset, data.vertex_stride, &m->mColors[0][0].r, data.vertex_count, true);
+
+    data.indices.resize(std::size_t(m->mNumFaces)*3);
+    std::uint32_t* idx = data.indices.data();
+    for(unsigned int i=0; i<m->mNumFaces; ++i)
+    {
+        const aiFace& f = m->mFaces[i];
+
+        // faces with fewer indices only happen for points and lines
+        if(f.mNumIndices==3)
+        {
+            idx[0] = f.mIndices[0];
+            idx[1] = f.mIndices[1];
+            idx[2] = f.mIndices[2];
+            idx += 3;
+        }
+    }
+    data.indices.resize(idx - data.indices.data());
+
+    return data;
+}
+
+/**
+ * Imports the file and returns the prepared sections, does not access the GPU.
+ * The submeshes are converted and prepared in parallel on the pool, if one is given. Returns early if cancelled is set.
+ */
+std::vector<MeshData> importMeshes(const std::string& filename, const VertexFormat& format,
+                                   const std::function<void(MeshData&)>& prepare,
+                                   WorkerPool* pool, const std::atomic<bool>* cancelled)
+{
+    // Create an instance of the Importer class
+    Assimp::Importer importer;
+
+    const aiScene* scene = importer.ReadFile(filename, IMPORT_FLAGS);
+
+    // If the import failed, report it
+    if(!scene)
+      DG_THROW(importer.GetErrorString());
+
+    std::vector<SubMesh> submeshes;
+    collectSubMeshes(scene, scene->mRootNode, aiMatrix4x4(), true, submeshes); // skip roots transform
+
+    std::vector<MeshData> meshes(submeshes.size());
+
+    // the large submeshes dominate the total time anyway, hence they are simply taken in order
+    auto convert = [&](std::size_t i)
+    {
+        if(cancelled && *cancelled)
+            return;
+
+        meshes[i] = convertSubMesh(submeshes[i].mesh, submeshes[i].transform, format);
+
+        // point and line meshes have no triangles
+        if(!meshes[i].indices.empty())
+            prepare(meshes[i]);
+    };
+
+    if(pool)
+        pool->parallelFor(submeshes.size(), convert);
+    else
+        for(std::size_t i=0; i<submeshes.size(); ++i)
+            convert(i);
+
+    meshes.erase(std::remove_if(meshes.begin(), meshes.end(), [](const MeshData& data) { return data.indices.empty(); }),
+                 meshes.end());
+
+    return meshes;
+}
+
+}
+
+template <typename T>
+static void appendBytes(std::string& s, const T& v)
+{
+    s.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+
+MeshLoader::MeshLoader(const std::string& filename, const MeshLoadSettings& settings) :
+    filename_(filename), settings_(settings)
+{
+}
+
+void MeshLoader::load(bool prefetch, const std::atomic<bool>* cancelled, WorkerPool* pool)
+{
+    meshes_.clear();
+    cache_.reset();
+
+    if(settings_.cache_enabled)
+        initCacheEntry();
+
+    if(!cache_filename_.empty())
+    {
+        // a missing, outdated or broken cache is simply replaced
+        try
+        {
+            MeshFile::Ptr cache = MeshFile::open(cache_filename_);
+            if(cache->getKey() == cache_key_)
+            {
+                if(prefetch)
+                    cache->prefetch();
+                cache_ = cache;
+                return;
+            }
+        }
+        catch(const std::exception&)
+        {
+        }
+    }
+
+    import(cancelled, pool);
+
+    if(!cache_filename_.empty() && !(cancelled && *cancelled))
+    {
+        // the cache is optional, e.g. the directory may be read only
+        try
+        {
+            createDirectories(cache_filename_.substr(0, cache_filename_.find_last_of('/')));
+            MeshFile::write(cache_filename_, cache_key_, meshes_);
+        }
+        catch(const std::exception&)
+        {
+        }
+    }
+}
+
+std::size_t MeshLoader::getMeshSize(std::size_t i) const
+{
+    if(cache_)
+        return cache_->getMeshSize(i);
+
+    const MeshData& data = meshes_[i];
+    std::size_t size = data.vertices.size() + data.indices.size()*sizeof(std::uint32_t);
+    for(const MeshLod& lod : data.lods)
+        size += lod.indices.size()*sizeof(std::uint32_t);
+    return size;
+}
+
+MeshBuffers::Ptr MeshLoader::upload(IRenderDevice* device, std::size_t i)
+{
+    if(!cache_)
+    {
+        MeshBuffers::Ptr mesh = MeshBuffers::create(device, filename_, meshes_[i]);
+        meshes_[i] = MeshData(); // release the CPU copy
+        return mesh;
+    }
+
+    // directly from the mapped file
+    MeshFile::MeshView view = cache_->getMesh(i);
+    MeshBuffers::Ptr mesh = MeshBuffers::create(device, filename_, view.input_layout, view.primitive_topology,
+                                                view.vertices, view.vertex_stride, view.vertex_count,
+                                                view.indices, view.index_count);
+    for(const MeshFile::MeshView::LodView& lod : view.lods)
+        mesh->addLod(device, filename_, lod.indices, lod.index_count, lod.error);
+
+    return mesh;
+}
+
+void MeshLoader::import(const std::atomic<bool>* cancelled, WorkerPool* pool)
+{
+    const MeshLoadSettings& settings = settings_;
+    auto prepare = [&settings](MeshData& data)
+    {
+        if(settings.mesh_optimization != MeshOptimization_None)
+            optimizeMesh(settings.mesh_optimization, data);
+
+        if(settings.generate_lods)
+            generateLods(data, settings.lod_options);
+    };
+
+    meshes_ = importMeshes(filename_, settings_.vertex_format, prepare, pool, cancelled);
+}
+
+void MeshLoader::initCacheEntry()
+{
+    cache_filename_.clear();
+    cache_key_ = 0;
+
+    struct stat st;
+    char path[PATH_MAX];
+    if(stat(filename_.c_str(), &st) != 0 || !realpath(filename_.c_str(), path))
+        return;
+
+    // everything that changes the result of the import, the key is persistent, hence no std::hash
+    std::string key(path);
+    appendBytes(key, std::int64_t(st.st_mtim.tv_sec));
+    appendBytes(key, std::int64_t(st.st_mtim.tv_nsec));
+    appendBytes(key, std::int64_t(st.st_size));
+    appendBytes(key, IMPORT_FLAGS);
+    appendBytes(key, settings_.vertex_format.normal);
+    appendBytes(key, settings_.vertex_format.color);
+    appendBytes(key, settings_.vertex_format.uv);
+    appendBytes(key, std::uint32_t(settings_.mesh_optimization));
+    appendBytes(key, settings_.generate_lods);
+    if(settings_.generate_lods)
+    {
+        appendBytes(key, settings_.lod_options.max_levels);
+        appendBytes(key, settings_.lod_options.reduction);
+        appendBytes(key, std::uint64_t(settings_.lod_options.min_index_count));
+    }
+    cache_key_ = hash_bytes(key.data(), key.size());
+
+    // the cache is not written next to the file, as asset directories are often shared or read only
+    std::string directory = settings_.cache_directory.empty() ? defaultCacheDirectory() : settings_.cache_directory;
+    if(directory.empty())
+        return;
+
+    // one entry per source file, the key in the file tells whether it is up to date
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.dgmesh", static_cast<unsigned long long>(hash_bytes(path, std::strlen(path))));
+    cache_filename_ = directory + "/" + name;
+}
+
+std::string MeshLoader::defaultCacheDirectory()
+{
+    return userCacheDirectory("meshes");
+}
+
+}
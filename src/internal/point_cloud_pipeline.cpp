@@ -0,0 +1,251 @@
+#include <dg/internal/point_cloud_pipeline.hpp>
+
+#include <dg/core/conversion.hpp>
+#include <dg/scene/scene_manager.hpp>
+#include <dg/material/shader_program.hpp>
+#include <dg/material/common_constants.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/SwapChain.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/PipelineState.h>
+
+namespace dg {
+
+static const char* g_point_cloud_vs =
+DG_COMMON_CONSTANTS_VS_CODE
+R"===(
+cbuffer PointCloudConstants
+{
+    float2 g_pointScale; // half size of the points in normalized device coordinates
+    float  g_intensityOffset;
+    float  g_intensityScale;
+    int    g_colormap;
+    float  g_round;
+    float2 g_padding;
+};
+
+struct VSInput
+{
+    float3 Pos       : ATTRIB0;
+#if USE_INTENSITY
+    float  Intensity : ATTRIB1;
+#else
+    float4 Color     : ATTRIB1;
+#endif
+};
+
+struct PSInput
+{
+    float4 Pos    : SV_POSITION;
+    float4 Color  : COLOR0;
+    float2 Corner : TEX_COORD;
+    float  Round  : ROUND;
+};
+
+float3 colormapTurbo(float x)
+{
+    // polynomial approximation of the turbo colormap by Google
+    const float4 kRed4   = float4(0.13572138, 4.61539260, -42.66032258, 132.13108234);
+    const float4 kGreen4 = float4(0.09140261, 2.19418839, 4.84296658, -14.18503333);
+    const float4 kBlue4  = float4(0.10667330, 12.64194608, -60.58204836, 110.36276771);
+    const float2 kRed2   = float2(-152.94239396, 59.28637943);
+    const float2 kGreen2 = float2(4.27729857, 2.82956604);
+    const float2 kBlue2  = float2(-89.90310912, 27.34824973);
+
+    float4 v4 = float4(1.0, x, x*x, x*x*x);
+    float2 v2 = v4.zw * v4.z;
+    return float3(dot(v4, kRed4)   + dot(v2, kRed2),
+                  dot(v4, kGreen4) + dot(v2, kGreen2),
+                  dot(v4, kBlue4)  + dot(v2, kBlue2));
+}
+
+float3 colormapViridis(float t)
+{
+    // polynomial approximation of the viridis colormap
+    const float3 c0 = float3(0.2777273272234177, 0.005407344544966578, 0.3340998053353061);
+    const float3 c1 = float3(0.1050930431085774, 1.404613529898575, 1.384590162594685);
+    const float3 c2 = float3(-0.3308618287255563, 0.214847559468213, 0.09509516302823659);
+    const float3 c3 = float3(-4.634230498983486, -5.799100973351585, -19.33244095627987);
+    const float3 c4 = float3(6.228269936347081, 14.17993336680509, 56.69055260068105);
+    const float3 c5 = float3(4.776384997670288, -13.74514537774601, -65.35303263337234);
+    const float3 c6 = float3(-5.435455855934631, 4.645852612178535, 26.3124352495832);
+    return c0+t*(c1+t*(c2+t*(c3+t*(c4+t*(c5+t*c6)))));
+}
+
+void main(in  VSInput VSIn,
+          in  uint    VertId : SV_VertexID,
+          out PSInput PSIn)
+{
+    // the 4 vertices of the triangle strip of each instance are the corners of the quad
+    float2 corner = float2((VertId & 1u) != 0u ? 1.0 : -1.0, (VertId & 2u) != 0u ? 1.0 : -1.0);
+
+    float4 pos = mul(g_worldViewProj, float4(VSIn.Pos,1.0));
+    pos.xy += corner * g_pointScale * pos.w;
+
+    PSIn.Pos    = pos;
+    PSIn.Corner = corner;
+    PSIn.Round  = g_round;
+
+#if USE_INTENSITY
+    float t = saturate((VSIn.Intensity + g_intensityOffset) * g_intensityScale);
+    float3 color;
+    if(g_colormap == 1)
+        color = colormapTurbo(t);
+    else if(g_colormap == 2)
+        color = colormapViridis(t);
+    else
+        color = float3(t, t, t);
+    PSIn.Color = float4(saturate(color), 1.0);
+#else
+    PSIn.Color = VSIn.Color;
+#endif
+}
+)===";
+
+static const char* g_point_cloud_ps =
+R"===(
+struct PSInput
+{
+    float4 Pos    : SV_POSITION;
+    float4 Color  : COLOR0;
+    float2 Corner : TEX_COORD;
+    float  Round  : ROUND;
+};
+
+struct PSOutput
+{
+    float4 Color : SV_TARGET;
+};
+
+void main(in  PSInput  PSIn,
+          out PSOutput PSOut)
+{
+    if(PSIn.Round > 0.5 && dot(PSIn.Corner, PSIn.Corner) > 1.0)
+        discard;
+
+    PSOut.Color = PSIn.Color;
+}
+)===";
+
+struct PointCloudConstants
+{
+    float point_scale[2];
+    float intensity_offset;
+    float intensity_scale;
+    int   colormap;
+    float round;
+    float padding[2];
+};
+
+static std::map<std::pair<IRenderDevice*, int>, std::weak_ptr<ShaderProgram>> g_shared_point_cloud_programs;
+
+
+PointCloudPipeline::PointCloudPipeline()
+{
+}
+
+PointCloudPipeline::~PointCloudPipeline()
+{
+}
+
+void PointCloudPipeline::begin(SceneManager* manager, const Parameters& params)
+{
+    IRenderDevice* device = manager->device();
+
+    if(!pso_ || pso_use_intensity_ != params.use_intensity)
+    {
+        int use_intensity = params.use_intensity ? 1 : 0;
+
+        std::weak_ptr<ShaderProgram>& shared_shader_program = g_shared_point_cloud_programs[std::make_pair(device, use_intensity)];
+        if(shared_shader_program.expired())
+        {
+            ShaderProgram::MacroDefinitions macros;
+            if(use_intensity)
+                macros.push_back(std::make_pair("USE_INTENSITY", "1"));
+
+            shader_program_ = std::make_shared<ShaderProgram>();
+            shader_program_->setShaders(device, "PointCloud_shader", g_point_cloud_vs, g_point_cloud_ps, macros);
+            shader_program_->addConstant<CommonConstantsVS>(device, "CommonConstantsVS");
+            shader_program_->addConstant<PointCloudConstants>(device, "PointCloudConstants");
+            shared_shader_program = shader_program_;
+        }
+        else
+            shader_program_ = shared_shader_program.lock();
+
+        PipelineStateCreateInfo pso_create_info;
+        PipelineStateDesc& desc = pso_create_info.PSODesc;
+
+        desc.Name = "PointCloud PSO";
+        desc.IsComputePipeline = false;
+        desc.GraphicsPipeline.NumRenderTargets  = 1;
+        desc.GraphicsPipeline.RTVFormats[0]     = manager->swapChain()->GetDesc().ColorBufferFormat;
+        desc.GraphicsPipeline.DSVFormat         = manager->swapChain()->GetDesc().DepthBufferFormat;
+        desc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+        desc.GraphicsPipeline.pVS = shader_program_->getVertexShader();
+        desc.GraphicsPipeline.pPS = shader_program_->getPixelShader();
+
+        desc.GraphicsPipeline.PrimitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        desc.GraphicsPipeline.RasterizerDesc.CullMode = CULL_MODE_NONE;
+        desc.GraphicsPipeline.DepthStencilDesc.DepthEnable = true;
+
+        // one instance per point, the corners of the quads are generated from the vertex id
+        LayoutElement layout[] =
+        {
+            {0, 0, 3, VT_FLOAT32, false, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}, // pos
+            use_intensity ? LayoutElement{1, 0, 1, VT_FLOAT32, false, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}  // intensity
+                          : LayoutElement{1, 0, 4, VT_UINT8, true, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}     // color
+        };
+        desc.GraphicsPipeline.InputLayout.LayoutElements = layout;
+        desc.GraphicsPipeline.InputLayout.NumElements = _countof(layout);
+
+        pso_.Release();
+        srb_.Release();
+        device->CreatePipelineState(pso_create_info, &pso_);
+        shader_program_->bind(pso_);
+        pso_->CreateShaderResourceBinding(&srb_, true);
+
+        pso_use_intensity_ = params.use_intensity;
+    }
+
+    IDeviceContext* context = manager->context();
+
+    {
+        auto constants = shader_program_->mapConstant<CommonConstantsVS>(context, "CommonConstantsVS");
+        matrix_to_float4x4t(manager->getWorldViewProj(), constants->g_worldViewProj);
+        matrix_to_float4x4t(manager->getWorldView(), constants->g_worldView);
+        matrix_to_float4x4t(manager->getView(), constants->g_view);
+    }
+
+    {
+        const SwapChainDesc& sc_desc = manager->swapChain()->GetDesc();
+        float range = params.max_intensity - params.min_intensity;
+
+        auto constants = shader_program_->mapConstant<PointCloudConstants>(context, "PointCloudConstants");
+        constants->point_scale[0]    = params.point_size / float(sc_desc.Width);
+        constants->point_scale[1]    = params.point_size / float(sc_desc.Height);
+        constants->intensity_offset  = -params.min_intensity;
+        constants->intensity_scale   = range != 0.0f ? 1.0f / range : 0.0f;
+        constants->colormap          = params.colormap;
+        constants->round             = params.round_points ? 1.0f : 0.0f;
+    }
+
+    context->SetPipelineState(pso_);
+    context->CommitShaderResources(srb_, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+}
+
+void PointCloudPipeline::draw(IDeviceContext* context, IBuffer* buffer, std::uint32_t count)
+{
+    Uint32   offset  = 0;
+    IBuffer* buffs[] = {buffer};
+    context->SetVertexBuffers(0, 1, buffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+
+    DrawAttribs attr;
+    attr.NumVertices  = 4;
+    attr.NumInstances = count;
+    attr.Flags = DRAW_FLAG_VERIFY_ALL;
+    context->Draw(attr);
+}
+
+}
@@ -1,127 +1,499 @@
 #include <dg/material/dynamic_texture.hpp>
 
+#include <cstring>
+#include <iostream>
 #include <vector>
 //#include <DiligentTools/TextureLoader/interface/TextureUtilities.h>
 #include <DiligentCore/Graphics/GraphicsEngine/interface/Texture.h>
 #include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
 #include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Fence.h>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DG_TEX_CONVERT_X86
+#define DG_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define DG_TEX_CONVERT_NEON
+#include <arm_neon.h>
+#endif
 
 namespace dg {
 
 
-void tex_convert(std::uint32_t  width, std::uint32_t  height, const void* src_data, std::uint32_t  src_stride, void* dest_data, std::uint32_t  dest_stride, DynamicTexture::DataFormat format)
+namespace {
+
+// converts one row of pixels to RGBA8
+using ConvertRow = void (*)(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width);
+
+void copyRow(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
 {
-    switch(format)
+    std::memcpy(dest, src, std::size_t(width)*4);
+}
+
+void grey8RowScalar(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    for(std::uint32_t u=0; u<width; ++u)
     {
-        case DynamicTexture::GREY8:
-        {
-            const std::uint8_t* src  = (const std::uint8_t*)src_data;
-            std::uint8_t* dest = (std::uint8_t*)dest_data;
-            for(int v=0; v<height; ++v, src+=src_stride, dest+=dest_stride)
-            for(int u=0; u<width;  ++u)
-            {
-                unsigned int val = src[u];
-                dest[u*4+0] = val;
-                dest[u*4+1] = val;
-                dest[u*4+2] = val;
-                dest[u*4+3] = 255;
-            }
-            break;
-        }
-        case DynamicTexture::GREY16:
-        {
-            const std::uint16_t* src  = (const std::uint16_t*)src_data;
-            std::uint8_t* dest = (std::uint8_t*)dest_data;
-            for(int v=0; v<height; ++v, src+=src_stride/2, dest+=dest_stride)
-            for(int u=0; u<width;  ++u)
-            {
-                unsigned int val = src[u] / 16;
-                dest[u*4+0] = val;
-                dest[u*4+1] = val;
-                dest[u*4+2] = val;
-                dest[u*4+3] = 255;
-            }
-            break;
-        }
-        case DynamicTexture::RGB8:
-        {
-            const std::uint8_t* src  = (const std::uint8_t*)src_data;
-            std::uint8_t* dest = (std::uint8_t*)dest_data;
-            for(int v=0; v<height; ++v, src+=src_stride, dest+=dest_stride)
-            for(int u=0; u<width;  ++u)
-            {
-                dest[u*4+0] = src[u*3+0];
-                dest[u*4+1] = src[u*3+1];
-                dest[u*4+2] = src[u*3+2];
-                dest[u*4+3] = 255;
-            }
-            break;
-        }
-        case DynamicTexture::RGBA8:
-        {
-            const std::uint8_t* src  = (const std::uint8_t*)src_data;
-            std::uint8_t* dest = (std::uint8_t*)dest_data;
-            for(int v=0; v<height; ++v, src+=src_stride, dest+=dest_stride)
-            for(int u=0; u<width;  ++u)
-            {
-                dest[u*4+0] = src[u*4+0];
-                dest[u*4+1] = src[u*4+1];
-                dest[u*4+2] = src[u*4+2];
-                dest[u*4+3] = src[u*4+3];
-            }
-            break;
-        }
+        std::uint8_t val = src[u];
+        dest[u*4+0] = val;
+        dest[u*4+1] = val;
+        dest[u*4+2] = val;
+        dest[u*4+3] = 255;
+    }
+}
+
+// the 12 significant bits of the camera data are reduced to 8 bits
+void grey16RowScalar(const std::uint8_t* src_bytes, std::uint8_t* dest, std::uint32_t width)
+{
+    const std::uint16_t* src = reinterpret_cast<const std::uint16_t*>(src_bytes);
+    for(std::uint32_t u=0; u<width; ++u)
+    {
+        std::uint8_t val = std::uint8_t(src[u] / 16);
+        dest[u*4+0] = val;
+        dest[u*4+1] = val;
+        dest[u*4+2] = val;
+        dest[u*4+3] = 255;
+    }
+}
+
+void rgb8RowScalar(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    for(std::uint32_t u=0; u<width; ++u)
+    {
+        dest[u*4+0] = src[u*3+0];
+        dest[u*4+1] = src[u*3+1];
+        dest[u*4+2] = src[u*3+2];
+        dest[u*4+3] = 255;
+    }
+}
+
+#ifdef DG_TEX_CONVERT_X86
+
+// SSE2 is part of x86-64, hence these kernels need no target attribute
+
+// expands 16 grey values to 16 RGBA8 pixels
+inline void storeGrey16SSE2(std::uint8_t* dest, __m128i g)
+{
+    const __m128i alpha = _mm_set1_epi8(char(0xFF));
+    __m128i gg_lo = _mm_unpacklo_epi8(g, g);
+    __m128i gg_hi = _mm_unpackhi_epi8(g, g);
+    __m128i ga_lo = _mm_unpacklo_epi8(g, alpha);
+    __m128i ga_hi = _mm_unpackhi_epi8(g, alpha);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),    _mm_unpacklo_epi16(gg_lo, ga_lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest+16), _mm_unpackhi_epi16(gg_lo, ga_lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest+32), _mm_unpacklo_epi16(gg_hi, ga_hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest+48), _mm_unpackhi_epi16(gg_hi, ga_hi));
+}
+
+void grey8RowSSE2(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    std::uint32_t u = 0;
+    for(; u+16<=width; u+=16)
+        storeGrey16SSE2(dest + 4*u, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + u)));
+    grey8RowScalar(src + u, dest + 4*u, width - u);
+}
+
+void grey16RowSSE2(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    const __m128i mask = _mm_set1_epi16(0xFF);
+    std::uint32_t u = 0;
+    for(; u+16<=width; u+=16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*u));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*u + 16));
+        a = _mm_and_si128(_mm_srli_epi16(a, 4), mask);
+        b = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+        storeGrey16SSE2(dest + 4*u, _mm_packus_epi16(a, b));
+    }
+    grey16RowScalar(src + 2*u, dest + 4*u, width - u);
+}
+
+// expands the first 4 RGB8 pixels of the register to RGBA8, SSE2 has no byte shuffle, instead the pixels are shifted
+// into the lowest 32 bit lane and interleaved
+inline __m128i expandRGB4SSE2(__m128i rgb)
+{
+    const __m128i alpha = _mm_set1_epi32(int(0xFF000000u));
+    __m128i p01 = _mm_unpacklo_epi32(rgb, _mm_srli_si128(rgb, 3));
+    __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(rgb, 6), _mm_srli_si128(rgb, 9));
+    return _mm_or_si128(_mm_unpacklo_epi64(p01, p23), alpha);
+}
+
+void rgb8RowSSE2(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    // the second load reads 16 bytes at pixel 4, which ends within pixel 10
+    std::uint32_t u = 0;
+    for(; u+10<=width; u+=8)
+    {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*u));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*u + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4*u),      expandRGB4SSE2(lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4*u + 16), expandRGB4SSE2(hi));
+    }
+    rgb8RowScalar(src + 3*u, dest + 4*u, width - u);
+}
+
+// expands 8 grey values in the lowest byte of the 32 bit lanes to RGBA8 pixels
+DG_TARGET_AVX2 inline __m256i expandGreyAVX2(__m256i g)
+{
+    const __m256i alpha = _mm256_set1_epi32(int(0xFF000000u));
+    return _mm256_or_si256(_mm256_or_si256(g, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(g, 16), alpha));
+}
+
+DG_TARGET_AVX2 void grey8RowAVX2(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    std::uint32_t u = 0;
+    for(; u+8<=width; u+=8)
+    {
+        __m256i g = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + u)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 4*u), expandGreyAVX2(g));
+    }
+    grey8RowScalar(src + u, dest + 4*u, width - u);
+}
+
+DG_TARGET_AVX2 void grey16RowAVX2(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    std::uint32_t u = 0;
+    for(; u+8<=width; u+=8)
+    {
+        __m256i g = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*u)));
+        g = _mm256_and_si256(_mm256_srli_epi32(g, 4), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 4*u), expandGreyAVX2(g));
+    }
+    grey16RowScalar(src + 2*u, dest + 4*u, width - u);
+}
+
+DG_TARGET_AVX2 void rgb8RowAVX2(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    // 4 pixels per 128 bit lane, the alpha bytes are zeroed by the shuffle and set afterwards
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                             0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32(int(0xFF000000u));
+
+    // the second load reads 16 bytes at pixel 4, which ends within pixel 10
+    std::uint32_t u = 0;
+    for(; u+10<=width; u+=8)
+    {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*u));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*u + 12));
+        __m256i rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 4*u),
+                            _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha));
+    }
+    rgb8RowScalar(src + 3*u, dest + 4*u, width - u);
+}
+
+#endif
+
+#ifdef DG_TEX_CONVERT_NEON
+
+void grey8RowNEON(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    std::uint32_t u = 0;
+    for(; u+16<=width; u+=16)
+    {
+        uint8x16_t g = vld1q_u8(src + u);
+        uint8x16x4_t rgba = {{g, g, g, vdupq_n_u8(255)}};
+        vst4q_u8(dest + 4*u, rgba);
+    }
+    grey8RowScalar(src + u, dest + 4*u, width - u);
+}
+
+void grey16RowNEON(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    const std::uint16_t* src16 = reinterpret_cast<const std::uint16_t*>(src);
+    std::uint32_t u = 0;
+    for(; u+16<=width; u+=16)
+    {
+        // the narrowing keeps the low byte, as the scalar conversion
+        uint8x16_t g = vcombine_u8(vmovn_u16(vshrq_n_u16(vld1q_u16(src16 + u), 4)),
+                                   vmovn_u16(vshrq_n_u16(vld1q_u16(src16 + u + 8), 4)));
+        uint8x16x4_t rgba = {{g, g, g, vdupq_n_u8(255)}};
+        vst4q_u8(dest + 4*u, rgba);
+    }
+    grey16RowScalar(src + 2*u, dest + 4*u, width - u);
+}
+
+void rgb8RowNEON(const std::uint8_t* src, std::uint8_t* dest, std::uint32_t width)
+{
+    std::uint32_t u = 0;
+    for(; u+16<=width; u+=16)
+    {
+        uint8x16x3_t rgb = vld3q_u8(src + 3*u);
+        uint8x16x4_t rgba = {{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255)}};
+        vst4q_u8(dest + 4*u, rgba);
+    }
+    rgb8RowScalar(src + 3*u, dest + 4*u, width - u);
+}
+
+#endif
+
+bool isSupported(DynamicTexture::ConvertKernel kernel)
+{
+    switch(kernel)
+    {
+        case DynamicTexture::KERNEL_SCALAR:
+            return true;
+#ifdef DG_TEX_CONVERT_X86
+        case DynamicTexture::KERNEL_SSE2:
+            return true;
+        case DynamicTexture::KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef DG_TEX_CONVERT_NEON
+        case DynamicTexture::KERNEL_NEON:
+            return true;
+#endif
         default:
-            std::cout << "Unsupported format: " << format << std::endl;
-            break;
+            return false;
     }
 }
 
+DynamicTexture::ConvertKernel bestKernel()
+{
+    static const DynamicTexture::ConvertKernel best = []()
+    {
+        for(DynamicTexture::ConvertKernel kernel : {DynamicTexture::KERNEL_AVX2, DynamicTexture::KERNEL_SSE2, DynamicTexture::KERNEL_NEON})
+            if(isSupported(kernel))
+                return kernel;
+        return DynamicTexture::KERNEL_SCALAR;
+    }();
+    return best;
+}
 
-bool DynamicTexture::update(IRenderDevice *device, IDeviceContext *context, const ImageData& data)
+ConvertRow selectRow(DynamicTexture::DataFormat format, DynamicTexture::ConvertKernel kernel)
 {
-    const TEXTURE_FORMAT tex_format = TEX_FORMAT_RGBA8_UNORM_SRGB;
-    const int tex_bytes_per_pixel = 4; // TEX_FORMAT_RGBA8_UNORM_SRGB has 4 bytes per pixel
+    if(format == DynamicTexture::RGBA8)
+        return copyRow;
 
-    if(!texture_) // CREATE
+    switch(kernel)
     {
-        TextureDesc desc;
+#ifdef DG_TEX_CONVERT_X86
+        case DynamicTexture::KERNEL_SSE2:
+            return format == DynamicTexture::GREY8 ? grey8RowSSE2 : format == DynamicTexture::GREY16 ? grey16RowSSE2 : rgb8RowSSE2;
+        case DynamicTexture::KERNEL_AVX2:
+            return format == DynamicTexture::GREY8 ? grey8RowAVX2 : format == DynamicTexture::GREY16 ? grey16RowAVX2 : rgb8RowAVX2;
+#endif
+#ifdef DG_TEX_CONVERT_NEON
+        case DynamicTexture::KERNEL_NEON:
+            return format == DynamicTexture::GREY8 ? grey8RowNEON : format == DynamicTexture::GREY16 ? grey16RowNEON : rgb8RowNEON;
+#endif
+        default:
+            return format == DynamicTexture::GREY8 ? grey8RowScalar : format == DynamicTexture::GREY16 ? grey16RowScalar : rgb8RowScalar;
+    }
+}
 
-        desc.Name      = "DynamicTexture";
-        desc.Type      = dg::RESOURCE_DIM_TEX_2D;
-        desc.Width     = data.width;
-        desc.Height    = data.height;
-        desc.MipLevels = 1;
-        desc.Usage          = dg::USAGE_DEFAULT;
-        desc.BindFlags      = dg::BIND_SHADER_RESOURCE;
-        desc.Format         = tex_format;
-        desc.CPUAccessFlags = dg::CPU_ACCESS_WRITE; //CPU_ACCESS_NONE;
+}
 
 
-        buffer_.resize(data.width*data.height*tex_bytes_per_pixel);
+std::vector<DynamicTexture::ConvertKernel> DynamicTexture::getSupportedKernels()
+{
+    std::vector<ConvertKernel> kernels;
+    for(ConvertKernel kernel : {KERNEL_SCALAR, KERNEL_SSE2, KERNEL_AVX2, KERNEL_NEON})
+        if(isSupported(kernel))
+            kernels.push_back(kernel);
+    return kernels;
+}
 
-        tex_convert(data.width, data.height, data.data, data.stride, buffer_.data(), data.width*tex_bytes_per_pixel, data.format);
+const char* DynamicTexture::getKernelName(ConvertKernel kernel)
+{
+    switch(kernel)
+    {
+        case KERNEL_AUTO:   return "auto";
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_SSE2:   return "SSE2";
+        case KERNEL_AVX2:   return "AVX2";
+        case KERNEL_NEON:   return "NEON";
+    }
+    return "unknown";
+}
 
-        TextureSubResData sub_data;
-        sub_data.pData = buffer_.data();
-        sub_data.Stride = data.width*tex_bytes_per_pixel;
+void DynamicTexture::convert(const ImageData& data, void* dest_data, std::uint32_t dest_stride, ConvertKernel kernel)
+{
+    if(data.format != GREY8 && data.format != GREY16 && data.format != RGB8 && data.format != RGBA8)
+    {
+        std::cout << "Unsupported format: " << data.format << std::endl;
+        return;
+    }
+
+    if(kernel == KERNEL_AUTO || !isSupported(kernel))
+        kernel = bestKernel();
 
-        TextureData tex_data;
-        tex_data.pSubResources   = &sub_data;
-        tex_data.NumSubresources = 1;
+    const std::uint8_t* src = static_cast<const std::uint8_t*>(data.data);
+    std::uint8_t* dest = static_cast<std::uint8_t*>(dest_data);
 
-        device->CreateTexture(desc, &tex_data, &texture_);
+    // tightly packed RGBA8 images are copied at once
+    if(data.format == RGBA8 && data.stride == dest_stride && dest_stride == data.width*4)
+    {
+        std::memcpy(dest, src, std::size_t(dest_stride)*data.height);
+        return;
     }
-    else // UPDATE
+
+    ConvertRow row = selectRow(data.format, kernel);
+    for(std::uint32_t v=0; v<data.height; ++v)
+        row(src + std::size_t(v)*data.stride, dest + std::size_t(v)*dest_stride, data.width);
+}
+
+
+float DynamicTexture::getValueScale() const
+{
+    return format_ == GREY16 || format_ == GREY_ALPHA16 ? 65535.0f / 4095.0f : 1.0f;
+}
+
+namespace {
+
+std::uint32_t bytesPerPixel(DynamicTexture::DataFormat format)
+{
+    switch(format)
     {
-        const TextureDesc& desc = texture_->GetDesc();
+        case DynamicTexture::GREY8:        return 1;
+        case DynamicTexture::GREY16:       return 2;
+        case DynamicTexture::RGB8:         return 3;
+        case DynamicTexture::GREY_ALPHA8:  return 2;
+        case DynamicTexture::YUYV:         return 2;
+        case DynamicTexture::GREY_ALPHA16:
+        case DynamicTexture::RGBA8:        return 4;
+        default:                           return 1; // of the luma plane of NV12 and I420 images
+    }
+}
+
+// images with chroma planes, which are stored below the luma plane in the texture
+bool isPlanar(DynamicTexture::DataFormat format)
+{
+    return format == DynamicTexture::NV12 || format == DynamicTexture::I420;
+}
+
+std::uint32_t textureHeight(DynamicTexture::DataFormat format, std::uint32_t height)
+{
+    return isPlanar(format) ? height + (height + 1) / 2 : height;
+}
+
+TEXTURE_FORMAT textureFormat(DynamicTexture::DataFormat format)
+{
+    switch(format)
+    {
+        case DynamicTexture::GREY8:        return TEX_FORMAT_R8_UNORM;
+        case DynamicTexture::GREY16:       return TEX_FORMAT_R16_UNORM;
+        case DynamicTexture::GREY_ALPHA8:  return TEX_FORMAT_RG8_UNORM;
+        case DynamicTexture::GREY_ALPHA16: return TEX_FORMAT_RG16_UNORM;
+        case DynamicTexture::NV12:
+        case DynamicTexture::I420:
+        case DynamicTexture::BAYER_RGGB:
+        case DynamicTexture::BAYER_BGGR:
+        case DynamicTexture::BAYER_GRBG:
+        case DynamicTexture::BAYER_GBRG:   return TEX_FORMAT_R8_UNORM;
+        case DynamicTexture::YUYV:         return TEX_FORMAT_RG8_UNORM;
+        default:                           return TEX_FORMAT_RGBA8_UNORM_SRGB;
+    }
+}
+
+}
+
+bool DynamicTexture::createTexture(IRenderDevice* device, std::uint32_t width, std::uint32_t height, DataFormat format,
+                                   TextureSubResData* data)
+{
+    if(!slots_.empty())
+    {
+        // the textures are bound by their users, hence they cannot be replaced
+        const TextureDesc& desc = slots_[0].texture->GetDesc();
+        return desc.Width == width && desc.Height == textureHeight(format, height) && desc.Format == textureFormat(format);
+    }
 
-        if(desc.Width != data.width || desc.Height != data.height)
+    TextureDesc desc;
+
+    desc.Name      = "DynamicTexture";
+    desc.Type      = dg::RESOURCE_DIM_TEX_2D;
+    desc.Width     = width;
+    desc.Height    = textureHeight(format, height);
+    desc.MipLevels = 1;
+    desc.Usage          = dg::USAGE_DEFAULT;
+    desc.BindFlags      = dg::BIND_SHADER_RESOURCE;
+    desc.Format         = textureFormat(format);
+    desc.CPUAccessFlags = dg::CPU_ACCESS_WRITE; //CPU_ACCESS_NONE;
+
+    TextureData tex_data;
+    tex_data.pSubResources   = data;
+    tex_data.NumSubresources = data ? 1 : 0;
+
+    // the first texture is the current one, the others are written before they are used
+    std::vector<Slot> slots(buffer_count_);
+    for(std::size_t i=0; i<slots.size(); ++i)
+    {
+        device->CreateTexture(desc, data && i==0 ? &tex_data : nullptr, &slots[i].texture);
+        if(!slots[i].texture)
             return false;
+    }
+
+    slots_.swap(slots);
+    current_ = 0;
+    ++version_;
+    return true;
+}
+
+bool DynamicTexture::update(IRenderDevice *device, IDeviceContext *context, const ImageData& data)
+{
+    if(isPlanar(data.format))
+        return updatePlanes(device, context, data);
+
+    if(change_tile_size_ > 0 && !previous_.empty() && previous_desc_.width == data.width &&
+       previous_desc_.height == data.height && previous_desc_.format == data.format)
+        return updateChangedTiles(device, context, data);
+
+    if(!updateImage(device, context, data))
+        return false;
+
+    if(change_tile_size_ > 0)
+        storePrevious(data, Rect{0, 0, data.width, data.height});
+    return true;
+}
+
+bool DynamicTexture::updateImage(IRenderDevice *device, IDeviceContext *context, const ImageData& data)
+{
+    if(isPlanar(data.format))
+        return updatePlanes(device, context, data);
+
+    // RGB8 images are converted straight into the staging texture, as there is no 24 bit texture format
+    if(data.format == RGB8 && !staging_failed_)
+    {
+        MappedImage image = acquire(device, context, data.width, data.height, data.format);
+        if(image.data)
+        {
+            convert(data, image.data, image.stride);
+            submit(context);
+            format_ = data.format;
+            return true;
+        }
+        if(!staging_failed_)
+            return false; // the size or format differs, or an image is acquired
+    }
 
+    // the other images are uploaded from the memory of the caller without conversion
+    TextureSubResData sub_data;
+    if(data.format == RGB8)
+    {
+        const int tex_bytes_per_pixel = 4;
         buffer_.resize(data.width*data.height*tex_bytes_per_pixel);
-        tex_convert(data.width,data.height,data.data,data.stride, buffer_.data(),data.width*tex_bytes_per_pixel, data.format);
+        convert(data, buffer_.data(), data.width*tex_bytes_per_pixel);
+
+        sub_data.pData = buffer_.data();
+        sub_data.Stride = data.width*tex_bytes_per_pixel;
+    }
+    else
+    {
+        sub_data.pData = data.data;
+        sub_data.Stride = data.stride;
+    }
+
+    if(slots_.empty()) // CREATE
+    {
+        if(!createTexture(device, data.width, data.height, data.format, &sub_data))
+            return false;
+    }
+    else // UPDATE
+    {
+        if(mapped_slot_ >= 0 || !createTexture(device, data.width, data.height, data.format, nullptr))
+            return false;
 
         Box update_box;
         update_box.MinX = 0;
@@ -129,13 +501,330 @@ bool DynamicTexture::update(IRenderDevice *device, IDeviceContext *context, cons
         update_box.MaxX = data.width;
         update_box.MaxY = data.height;
 
-        TextureSubResData subres_data;
-        subres_data.Stride = data.width * tex_bytes_per_pixel;
-        subres_data.pData  = buffer_.data();
-        context->UpdateTexture(texture_, 0, 0, update_box, subres_data, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        // into the next texture, while the GPU may still draw the current one
+        std::size_t slot = (current_ + 1) % slots_.size();
+        context->UpdateTexture(slots_[slot].texture, 0, 0, update_box, sub_data, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+        if(slot != current_)
+        {
+            current_ = slot;
+            ++version_;
+        }
+    }
+
+    format_ = data.format;
+    return true;
+}
+
+bool DynamicTexture::updatePlanes(IRenderDevice* device, IDeviceContext* context, const ImageData& data)
+{
+    if(mapped_slot_ >= 0 || !createTexture(device, data.width, data.height, data.format, nullptr))
+        return false;
+
+    const std::uint8_t* luma = static_cast<const std::uint8_t*>(data.data);
+    const std::uint32_t chroma_width = data.width / 2;
+    const std::uint32_t chroma_height = (data.height + 1) / 2;
+
+    // each plane is uploaded from the memory of the caller into its area of the texture
+    struct Plane
+    {
+        const void* data;
+        std::uint32_t stride;
+        Box box;
+    };
+    std::vector<Plane> planes;
+    planes.push_back(Plane{luma, data.stride, Box(0, data.width, 0, data.height)});
+
+    if(data.format == NV12)
+    {
+        const void* uv = data.planes[0] ? data.planes[0] : luma + std::size_t(data.stride)*data.height;
+        std::uint32_t uv_stride = data.plane_strides[0] ? data.plane_strides[0] : data.stride;
+        planes.push_back(Plane{uv, uv_stride, Box(0, data.width, data.height, data.height + chroma_height)});
+    }
+    else
+    {
+        const std::uint8_t* u = data.planes[0] ? static_cast<const std::uint8_t*>(data.planes[0]) :
+                                                 luma + std::size_t(data.stride)*data.height;
+        std::uint32_t u_stride = data.plane_strides[0] ? data.plane_strides[0] : data.stride / 2;
+        const void* v = data.planes[1] ? data.planes[1] : u + std::size_t(u_stride)*chroma_height;
+        std::uint32_t v_stride = data.plane_strides[1] ? data.plane_strides[1] : u_stride;
+        planes.push_back(Plane{u, u_stride, Box(0, chroma_width, data.height, data.height + chroma_height)});
+        planes.push_back(Plane{v, v_stride, Box(chroma_width, 2*chroma_width, data.height, data.height + chroma_height)});
+    }
+
+    // into the next texture, while the GPU may still draw the current one
+    std::size_t slot = (current_ + 1) % slots_.size();
+    for(const Plane& plane : planes)
+    {
+        TextureSubResData sub_data;
+        sub_data.pData = plane.data;
+        sub_data.Stride = plane.stride;
+        context->UpdateTexture(slots_[slot].texture, 0, 0, plane.box, sub_data, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    }
+
+    if(slot != current_)
+    {
+        current_ = slot;
+        ++version_;
+    }
+
+    format_ = data.format;
+    previous_.clear();
+    return true;
+}
+
+DynamicTexture::MappedImage DynamicTexture::acquire(IRenderDevice* device, IDeviceContext* context,
+                                                    std::uint32_t width, std::uint32_t height, DataFormat format)
+{
+    MappedImage image;
+    if(staging_failed_ || mapped_slot_ >= 0 || !createTexture(device, width, height, format, nullptr))
+        return image;
+
+    if(!staging_fence_)
+    {
+        device->CreateFence(FenceDesc{}, &staging_fence_);
+        if(!staging_fence_)
+        {
+            staging_failed_ = true;
+            return image;
+        }
+    }
+
+    std::size_t slot = (current_ + 1) % slots_.size();
+    Slot& next = slots_[slot];
+    if(!next.staging)
+    {
+        TextureDesc desc = next.texture->GetDesc();
+        desc.Name           = "DynamicTexture staging";
+        desc.Usage          = USAGE_STAGING;
+        desc.BindFlags      = BIND_NONE;
+        desc.CPUAccessFlags = CPU_ACCESS_WRITE;
+        device->CreateTexture(desc, nullptr, &next.staging);
+        if(!next.staging)
+        {
+            staging_failed_ = true;
+            return image;
+        }
+    }
+
+    // the GPU must have finished the previous copy of this staging texture, which only blocks if the producer is
+    // more images ahead of the GPU than there are buffers
+    if(staging_fence_->GetCompletedValue() < next.fence_value)
+        context->WaitForFence(staging_fence_, next.fence_value, true);
+
+    MappedTextureSubresource mapped;
+    context->MapTextureSubresource(next.staging, 0, 0, MAP_WRITE, MAP_FLAG_NONE, nullptr, mapped);
+    if(!mapped.pData)
+    {
+        staging_failed_ = true;
+        return image;
     }
 
+    mapped_slot_ = int(slot);
+    image.data = mapped.pData;
+    image.stride = std::uint32_t(mapped.Stride);
+    image.width = width;
+    image.height = height;
+    image.format = format == RGB8 ? RGBA8 : format;
+    format_ = image.format;
+    return image;
+}
+
+bool DynamicTexture::submit(IDeviceContext* context)
+{
+    if(mapped_slot_ < 0)
+        return false;
+
+    Slot& slot = slots_[mapped_slot_];
+    context->UnmapTextureSubresource(slot.staging, 0, 0);
+
+    CopyTextureAttribs copy(slot.staging, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                            slot.texture, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    context->CopyTexture(copy);
+
+    slot.fence_value = ++staging_fence_value_;
+    context->SignalFence(staging_fence_, slot.fence_value);
+
+    if(std::size_t(mapped_slot_) != current_)
+    {
+        current_ = std::size_t(mapped_slot_);
+        ++version_;
+    }
+    mapped_slot_ = -1;
+
+    // the image was written by the producer, hence the next update() cannot compare with the previous image
+    previous_.clear();
+    return true;
+}
+
+bool DynamicTexture::updateRegion(IRenderDevice* device, IDeviceContext* context, const ImageData& data, const Rect& rect)
+{
+    if(slots_.empty() || isPlanar(data.format))
+        return update(device, context, data);
+
+    if(mapped_slot_ >= 0 || !createTexture(device, data.width, data.height, data.format, nullptr))
+        return false;
+
+    Rect clipped = clip(data, rect);
+    if(clipped.width == 0 || clipped.height == 0)
+        return true;
+
+    std::size_t slot = copyForward(context);
+    uploadRegion(context, slot, data, clipped);
+    makeCurrent(slot, data.format);
     return true;
 }
 
+DynamicTexture::Rect DynamicTexture::clip(const ImageData& data, const Rect& rect)
+{
+    std::uint32_t x0 = std::min(rect.x, data.width);
+    std::uint32_t y0 = std::min(rect.y, data.height);
+    std::uint32_t x1 = std::min(rect.x + rect.width, data.width);
+    std::uint32_t y1 = std::min(rect.y + rect.height, data.height);
+    return Rect{x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0};
+}
+
+std::size_t DynamicTexture::copyForward(IDeviceContext* context)
+{
+    // the regions are written into the next texture, while the GPU may still draw the current one, hence the next
+    // texture gets the unchanged pixels from the current one on the GPU
+    std::size_t slot = (current_ + 1) % slots_.size();
+    if(slot != current_)
+    {
+        CopyTextureAttribs copy(slots_[current_].texture, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                slots_[slot].texture, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        context->CopyTexture(copy);
+    }
+    return slot;
+}
+
+void DynamicTexture::makeCurrent(std::size_t slot, DataFormat format)
+{
+    if(slot != current_)
+    {
+        current_ = slot;
+        ++version_;
+    }
+    format_ = format;
+}
+
+void DynamicTexture::uploadRegion(IDeviceContext* context, std::size_t slot, const ImageData& data, const Rect& rect)
+{
+    ImageData region = data;
+    region.data = static_cast<const std::uint8_t*>(data.data) + std::size_t(rect.y)*data.stride + std::size_t(rect.x)*bytesPerPixel(data.format);
+    region.width = rect.width;
+    region.height = rect.height;
+
+    TextureSubResData sub_data;
+    if(data.format == RGB8)
+    {
+        const int tex_bytes_per_pixel = 4;
+        buffer_.resize(region.width*region.height*tex_bytes_per_pixel);
+        convert(region, buffer_.data(), region.width*tex_bytes_per_pixel);
+
+        sub_data.pData = buffer_.data();
+        sub_data.Stride = region.width*tex_bytes_per_pixel;
+    }
+    else
+    {
+        sub_data.pData = region.data;
+        sub_data.Stride = data.stride;
+    }
+
+    Box update_box;
+    update_box.MinX = rect.x;
+    update_box.MinY = rect.y;
+    update_box.MaxX = rect.x + rect.width;
+    update_box.MaxY = rect.y + rect.height;
+
+    context->UpdateTexture(slots_[slot].texture, 0, 0, update_box, sub_data, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    // a region of an image of another size or format would leave the rest of previous_ stale
+    if(!previous_.empty() && previous_desc_.width == data.width && previous_desc_.height == data.height &&
+       previous_desc_.format == data.format)
+        storePrevious(data, rect);
+    else
+        previous_.clear();
+}
+
+bool DynamicTexture::updateChangedTiles(IRenderDevice* device, IDeviceContext* context, const ImageData& data)
+{
+    if(mapped_slot_ >= 0 || !createTexture(device, data.width, data.height, data.format, nullptr))
+        return false;
+
+    const std::uint32_t tile = change_tile_size_;
+    const std::size_t bytes_per_pixel = bytesPerPixel(data.format);
+    const std::size_t row_size = std::size_t(data.width)*bytes_per_pixel;
+    const std::uint32_t tiles_x = (data.width + tile - 1) / tile;
+
+    const std::uint8_t* src = static_cast<const std::uint8_t*>(data.data);
+
+    // changed tiles, adjacent tiles of a tile row are merged into one rectangle
+    std::vector<Rect> rects;
+    std::vector<bool> dirty(tiles_x);
+    for(std::uint32_t y0=0; y0<data.height; y0+=tile)
+    {
+        std::uint32_t y1 = std::min(y0 + tile, data.height);
+        std::fill(dirty.begin(), dirty.end(), false);
+
+        for(std::uint32_t y=y0; y<y1; ++y)
+        {
+            const std::uint8_t* row = src + std::size_t(y)*data.stride;
+            const std::uint8_t* previous_row = previous_.data() + std::size_t(y)*row_size;
+            if(std::memcmp(row, previous_row, row_size) == 0)
+                continue;
+
+            for(std::uint32_t tx=0; tx<tiles_x; ++tx)
+            {
+                if(dirty[tx])
+                    continue;
+                std::size_t begin = std::size_t(tx)*tile*bytes_per_pixel;
+                std::size_t end = std::min(begin + tile*bytes_per_pixel, row_size);
+                dirty[tx] = std::memcmp(row + begin, previous_row + begin, end - begin) != 0;
+            }
+        }
+
+        for(std::uint32_t tx=0; tx<tiles_x; )
+        {
+            if(!dirty[tx])
+            {
+                ++tx;
+                continue;
+            }
+            std::uint32_t first = tx;
+            while(tx < tiles_x && dirty[tx])
+                ++tx;
+            rects.push_back(clip(data, Rect{first*tile, y0, (tx - first)*tile, y1 - y0}));
+        }
+    }
+
+    if(rects.empty())
+        return true;
+
+    // all tiles go into the same texture, which becomes the current one
+    std::size_t slot = copyForward(context);
+    for(const Rect& rect : rects)
+        uploadRegion(context, slot, data, rect);
+    makeCurrent(slot, data.format);
+    return true;
+}
+
+void DynamicTexture::storePrevious(const ImageData& data, const Rect& rect)
+{
+    const std::size_t bytes_per_pixel = bytesPerPixel(data.format);
+    const std::size_t row_size = std::size_t(data.width)*bytes_per_pixel;
+    if(previous_.size() != row_size*data.height || previous_desc_.width != data.width ||
+       previous_desc_.height != data.height || previous_desc_.format != data.format)
+    {
+        previous_.resize(row_size*data.height);
+        previous_desc_ = data;
+        previous_desc_.data = nullptr;
+    }
+
+    const std::uint8_t* src = static_cast<const std::uint8_t*>(data.data);
+    for(std::uint32_t y=rect.y; y<rect.y+rect.height; ++y)
+        std::memcpy(previous_.data() + y*row_size + rect.x*bytes_per_pixel,
+                    src + std::size_t(y)*data.stride + rect.x*bytes_per_pixel, rect.width*bytes_per_pixel);
+}
+
 }
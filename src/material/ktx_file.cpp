@@ -0,0 +1,543 @@
+#include <dg/material/ktx_file.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsAccessories/interface/GraphicsAccessories.hpp>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef DG_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace dg {
+
+static const std::uint8_t g_ktx1_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+static const std::uint8_t g_ktx2_identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+struct KTX1Header
+{
+    std::uint8_t  identifier[12];
+    std::uint32_t endianness;
+    std::uint32_t gl_type;
+    std::uint32_t gl_type_size;
+    std::uint32_t gl_format;
+    std::uint32_t gl_internal_format;
+    std::uint32_t gl_base_internal_format;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t depth;
+    std::uint32_t number_of_array_elements;
+    std::uint32_t number_of_faces;
+    std::uint32_t number_of_mipmap_levels;
+    std::uint32_t bytes_of_key_value_data;
+};
+
+struct KTX2Header
+{
+    std::uint8_t  identifier[12];
+    std::uint32_t vk_format;
+    std::uint32_t type_size;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t depth;
+    std::uint32_t layer_count;
+    std::uint32_t face_count;
+    std::uint32_t level_count;
+    std::uint32_t supercompression_scheme;
+    std::uint32_t dfd_byte_offset;
+    std::uint32_t dfd_byte_length;
+    std::uint32_t kvd_byte_offset;
+    std::uint32_t kvd_byte_length;
+    std::uint64_t sgd_byte_offset;
+    std::uint64_t sgd_byte_length;
+};
+
+struct KTX2Level
+{
+    std::uint64_t byte_offset;
+    std::uint64_t byte_length;
+    std::uint64_t uncompressed_byte_length;
+};
+
+static_assert(sizeof(KTX1Header) == 64, "unexpected KTX 1.0 header size");
+static_assert(sizeof(KTX2Header) == 80, "unexpected KTX 2.0 header size");
+static_assert(sizeof(KTX2Level) == 24, "unexpected KTX 2.0 level size");
+
+// numbers the temporary files of the writes in this process (the IBL cache is written from worker threads)
+static std::atomic<unsigned int> g_tmp_counter(0);
+
+static std::uint64_t align4(std::uint64_t size)
+{
+    return (size + 3) & ~std::uint64_t(3);
+}
+
+// sized internal formats of OpenGL
+static TEXTURE_FORMAT glFormatToTextureFormat(std::uint32_t format)
+{
+    switch(format)
+    {
+        case 0x8229: return TEX_FORMAT_R8_UNORM;           // GL_R8
+        case 0x8F94: return TEX_FORMAT_R8_SNORM;           // GL_R8_SNORM
+        case 0x8232: return TEX_FORMAT_R8_UINT;            // GL_R8UI
+        case 0x822B: return TEX_FORMAT_RG8_UNORM;          // GL_RG8
+        case 0x8F95: return TEX_FORMAT_RG8_SNORM;          // GL_RG8_SNORM
+        case 0x8238: return TEX_FORMAT_RG8_UINT;           // GL_RG8UI
+        case 0x8058: return TEX_FORMAT_RGBA8_UNORM;        // GL_RGBA8
+        case 0x8C43: return TEX_FORMAT_RGBA8_UNORM_SRGB;   // GL_SRGB8_ALPHA8
+        case 0x8F97: return TEX_FORMAT_RGBA8_SNORM;        // GL_RGBA8_SNORM
+        case 0x8D7C: return TEX_FORMAT_RGBA8_UINT;         // GL_RGBA8UI
+        case 0x822A: return TEX_FORMAT_R16_UNORM;          // GL_R16
+        case 0x8F98: return TEX_FORMAT_R16_SNORM;          // GL_R16_SNORM
+        case 0x8234: return TEX_FORMAT_R16_UINT;           // GL_R16UI
+        case 0x822D: return TEX_FORMAT_R16_FLOAT;          // GL_R16F
+        case 0x822C: return TEX_FORMAT_RG16_UNORM;         // GL_RG16
+        case 0x8F99: return TEX_FORMAT_RG16_SNORM;         // GL_RG16_SNORM
+        case 0x823A: return TEX_FORMAT_RG16_UINT;          // GL_RG16UI
+        case 0x822F: return TEX_FORMAT_RG16_FLOAT;         // GL_RG16F
+        case 0x805B: return TEX_FORMAT_RGBA16_UNORM;       // GL_RGBA16
+        case 0x8F9B: return TEX_FORMAT_RGBA16_SNORM;       // GL_RGBA16_SNORM
+        case 0x8D76: return TEX_FORMAT_RGBA16_UINT;        // GL_RGBA16UI
+        case 0x881A: return TEX_FORMAT_RGBA16_FLOAT;       // GL_RGBA16F
+        case 0x8236: return TEX_FORMAT_R32_UINT;           // GL_R32UI
+        case 0x822E: return TEX_FORMAT_R32_FLOAT;          // GL_R32F
+        case 0x823C: return TEX_FORMAT_RG32_UINT;          // GL_RG32UI
+        case 0x8230: return TEX_FORMAT_RG32_FLOAT;         // GL_RG32F
+        case 0x8815: return TEX_FORMAT_RGB32_FLOAT;        // GL_RGB32F
+        case 0x8D70: return TEX_FORMAT_RGBA32_UINT;        // GL_RGBA32UI
+        case 0x8814: return TEX_FORMAT_RGBA32_FLOAT;       // GL_RGBA32F
+        case 0x8059: return TEX_FORMAT_RGB10A2_UNORM;      // GL_RGB10_A2
+        case 0x8C3A: return TEX_FORMAT_R11G11B10_FLOAT;    // GL_R11F_G11F_B10F
+        case 0x8C3D: return TEX_FORMAT_RGB9E5_SHAREDEXP;   // GL_RGB9_E5
+        case 0x83F0:                                       // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+        case 0x83F1: return TEX_FORMAT_BC1_UNORM;          // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+        case 0x8C4C:                                       // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+        case 0x8C4D: return TEX_FORMAT_BC1_UNORM_SRGB;     // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+        case 0x83F2: return TEX_FORMAT_BC2_UNORM;          // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+        case 0x8C4E: return TEX_FORMAT_BC2_UNORM_SRGB;     // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+        case 0x83F3: return TEX_FORMAT_BC3_UNORM;          // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+        case 0x8C4F: return TEX_FORMAT_BC3_UNORM_SRGB;     // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+        case 0x8DBB: return TEX_FORMAT_BC4_UNORM;          // GL_COMPRESSED_RED_RGTC1
+        case 0x8DBC: return TEX_FORMAT_BC4_SNORM;          // GL_COMPRESSED_SIGNED_RED_RGTC1
+        case 0x8DBD: return TEX_FORMAT_BC5_UNORM;          // GL_COMPRESSED_RG_RGTC2
+        case 0x8DBE: return TEX_FORMAT_BC5_SNORM;          // GL_COMPRESSED_SIGNED_RG_RGTC2
+        case 0x8E8F: return TEX_FORMAT_BC6H_UF16;          // GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+        case 0x8E8E: return TEX_FORMAT_BC6H_SF16;          // GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
+        case 0x8E8C: return TEX_FORMAT_BC7_UNORM;          // GL_COMPRESSED_RGBA_BPTC_UNORM
+        case 0x8E8D: return TEX_FORMAT_BC7_UNORM_SRGB;     // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+        default:     return TEX_FORMAT_UNKNOWN;
+    }
+}
+
+static TEXTURE_FORMAT vkFormatToTextureFormat(std::uint32_t format)
+{
+    switch(format)
+    {
+        case 9:   return TEX_FORMAT_R8_UNORM;              // VK_FORMAT_R8_UNORM
+        case 10:  return TEX_FORMAT_R8_SNORM;              // VK_FORMAT_R8_SNORM
+        case 13:  return TEX_FORMAT_R8_UINT;               // VK_FORMAT_R8_UINT
+        case 16:  return TEX_FORMAT_RG8_UNORM;             // VK_FORMAT_R8G8_UNORM
+        case 17:  return TEX_FORMAT_RG8_SNORM;             // VK_FORMAT_R8G8_SNORM
+        case 20:  return TEX_FORMAT_RG8_UINT;              // VK_FORMAT_R8G8_UINT
+        case 37:  return TEX_FORMAT_RGBA8_UNORM;           // VK_FORMAT_R8G8B8A8_UNORM
+        case 38:  return TEX_FORMAT_RGBA8_SNORM;           // VK_FORMAT_R8G8B8A8_SNORM
+        case 41:  return TEX_FORMAT_RGBA8_UINT;            // VK_FORMAT_R8G8B8A8_UINT
+        case 43:  return TEX_FORMAT_RGBA8_UNORM_SRGB;      // VK_FORMAT_R8G8B8A8_SRGB
+        case 44:  return TEX_FORMAT_BGRA8_UNORM;           // VK_FORMAT_B8G8R8A8_UNORM
+        case 50:  return TEX_FORMAT_BGRA8_UNORM_SRGB;      // VK_FORMAT_B8G8R8A8_SRGB
+        case 64:  return TEX_FORMAT_RGB10A2_UNORM;         // VK_FORMAT_A2B10G10R10_UNORM_PACK32
+        case 70:  return TEX_FORMAT_R16_UNORM;             // VK_FORMAT_R16_UNORM
+        case 71:  return TEX_FORMAT_R16_SNORM;             // VK_FORMAT_R16_SNORM
+        case 74:  return TEX_FORMAT_R16_UINT;              // VK_FORMAT_R16_UINT
+        case 76:  return TEX_FORMAT_R16_FLOAT;             // VK_FORMAT_R16_SFLOAT
+        case 77:  return TEX_FORMAT_RG16_UNORM;            // VK_FORMAT_R16G16_UNORM
+        case 78:  return TEX_FORMAT_RG16_SNORM;            // VK_FORMAT_R16G16_SNORM
+        case 81:  return TEX_FORMAT_RG16_UINT;             // VK_FORMAT_R16G16_UINT
+        case 83:  return TEX_FORMAT_RG16_FLOAT;            // VK_FORMAT_R16G16_SFLOAT
+        case 91:  return TEX_FORMAT_RGBA16_UNORM;          // VK_FORMAT_R16G16B16A16_UNORM
+        case 92:  return TEX_FORMAT_RGBA16_SNORM;          // VK_FORMAT_R16G16B16A16_SNORM
+        case 95:  return TEX_FORMAT_RGBA16_UINT;           // VK_FORMAT_R16G16B16A16_UINT
+        case 97:  return TEX_FORMAT_RGBA16_FLOAT;          // VK_FORMAT_R16G16B16A16_SFLOAT
+        case 98:  return TEX_FORMAT_R32_UINT;              // VK_FORMAT_R32_UINT
+        case 100: return TEX_FORMAT_R32_FLOAT;             // VK_FORMAT_R32_SFLOAT
+        case 101: return TEX_FORMAT_RG32_UINT;             // VK_FORMAT_R32G32_UINT
+        case 103: return TEX_FORMAT_RG32_FLOAT;            // VK_FORMAT_R32G32_SFLOAT
+        case 106: return TEX_FORMAT_RGB32_FLOAT;           // VK_FORMAT_R32G32B32_SFLOAT
+        case 107: return TEX_FORMAT_RGBA32_UINT;           // VK_FORMAT_R32G32B32A32_UINT
+        case 109: return TEX_FORMAT_RGBA32_FLOAT;          // VK_FORMAT_R32G32B32A32_SFLOAT
+        case 122: return TEX_FORMAT_R11G11B10_FLOAT;       // VK_FORMAT_B10G11R11_UFLOAT_PACK32
+        case 123: return TEX_FORMAT_RGB9E5_SHAREDEXP;      // VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+        case 131:                                          // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        case 133: return TEX_FORMAT_BC1_UNORM;             // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        case 132:                                          // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+        case 134: return TEX_FORMAT_BC1_UNORM_SRGB;        // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+        case 135: return TEX_FORMAT_BC2_UNORM;             // VK_FORMAT_BC2_UNORM_BLOCK
+        case 136: return TEX_FORMAT_BC2_UNORM_SRGB;        // VK_FORMAT_BC2_SRGB_BLOCK
+        case 137: return TEX_FORMAT_BC3_UNORM;             // VK_FORMAT_BC3_UNORM_BLOCK
+        case 138: return TEX_FORMAT_BC3_UNORM_SRGB;        // VK_FORMAT_BC3_SRGB_BLOCK
+        case 139: return TEX_FORMAT_BC4_UNORM;             // VK_FORMAT_BC4_UNORM_BLOCK
+        case 140: return TEX_FORMAT_BC4_SNORM;             // VK_FORMAT_BC4_SNORM_BLOCK
+        case 141: return TEX_FORMAT_BC5_UNORM;             // VK_FORMAT_BC5_UNORM_BLOCK
+        case 142: return TEX_FORMAT_BC5_SNORM;             // VK_FORMAT_BC5_SNORM_BLOCK
+        case 143: return TEX_FORMAT_BC6H_UF16;             // VK_FORMAT_BC6H_UFLOAT_BLOCK
+        case 144: return TEX_FORMAT_BC6H_SF16;             // VK_FORMAT_BC6H_SFLOAT_BLOCK
+        case 145: return TEX_FORMAT_BC7_UNORM;             // VK_FORMAT_BC7_UNORM_BLOCK
+        case 146: return TEX_FORMAT_BC7_UNORM_SRGB;        // VK_FORMAT_BC7_SRGB_BLOCK
+        default:  return TEX_FORMAT_UNKNOWN;
+    }
+}
+
+static std::uint32_t textureFormatToVkFormat(TEXTURE_FORMAT format)
+{
+    // downwards, so that the RGBA variants of BC1 are preferred
+    for(std::uint32_t vk_format=200; vk_format>0; --vk_format)
+        if(vkFormatToTextureFormat(vk_format) == format)
+            return vk_format;
+    return 0;
+}
+
+// size of the components for the byte order (KTX 2.0 typeSize)
+static std::uint32_t typeSize(TEXTURE_FORMAT format)
+{
+    switch(format)
+    {
+        case TEX_FORMAT_R16_UNORM: case TEX_FORMAT_R16_SNORM: case TEX_FORMAT_R16_UINT: case TEX_FORMAT_R16_FLOAT:
+        case TEX_FORMAT_RG16_UNORM: case TEX_FORMAT_RG16_SNORM: case TEX_FORMAT_RG16_UINT: case TEX_FORMAT_RG16_FLOAT:
+        case TEX_FORMAT_RGBA16_UNORM: case TEX_FORMAT_RGBA16_SNORM: case TEX_FORMAT_RGBA16_UINT: case TEX_FORMAT_RGBA16_FLOAT:
+            return 2;
+        case TEX_FORMAT_R32_UINT: case TEX_FORMAT_R32_FLOAT: case TEX_FORMAT_RG32_UINT: case TEX_FORMAT_RG32_FLOAT:
+        case TEX_FORMAT_RGB32_FLOAT: case TEX_FORMAT_RGBA32_UINT: case TEX_FORMAT_RGBA32_FLOAT:
+        case TEX_FORMAT_RGB10A2_UNORM: case TEX_FORMAT_R11G11B10_FLOAT: case TEX_FORMAT_RGB9E5_SHAREDEXP:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+// sets the dimension and array size of the description from the sizes in the file
+static void setDimension(TextureDesc& desc, std::uint32_t depth, std::uint32_t layers, std::uint32_t faces)
+{
+    if(faces == 6)
+    {
+        desc.ArraySize = std::max(layers, 1u) * 6;
+        desc.Type = layers > 0 ? RESOURCE_DIM_TEX_CUBE_ARRAY : RESOURCE_DIM_TEX_CUBE;
+    }
+    else if(depth > 1)
+    {
+        desc.Depth = depth;
+        desc.Type = RESOURCE_DIM_TEX_3D;
+    }
+    else
+    {
+        desc.ArraySize = std::max(layers, 1u);
+        desc.Type = layers > 0 ? RESOURCE_DIM_TEX_2D_ARRAY : RESOURCE_DIM_TEX_2D;
+    }
+}
+
+
+KTXFile::Ptr KTXFile::open(const std::string& filename)
+{
+    return make(filename);
+}
+
+RefCntAutoPtr<ITexture> KTXFile::load(IRenderDevice* device, const std::string& filename)
+{
+    KTXFile file(filename);
+    return file.createTexture(device, filename);
+}
+
+bool KTXFile::isKTXFile(const std::string& filename)
+{
+    std::uint8_t identifier[12];
+    std::FILE* f = std::fopen(filename.c_str(), "rb");
+    if(!f)
+        return false;
+
+    bool ok = std::fread(identifier, 1, sizeof(identifier), f) == sizeof(identifier);
+    std::fclose(f);
+
+    return ok && (std::memcmp(identifier, g_ktx1_identifier, sizeof(identifier)) == 0 ||
+                  std::memcmp(identifier, g_ktx2_identifier, sizeof(identifier)) == 0);
+}
+
+KTXFile::KTXFile(const std::string& filename) :
+    KTXFile(std::make_shared<MappedFile>(filename), 0, std::size_t(-1))
+{
+}
+
+KTXFile::KTXFile(MappedFile::ConstPtr file, std::size_t offset, std::size_t size) :
+    file_(std::move(file)), offset_(offset)
+{
+    if(offset_ > file_->size())
+        DG_THROW("Invalid KTX file " + file_->getFilename());
+
+    size_ = std::min(size, file_->size() - offset_);
+    data_ = file_->data() + offset_;
+
+    desc_.Usage = USAGE_IMMUTABLE;
+    desc_.BindFlags = BIND_SHADER_RESOURCE;
+
+    if(size_ >= sizeof(KTX1Header) && std::memcmp(data_, g_ktx1_identifier, sizeof(g_ktx1_identifier)) == 0)
+        openKTX1();
+    else if(size_ >= sizeof(KTX2Header) && std::memcmp(data_, g_ktx2_identifier, sizeof(g_ktx2_identifier)) == 0)
+        openKTX2();
+    else
+        DG_THROW("Invalid KTX file " + file_->getFilename());
+}
+
+void KTXFile::openKTX1()
+{
+    const std::string& filename = file_->getFilename();
+    const KTX1Header& header = *reinterpret_cast<const KTX1Header*>(data_);
+    if(header.endianness != 0x04030201)
+        DG_THROW("Unsupported byte order of KTX file " + filename);
+
+    version_ = 1;
+    desc_.Format = glFormatToTextureFormat(header.gl_internal_format);
+    if(desc_.Format == TEX_FORMAT_UNKNOWN)
+        DG_THROW("Unsupported format " + std::to_string(header.gl_internal_format) + " of KTX file " + filename);
+
+    desc_.Width = header.width;
+    desc_.Height = std::max(header.height, 1u);
+    desc_.MipLevels = std::max(header.number_of_mipmap_levels, 1u);
+    setDimension(desc_, header.depth, header.number_of_array_elements, header.number_of_faces);
+    slice_count_ = desc_.Type == RESOURCE_DIM_TEX_3D ? 1 : desc_.ArraySize;
+
+    // the faces of cubemaps (that are not arrays) have individual sizes and padding
+    bool cube_faces = desc_.Type == RESOURCE_DIM_TEX_CUBE;
+
+    std::uint64_t offset = sizeof(KTX1Header) + std::uint64_t(header.bytes_of_key_value_data);
+    for(std::uint32_t mip=0; mip<desc_.MipLevels; ++mip)
+    {
+        if(offset + sizeof(std::uint32_t) > size_)
+            DG_THROW("Truncated KTX file " + filename);
+
+        std::uint32_t image_size;
+        std::memcpy(&image_size, data_ + offset, sizeof(image_size));
+        offset += sizeof(std::uint32_t);
+
+        std::uint64_t level_size = cube_faces ? align4(image_size) * 6 : image_size;
+        if(offset + level_size > size_)
+            DG_THROW("Truncated KTX file " + filename);
+
+        levels_.push_back(Level{offset, level_size, level_size});
+        offset = align4(offset + level_size);
+    }
+}
+
+void KTXFile::openKTX2()
+{
+    const std::string& filename = file_->getFilename();
+    const KTX2Header& header = *reinterpret_cast<const KTX2Header*>(data_);
+
+    version_ = 2;
+    supercompression_ = static_cast<Supercompression>(header.supercompression_scheme);
+    if(supercompression_ != SUPERCOMPRESSION_NONE && supercompression_ != SUPERCOMPRESSION_ZSTD)
+        DG_THROW("Unsupported supercompression of KTX file " + filename);
+#ifndef DG_WITH_ZSTD
+    if(supercompression_ == SUPERCOMPRESSION_ZSTD)
+        DG_THROW("Zstd supercompressed KTX file " + filename + " is not supported without Zstd");
+#endif
+
+    desc_.Format = vkFormatToTextureFormat(header.vk_format);
+    if(desc_.Format == TEX_FORMAT_UNKNOWN)
+        DG_THROW("Unsupported format " + std::to_string(header.vk_format) + " of KTX file " + filename);
+
+    desc_.Width = header.width;
+    desc_.Height = std::max(header.height, 1u);
+    desc_.MipLevels = std::max(header.level_count, 1u);
+    setDimension(desc_, header.depth, header.layer_count, header.face_count);
+    slice_count_ = desc_.Type == RESOURCE_DIM_TEX_3D ? 1 : desc_.ArraySize;
+
+    if(sizeof(KTX2Header) + std::uint64_t(desc_.MipLevels)*sizeof(KTX2Level) > size_)
+        DG_THROW("Truncated KTX file " + filename);
+
+    const KTX2Level* levels = reinterpret_cast<const KTX2Level*>(data_ + sizeof(KTX2Header));
+    for(std::uint32_t mip=0; mip<desc_.MipLevels; ++mip)
+    {
+        const KTX2Level& level = levels[mip];
+        // the sum of crafted offsets and lengths could wrap around
+        if(level.byte_offset > size_ || level.byte_length > size_ - level.byte_offset)
+            DG_THROW("Truncated KTX file " + filename);
+        if(supercompression_ == SUPERCOMPRESSION_NONE && level.byte_length < level.uncompressed_byte_length)
+            DG_THROW("Invalid KTX file " + filename);
+
+        levels_.push_back(Level{level.byte_offset, level.byte_length, level.uncompressed_byte_length});
+    }
+}
+
+void KTXFile::decompressLevels()
+{
+    if(supercompression_ != SUPERCOMPRESSION_ZSTD || !decompressed_.empty())
+        return;
+
+#ifdef DG_WITH_ZSTD
+    std::vector<std::vector<std::uint8_t>> decompressed(levels_.size());
+    for(std::size_t i=0; i<levels_.size(); ++i)
+    {
+        const Level& level = levels_[i];
+        decompressed[i].resize(level.uncompressed_size);
+        std::size_t size = ZSTD_decompress(decompressed[i].data(), decompressed[i].size(),
+                                           data_ + level.offset, level.size);
+        if(ZSTD_isError(size) || size != level.uncompressed_size)
+            DG_THROW(std::string("Cannot decompress KTX level: ") + ZSTD_getErrorName(size));
+    }
+    decompressed_.swap(decompressed);
+#endif
+}
+
+void KTXFile::prefetch()
+{
+    file_->prefetch(offset_, size_);
+    decompressLevels();
+}
+
+void KTXFile::prefetchLevels(std::uint32_t first_mip, std::uint32_t count) const
+{
+    for(std::uint32_t mip=first_mip; mip<first_mip+count && mip<levels_.size(); ++mip)
+        file_->prefetch(offset_ + std::size_t(levels_[mip].offset), std::size_t(levels_[mip].size));
+}
+
+const std::vector<TextureSubResData>& KTXFile::getSubresources()
+{
+    if(subresources_valid_)
+        return subresources_;
+
+    decompressLevels();
+
+    std::vector<TextureSubResData> subresources(std::size_t(desc_.MipLevels) * slice_count_);
+    for(std::uint32_t mip=0; mip<desc_.MipLevels; ++mip)
+    {
+        const Level& level = levels_[mip];
+        const std::uint8_t* data = decompressed_.empty() ? data_ + level.offset : decompressed_[mip].data();
+        std::uint64_t data_size = decompressed_.empty() ? level.size : decompressed_[mip].size();
+
+        MipLevelProperties mip_info = GetMipLevelProperties(desc_, mip);
+        std::uint32_t rows = mip_info.RowSize > 0 ? mip_info.DepthSliceSize / mip_info.RowSize : 0;
+
+        // rows of KTX 1.0 are aligned to 4 bytes (GL_UNPACK_ALIGNMENT), KTX 2.0 is tightly packed
+        std::uint32_t stride = version_ == 1 ? std::uint32_t(align4(mip_info.RowSize)) : mip_info.RowSize;
+        std::uint64_t depth_stride = std::uint64_t(stride) * rows;
+        std::uint64_t slice_size = depth_stride * mip_info.Depth;
+        std::uint64_t slice_step = version_ == 1 && desc_.Type == RESOURCE_DIM_TEX_CUBE ? level.size / 6 : slice_size;
+
+        if(slice_step * (slice_count_ - 1) + slice_size > data_size)
+            DG_THROW("Invalid size of KTX level " + std::to_string(mip));
+
+        for(std::uint32_t slice=0; slice<slice_count_; ++slice)
+            subresources[mip + slice*desc_.MipLevels] =
+                TextureSubResData{data + slice*slice_step, stride, std::uint32_t(depth_stride)};
+    }
+
+    subresources_.swap(subresources);
+    subresources_valid_ = true;
+    return subresources_;
+}
+
+std::size_t KTXFile::getLevelSize(std::uint32_t mip) const
+{
+    return std::size_t(levels_[mip].uncompressed_size);
+}
+
+RefCntAutoPtr<ITexture> KTXFile::createTexture(IRenderDevice* device, const std::string& name, std::uint32_t first_mip)
+{
+    const std::vector<TextureSubResData>& all_subresources = getSubresources();
+    first_mip = std::min(first_mip, desc_.MipLevels - 1);
+
+    TextureDesc desc = desc_;
+    desc.Name = name.c_str();
+    desc.Width = std::max(desc_.Width >> first_mip, 1u);
+    desc.Height = std::max(desc_.Height >> first_mip, 1u);
+    if(desc.Type == RESOURCE_DIM_TEX_3D)
+        desc.Depth = std::max(desc_.Depth >> first_mip, 1u);
+    desc.MipLevels = desc_.MipLevels - first_mip;
+
+    std::vector<TextureSubResData> subresources;
+    subresources.reserve(std::size_t(desc.MipLevels) * slice_count_);
+    for(std::uint32_t slice=0; slice<slice_count_; ++slice)
+        for(std::uint32_t mip=first_mip; mip<desc_.MipLevels; ++mip)
+            subresources.push_back(all_subresources[mip + slice*desc_.MipLevels]);
+
+    TextureData tex_data;
+    tex_data.pSubResources   = subresources.data();
+    tex_data.NumSubresources = static_cast<std::uint32_t>(subresources.size());
+
+    RefCntAutoPtr<ITexture> texture;
+    device->CreateTexture(desc, &tex_data, &texture);
+    if(!texture)
+        DG_THROW("Cannot create texture " + name);
+
+    return texture;
+}
+
+void KTXFile::write(const std::string& filename, const TextureDesc& desc,
+                    const std::vector<std::vector<std::uint8_t>>& levels)
+{
+    std::string tmp_filename = filename + ".tmp" + std::to_string(::getpid()) + "." + std::to_string(g_tmp_counter++);
+    std::FILE* f = std::fopen(tmp_filename.c_str(), "wb");
+    if(!f)
+        DG_THROW("Cannot create KTX file " + filename);
+
+    bool ok = write(f, desc, levels);
+
+    ok = std::fclose(f) == 0 && ok;
+    if(!ok || std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmp_filename.c_str());
+        DG_THROW("Cannot write KTX file " + filename);
+    }
+}
+
+bool KTXFile::write(std::FILE* f, const TextureDesc& desc, const std::vector<std::vector<std::uint8_t>>& levels)
+{
+    std::uint32_t vk_format = textureFormatToVkFormat(desc.Format);
+    if(vk_format == 0 || levels.size() != desc.MipLevels)
+        return false;
+
+    bool cube = desc.Type == RESOURCE_DIM_TEX_CUBE || desc.Type == RESOURCE_DIM_TEX_CUBE_ARRAY;
+
+    KTX2Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.identifier, g_ktx2_identifier, sizeof(g_ktx2_identifier));
+    header.vk_format = vk_format;
+    header.type_size = typeSize(desc.Format);
+    header.width = desc.Width;
+    header.height = desc.Height;
+    header.depth = desc.Type == RESOURCE_DIM_TEX_3D ? desc.Depth : 0;
+    header.layer_count = desc.Type == RESOURCE_DIM_TEX_2D_ARRAY ? desc.ArraySize :
+                         desc.Type == RESOURCE_DIM_TEX_CUBE_ARRAY ? desc.ArraySize / 6 : 0;
+    header.face_count = cube ? 6 : 1;
+    header.level_count = desc.MipLevels;
+    header.supercompression_scheme = SUPERCOMPRESSION_NONE;
+
+    // the levels are aligned to 16 bytes, which is a multiple of the block sizes
+    std::vector<KTX2Level> level_index(levels.size());
+    std::uint64_t offset = sizeof(KTX2Header) + levels.size()*sizeof(KTX2Level);
+    for(std::size_t mip=0; mip<levels.size(); ++mip)
+    {
+        offset = (offset + 15) & ~std::uint64_t(15);
+        level_index[mip] = KTX2Level{offset, levels[mip].size(), levels[mip].size()};
+        offset += levels[mip].size();
+    }
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(level_index.data(), sizeof(KTX2Level), level_index.size(), f) == level_index.size();
+
+    const std::uint8_t padding[16] = {};
+    std::uint64_t position = sizeof(KTX2Header) + levels.size()*sizeof(KTX2Level);
+    for(std::size_t mip=0; ok && mip<levels.size(); ++mip)
+    {
+        std::size_t pad = std::size_t(level_index[mip].byte_offset - position);
+        ok = std::fwrite(padding, 1, pad, f) == pad &&
+             std::fwrite(levels[mip].data(), 1, levels[mip].size(), f) == levels[mip].size();
+        position = level_index[mip].byte_offset + levels[mip].size();
+    }
+
+    return ok;
+}
+
+}
@@ -1,6 +1,8 @@
 
 #include <dg/material/unlit_material.hpp>
 #include <dg/material/common_constants.hpp>
+#include <dg/material/dynamic_texture.hpp>
+#include <dg/scene/texture_streamer.hpp>
 
 #include <DiligentCore/Graphics/GraphicsEngine/interface/PipelineState.h>
 
@@ -10,6 +12,7 @@ struct UnlitMaterial::MaterialVS
 {
     Color color;
     float opacity;
+    float texture_scale;
 };
 
 static const char* g_unlit_material_vs =
@@ -19,6 +22,7 @@ cbuffer Material
 {
     float4 g_color;
     float  g_opacity;
+    float  g_texture_scale;
 };
 
 struct VSInput
@@ -33,6 +37,7 @@ struct PSInput
     float4 Pos   : SV_POSITION; 
     float4 Color : COLOR0; 
     float2 UV    : TEX_COORD; 
+    float  TextureScale : TEX_SCALE;
 };
 
 void main(in  VSInput VSIn,
@@ -42,6 +47,7 @@ void main(in  VSInput VSIn,
     PSIn.Color = g_color * VSIn.Color;
     PSIn.Color.a = PSIn.Color.a * g_opacity;
     PSIn.UV  = VSIn.UV;
+    PSIn.TextureScale = g_texture_scale;
 }
 )===";
 
@@ -57,6 +63,7 @@ struct PSInput
     float4 Pos   : SV_POSITION; 
     float4 Color : COLOR0; 
     float2 UV    : TEX_COORD;
+    float  TextureScale : TEX_SCALE;
 };
 
 struct PSOutput
@@ -64,12 +71,97 @@ struct PSOutput
     float4 Color : SV_TARGET; 
 };
 
+float3 SRGBToLinear(float3 c)
+{
+    return lerp(c / 12.92, pow((c + 0.055) / 1.055, 2.4), step(0.04045, c));
+}
+
+#if USE_TEXTURE && TEXTURE_CHANNELS >= 3
+
+float3 YUVToRGB(float y, float u, float v)
+{
+    // BT.601 with limited range, as delivered by most cameras
+    y = 1.164 * (y - 16.0 / 255.0);
+    u -= 0.5;
+    v -= 0.5;
+    return saturate(float3(y + 1.596 * v, y - 0.392 * u - 0.813 * v, y + 2.017 * u));
+}
+
+float Fetch(int2 p, int2 size)
+{
+    return g_Texture.Load(int3(clamp(p, int2(0, 0), size - int2(1, 1)), 0)).r;
+}
+
+// decodes the raw camera image at the pixel that contains uv, the chroma planes of NV12 and I420 images are stored
+// below the luma plane
+float3 DecodeTexel(float2 uv)
+{
+    uint width, height;
+    g_Texture.GetDimensions(width, height);
+#   if TEXTURE_CHANNELS == 3 || TEXTURE_CHANNELS == 4
+    int2 size = int2(int(width), int(height) * 2 / 3);
+#   else
+    int2 size = int2(int(width), int(height));
+#   endif
+    int2 p = clamp(int2(uv * float2(size)), int2(0, 0), size - int2(1, 1));
+
+#   if TEXTURE_CHANNELS == 3 // NV12
+    int2 c = int2(p.x & ~1, size.y + p.y / 2);
+    return YUVToRGB(Fetch(p, size), g_Texture.Load(int3(c, 0)).r, g_Texture.Load(int3(c.x + 1, c.y, 0)).r);
+#   elif TEXTURE_CHANNELS == 4 // I420
+    int2 c = int2(p.x / 2, size.y + p.y / 2);
+    return YUVToRGB(Fetch(p, size), g_Texture.Load(int3(c, 0)).r, g_Texture.Load(int3(c.x + size.x / 2, c.y, 0)).r);
+#   elif TEXTURE_CHANNELS == 5 // YUYV
+    return YUVToRGB(g_Texture.Load(int3(p, 0)).r, g_Texture.Load(int3(p.x & ~1, p.y, 0)).g,
+                    g_Texture.Load(int3(p.x | 1, p.y, 0)).g);
+#   else
+    // bilinear demosaicing, the position of the red pixel in the 2x2 pattern
+#       if TEXTURE_CHANNELS == 6
+    const int2 red = int2(0, 0); // RGGB
+#       elif TEXTURE_CHANNELS == 7
+    const int2 red = int2(1, 1); // BGGR
+#       elif TEXTURE_CHANNELS == 8
+    const int2 red = int2(1, 0); // GRBG
+#       else
+    const int2 red = int2(0, 1); // GBRG
+#       endif
+    float center = Fetch(p, size);
+    float horizontal = 0.5 * (Fetch(p + int2(-1, 0), size) + Fetch(p + int2(1, 0), size));
+    float vertical = 0.5 * (Fetch(p + int2(0, -1), size) + Fetch(p + int2(0, 1), size));
+    float diagonal = 0.25 * (Fetch(p + int2(-1, -1), size) + Fetch(p + int2(1, -1), size) +
+                             Fetch(p + int2(-1, 1), size) + Fetch(p + int2(1, 1), size));
+    float cross = 0.5 * (horizontal + vertical);
+
+    int2 parity = (p + red) & int2(1, 1);
+    if(parity.x == 0 && parity.y == 0)
+        return float3(center, cross, diagonal);
+    if(parity.x == 1 && parity.y == 1)
+        return float3(diagonal, cross, center);
+    if(parity.y == 0)
+        return float3(horizontal, center, vertical); // green in a red row
+    return float3(vertical, center, horizontal);     // green in a blue row
+#   endif
+}
+
+#endif
+
 void main(in  PSInput  PSIn,
           out PSOutput PSOut)
 {
 
 #if USE_TEXTURE
-    PSOut.Color = PSIn.Color * g_Texture.Sample(g_Texture_sampler, PSIn.UV);
+#   if TEXTURE_CHANNELS >= 3
+    // camera images are decoded to sRGB values, like the RGBA8 textures
+    float4 texel = float4(SRGBToLinear(DecodeTexel(PSIn.UV)), 1.0);
+#   else
+    float4 texel = g_Texture.Sample(g_Texture_sampler, PSIn.UV);
+#   endif
+#   if TEXTURE_CHANNELS == 1 || TEXTURE_CHANNELS == 2
+    // single or dual channel textures are unorm, the grey values are decoded like the sRGB RGBA8 textures
+    float3 linear_grey = SRGBToLinear(saturate(texel.rrr * PSIn.TextureScale));
+    texel = float4(linear_grey, TEXTURE_CHANNELS == 2 ? texel.g : 1.0);
+#   endif
+    PSOut.Color = PSIn.Color * texel;
 #else 
     PSOut.Color = PSIn.Color; 
 #endif
@@ -95,7 +187,8 @@ void UnlitMaterial::initialize(IRenderDevice* device)
     blend_desc_.DestBlendAlpha = BLEND_FACTOR_INV_SRC_ALPHA;
     blend_desc_.BlendOpAlpha   = BLEND_OPERATION_ADD;
 
-    std::pair<IRenderDevice*, int> key(device, texture ? 1 : 0);
+    bool use_texture = texture || streamed_texture || dynamic_texture;
+    std::pair<IRenderDevice*, int> key(device, use_texture ? 1 + int(texture_channels) : 0);
     std::weak_ptr<ShaderProgram>& shared_shader_program = shared_shader_programs_[key];
 
     if(shared_shader_program.expired())
@@ -103,8 +196,11 @@ void UnlitMaterial::initialize(IRenderDevice* device)
         shader_program_ = std::make_shared<ShaderProgram>();
 
         ShaderProgram::MacroDefinitions macros;
-        if(texture)
+        if(use_texture)
+        {
             macros.push_back(std::make_pair("USE_TEXTURE", "1"));
+            macros.push_back(std::make_pair("TEXTURE_CHANNELS", std::to_string(int(texture_channels))));
+        }
 
         shader_program_->setShaders(device, "UnlitMaterial_shader", g_unlit_material_vs, g_unlit_material_ps, macros);
         shader_program_->addConstant<CommonConstantsVS>(device, "CommonConstantsVS");
@@ -135,7 +231,13 @@ void UnlitMaterial::setupPSODesc(PipelineStateDesc& desc)
     {
         {SHADER_TYPE_PIXEL, "g_Texture", SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE}
     };
-    desc.ResourceLayout.Variables    = vars;
+    // textures that are replaced while they are drawn (streamed mip levels, video frames) are rebound by
+    // SceneManager, which mutable variables do not allow
+    static ShaderResourceVariableDesc dynamic_vars[] =
+    {
+        {SHADER_TYPE_PIXEL, "g_Texture", SHADER_RESOURCE_VARIABLE_TYPE_DYNAMIC}
+    };
+    desc.ResourceLayout.Variables    = dynamic_texture || streamed_texture ? dynamic_vars : vars;
     desc.ResourceLayout.NumVariables = _countof(vars);
 
     // Define static sampler for g_Texture. Static samplers should be used whenever possible
@@ -163,11 +265,13 @@ void UnlitMaterial::bindPSO(IPipelineState* pso)
 
 void UnlitMaterial::bindSRB(IShaderResourceBinding* srb)
 {
-    if(texture)
+    RefCntAutoPtr<ITexture> bound_texture = dynamic_texture ? dynamic_texture->getTexture() :
+                                            streamed_texture ? streamed_texture->getTexture() : texture;
+    if(bound_texture)
     {
         // Get shader resource view from the texture
         static dg::RefCntAutoPtr<ITextureView> texture_srv;
-        texture_srv = texture->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+        texture_srv = bound_texture->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
         // Set texture SRV in the SRB
         auto var = srb->GetVariableByName(SHADER_TYPE_PIXEL, "g_Texture");
         var->Set(texture_srv);
@@ -179,9 +283,16 @@ void UnlitMaterial::prepareForRender(IDeviceContext* context)
     auto material = shader_program_->mapConstant<MaterialVS>(context, "Material");
     material->color = color;
     material->opacity = opacity;
+    material->texture_scale = texture_scale;
 }
 
 
+std::uint64_t UnlitMaterial::getTextureVersion() const
+{
+    // both versions only increase, hence the sum changes with either
+    return (streamed_texture ? streamed_texture->getVersion() : 0) + (dynamic_texture ? dynamic_texture->getVersion() : 0);
+}
+
 void UnlitMaterial::setBlendDesc(const RenderTargetBlendDesc& desc)
 {
     blend_desc_ = desc;
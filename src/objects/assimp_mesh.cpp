@@ -2,14 +2,64 @@
 #include <dg/objects/assimp_mesh.hpp>
 #include <dg/scene/scene_manager.hpp>
 #include <dg/material/unlit_material.hpp>
+#include <dg/internal/mesh_loader.hpp>
 
-#include <assimp/scene.h>
-#include <assimp/material.h>
-#include <assimp/postprocess.h>
-#include <assimp/Importer.hpp>
+#include <atomic>
+#include <mutex>
 
 namespace dg {
 
+namespace {
+
+std::string errorMessage(std::exception_ptr error)
+{
+    try
+    {
+        std::rethrow_exception(error);
+    }
+    catch(const std::exception& e)
+    {
+        return e.what();
+    }
+    catch(...)
+    {
+        return "Unknown error";
+    }
+}
+
+/// State of an asynchronous load, that is shared by the mesh, the worker thread and the render task
+struct AsyncLoad
+{
+    std::atomic<bool> cancelled{false};
+
+    // written by the worker thread
+    std::mutex mutex;
+    bool imported = false;
+    MeshLoader loader;
+    std::exception_ptr error;
+
+    // accessed on the render thread only
+    std::size_t next = 0;
+    bool finished = false;
+    std::promise<void> promise;
+    std::shared_future<void> future;
+    AssimpMesh::LoadCallback callback;
+
+    void finish(std::exception_ptr e)
+    {
+        finished = true;
+        if(e)
+            promise.set_exception(e);
+        else
+            promise.set_value();
+
+        if(callback)
+            callback(!e, e ? errorMessage(e) : std::string());
+    }
+};
+
+}
+
 class AssimpMesh::Pimpl
 {
 public:
@@ -17,20 +67,25 @@ public:
 
 
     SceneManager* manager = nullptr;
-    const aiScene* scene = nullptr;
-
-    //std::map<std::string, OgreUtils::Material::SharedPtr> m_materials;
 
     dg::UnlitMaterial::Ptr default_material;
     IMaterial::Ptr material;
 
+    std::shared_ptr<AsyncLoad> async_load;
+
+    bool cache_enabled = true;
+    std::string cache_directory;
+
     AssimpMesh* q;
 
 public:
 
-    void loadMesh(const std::string& filename);
-    void loadNode(aiNode* n, const aiMatrix4x4& parentTransform, bool skipNodesTransform);
-    void loadSubMesh(const aiMesh* m, const aiMatrix4x4& transform);
+    void cancelLoad();
+
+    MeshLoadSettings loadSettings() const;
+
+    // render task of the asynchronous load, returns true when done
+    bool uploadSections(AsyncLoad& load);
 
     void setOpacity(float opacity);
 
@@ -45,150 +100,69 @@ AssimpMesh::Pimpl::Pimpl(AssimpMesh* q, SceneManager* manager, IMaterial::Ptr ma
         this->material=material;
 }
 
-void AssimpMesh::Pimpl::loadMesh(const std::string& filename)
-{
-
-    // Create an instance of the Importer class
-    Assimp::Importer importer;
-
-    // And have it read the given file with some example postprocessing
-    // Usually - if speed is not the most important aspect for you - you'll
-    // propably to request more postprocessing than we do in this example.
-    scene = importer.ReadFile( filename,
-        aiProcess_CalcTangentSpace       |
-        aiProcess_Triangulate            |
-        aiProcess_GenSmoothNormals       |
-        aiProcess_JoinIdenticalVertices  |
-        aiProcess_SortByPType);
-
-    // If the import failed, report it
-    if(!scene)
-      DG_THROW(importer.GetErrorString());
-
-    /*
-    Ogre::MeshPtr mesh = Ogre::MeshManager::getSingleton().createManual(m_guid, RES_GROUP);
-
-    m_aabb = Ogre::Aabb();
-
-    assert(m_scene->mRootNode);
-    loadNode(mesh, m_scene->mRootNode, aiMatrix4x4(), true); // skip roots transform
-
-    mesh->_setBounds(m_aabb);
-
-    Ogre::Vector3 s = m_aabb.getSize();
-    mesh->_setBoundingSphereRadius(std::max(s.x, std::max(s.y, s.z))/2.0f);
-    */
-
-    loadNode(scene->mRootNode, aiMatrix4x4(), true); // skip roots transform
-}
-
-void AssimpMesh::Pimpl::loadNode(aiNode* n, const aiMatrix4x4& parentTransform, bool skipNodesTransform)
+void AssimpMesh::Pimpl::cancelLoad()
 {
-    aiMatrix4x4 transform;
-    if(!skipNodesTransform)
-        transform = parentTransform * n->mTransformation;
-    else
-        transform = parentTransform;
+    if(!async_load)
+        return;
 
-
-    for(unsigned int k = 0; k<n->mNumMeshes; ++k)
+    async_load->cancelled = true;
+    if(!async_load->finished)
     {
-        assert(n->mMeshes[k]<scene->mNumMeshes);
-        const aiMesh* m = scene->mMeshes[n->mMeshes[k]];
-        loadSubMesh(m, transform);
+        async_load->finished = true;
+        async_load->promise.set_exception(std::make_exception_ptr(std::runtime_error("Loading was cancelled")));
     }
-
-    // process child nodes
-    for(unsigned int i=0; i<n->mNumChildren; ++i)
-        loadNode(n->mChildren[i], transform, false);
+    async_load.reset();
 }
 
-
-void AssimpMesh::Pimpl::loadSubMesh(const aiMesh* m, const aiMatrix4x4& transform)
+MeshLoadSettings AssimpMesh::Pimpl::loadSettings() const
 {
-    aiMatrix3x3 transform3(transform);
-
-    q->begin(material, dg::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
-
-    bool use_normals = false;
-    if(m->mNormals!=nullptr)
-        use_normals = true;
-
-    bool use_color = false;
-    if(m->mColors[0])
-        use_color = true;
+    MeshLoadSettings settings;
+    settings.vertex_format = q->getVertexFormat();
+    settings.mesh_optimization = q->getMeshOptimization();
+    settings.generate_lods = q->getLodGeneration();
+    settings.lod_options = q->getLodOptions();
+    settings.cache_enabled = cache_enabled;
+    settings.cache_directory = cache_directory;
+    return settings;
+}
 
-    // fill in the vertex data
-    for(size_t i=0; i<m->mNumVertices; ++i)
+bool AssimpMesh::Pimpl::uploadSections(AsyncLoad& load)
+{
     {
-        aiVector3D p = transform * m->mVertices[i];
+        std::lock_guard<std::mutex> lock(load.mutex);
+        if(!load.imported)
+            return false;
+    }
 
-        q->position(p.x,p.y,p.z);
+    if(load.error)
+    {
+        load.finish(load.error);
+        return true;
+    }
 
-        /*
-        if(m->mTextureCoords[0]) {
-            *vertexData++ = m->mTextureCoords[0][i].x;
-            *vertexData++ = 1-m->mTextureCoords[0][i].y;
-        }
-        }*/
+    // at least one section per frame, the others within the upload budget
+    bool uploaded = false;
+    while(load.next < load.loader.getMeshCount())
+    {
+        if(uploaded && manager->getRemainingUploadBudget()==0)
+            return false;
 
-        if(use_normals)
+        try
         {
-            aiVector3D n = transform3 * m->mNormals[i];
-            n.Normalize();
-            q->normal(n.x,n.y,n.z);
+            std::size_t i = load.next++;
+            manager->consumeUploadBudget(load.loader.getMeshSize(i));
+            q->addSection(material, load.loader.upload(manager->device(), i));
         }
-
-
-        if(use_color)
+        catch(...)
         {
-            if(m->mColors[0]) {
-                q->color(Color(m->mColors[0][i].r,
-                               m->mColors[0][i].g,
-                               m->mColors[0][i].b,
-                               m->mColors[0][i].a).toSRGB());
-            }
-            else
-            {
-                // TODO: use fixed color
-            }
+            load.finish(std::current_exception());
+            return true;
         }
-
-        //TODO: m_aabb.merge(Ogre::Vector3(p.x,p.y,p.z));
+        uploaded = true;
     }
 
-
-    for(unsigned int i=0; i<m->mNumFaces; ++i)
-    {
-        const aiFace& f = m->mFaces[i];
-
-        if(f.mNumIndices==3) {
-            for(unsigned int j=0; j<3; ++j)
-            {
-                //*indexPtr = f.mIndices[j];
-                q->index(f.mIndices[j]);
-            }
-        }
-        // else do nothing (only happens for lines that consists of 2 vertices only)
-    }
-
-
-/*
-    // set the material for the submesh
-    if(m_scene->HasMaterials()) {
-        assert(m_scene->mMaterials!=NULL);
-        assert(m->mMaterialIndex < m_scene->mNumMaterials);
-        std::string materialName = m_guid + "_mat" + std::to_string(m->mMaterialIndex);
-        createMaterial(m_guid + "_mat" + std::to_string(m->mMaterialIndex), m_scene->mMaterials[m->mMaterialIndex]);
-        subMesh->setMaterialName(materialName);
-    } else {
-        std::string materialName = m_guid + "_defaultmat";
-        createDefaultMaterial(materialName);
-        subMesh->setMaterialName(materialName);
-    }
-*/
-
-    q->end();
+    load.finish(nullptr);
+    return true;
 }
 
 void AssimpMesh::Pimpl::setOpacity(float opacity)
@@ -200,17 +174,80 @@ void AssimpMesh::Pimpl::setOpacity(float opacity)
 AssimpMesh::AssimpMesh(SceneManager* manager, IMaterial::Ptr material) : ManualObject(manager)
 {
     d.reset(new Pimpl(this, manager, material));
+
+    // loaded meshes arrive in the order of the file, which is usually far from optimal for the GPU,
+    // and are often dense scans, that are not worth drawing at full resolution when they are far away
+    setMeshOptimization(MeshOptimization_All);
+    setLodGeneration(true);
 }
 
 AssimpMesh::~AssimpMesh()
 {
-
+    d->cancelLoad();
 }
 
 void AssimpMesh::load(const std::string& filename)
 {
+    d->cancelLoad();
     clear();
-    d->loadMesh(filename);
+
+    MeshLoader loader(filename, d->loadSettings());
+    loader.load(false, nullptr, &d->manager->getWorkerPool());
+    for(std::size_t i=0; i<loader.getMeshCount(); ++i)
+        addSection(d->material, loader.upload(d->manager->device(), i));
+}
+
+std::shared_future<void> AssimpMesh::loadAsync(const std::string& filename, LoadCallback callback)
+{
+    d->cancelLoad();
+    clear();
+
+    std::shared_ptr<AsyncLoad> load = std::make_shared<AsyncLoad>();
+    load->future = load->promise.get_future().share();
+    load->callback = std::move(callback);
+    load->loader = MeshLoader(filename, d->loadSettings());
+    d->async_load = load;
+
+    // the worker only accesses the shared state, hence the mesh may be destroyed while it is running
+    WorkerPool* pool = &d->manager->getWorkerPool();
+    pool->enqueue([load, pool]()
+    {
+        std::exception_ptr error;
+        try
+        {
+            load->loader.load(true, &load->cancelled, pool);
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(load->mutex);
+        load->error = error;
+        load->imported = true;
+    });
+
+    // the task keeps the state alive, but must not touch the mesh after it was cancelled
+    Pimpl* pimpl = d.get();
+    d->manager->addRenderTask([load, pimpl](SceneManager*)
+    {
+        if(load->cancelled)
+            return true;
+        return pimpl->uploadSections(*load);
+    });
+
+    return load->future;
+}
+
+void AssimpMesh::setMeshCache(bool enable, const std::string& directory)
+{
+    d->cache_enabled = enable;
+    d->cache_directory = directory;
+}
+
+bool AssimpMesh::isLoading() const
+{
+    return d->async_load && !d->async_load->finished;
 }
 
 void AssimpMesh::setOpacity(float opacity)
@@ -50,6 +50,24 @@ int borderEdge(dg::ManualObject* obj, float sx, float sy, float ox, float oy, in
     return 9;
 }
 
+static dg::UnlitMaterial::TextureChannels textureChannels(dg::DynamicTexture::DataFormat format)
+{
+    switch(format)
+    {
+        case dg::DynamicTexture::GREY8:
+        case dg::DynamicTexture::GREY16:       return dg::UnlitMaterial::TEXTURE_GREY;
+        case dg::DynamicTexture::GREY_ALPHA8:
+        case dg::DynamicTexture::GREY_ALPHA16: return dg::UnlitMaterial::TEXTURE_GREY_ALPHA;
+        case dg::DynamicTexture::NV12:         return dg::UnlitMaterial::TEXTURE_NV12;
+        case dg::DynamicTexture::I420:         return dg::UnlitMaterial::TEXTURE_I420;
+        case dg::DynamicTexture::YUYV:         return dg::UnlitMaterial::TEXTURE_YUYV;
+        case dg::DynamicTexture::BAYER_RGGB:   return dg::UnlitMaterial::TEXTURE_BAYER_RGGB;
+        case dg::DynamicTexture::BAYER_BGGR:   return dg::UnlitMaterial::TEXTURE_BAYER_BGGR;
+        case dg::DynamicTexture::BAYER_GRBG:   return dg::UnlitMaterial::TEXTURE_BAYER_GRBG;
+        case dg::DynamicTexture::BAYER_GBRG:   return dg::UnlitMaterial::TEXTURE_BAYER_GBRG;
+        default:                               return dg::UnlitMaterial::TEXTURE_RGBA;
+    }
+}
 
 void CanvasImageLayer::update(const dg::DynamicTexture::ImageData& data)
 {
@@ -59,7 +77,9 @@ void CanvasImageLayer::update(const dg::DynamicTexture::ImageData& data)
     {
         manualObject_ = dg::ManualObject::make_unique(getParentObject()->getSceneManager());
         material_ = dg::UnlitMaterial::make(getParentObject()->getSceneManager()->device());
-        material_->texture = texture_.getTexture();
+        material_->dynamic_texture = &texture_;
+        material_->texture_scale = texture_.getValueScale();
+        material_->texture_channels = textureChannels(data.format);
         material_->cull_mode = dg::material::RasterizerParams::CullMode::None;
         material_->initialize(getParentObject()->getSceneManager()->device()); // TODO: this should be done automatically
 
@@ -0,0 +1,375 @@
+#include <dg/objects/debug_draw.hpp>
+
+#include <dg/core/conversion.hpp>
+#include <dg/scene/camera.hpp>
+#include <dg/scene/scene_manager.hpp>
+#include <dg/material/shader_program.hpp>
+#include <dg/material/common_constants.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/SwapChain.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/PipelineState.h>
+
+namespace dg {
+
+static const char* g_debug_draw_vs =
+DG_COMMON_CONSTANTS_VS_CODE
+R"===(
+struct VSInput
+{
+    float3 Pos   : ATTRIB0;
+    float4 Color : ATTRIB1;
+};
+
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+void main(in  VSInput VSIn,
+          out PSInput PSIn)
+{
+    PSIn.Pos   = mul(g_worldViewProj, float4(VSIn.Pos,1.0));
+    PSIn.Color = VSIn.Color;
+}
+)===";
+
+static const char* g_debug_draw_ps =
+R"===(
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+struct PSOutput
+{
+    float4 Color : SV_TARGET;
+};
+
+void main(in  PSInput  PSIn,
+          out PSOutput PSOut)
+{
+    PSOut.Color = PSIn.Color;
+}
+)===";
+
+static std::map<IRenderDevice*, std::weak_ptr<ShaderProgram>> g_shared_debug_draw_programs;
+
+struct DebugDraw::Pimpl
+{
+    std::shared_ptr<ShaderProgram> shader_program;
+
+    RefCntAutoPtr<IPipelineState>         line_pso;
+    RefCntAutoPtr<IShaderResourceBinding> line_srb;
+    RefCntAutoPtr<IPipelineState>         point_pso;
+    RefCntAutoPtr<IShaderResourceBinding> point_srb;
+
+    RefCntAutoPtr<IBuffer> vertex_buffer;
+    std::uint32_t buffer_vertices = 0;
+
+    bool pso_dirty = true;
+};
+
+
+DebugDraw::DebugDraw(SceneManager* manager, std::uint32_t buffer_vertices) : manager_(manager), d(new Pimpl)
+{
+    // line lists are split between draw calls, hence we need an even number of vertices per draw
+    d->buffer_vertices = std::max<std::uint32_t>(buffer_vertices & ~1u, 2);
+
+    IRenderDevice* device = manager->device();
+
+    std::weak_ptr<ShaderProgram>& shared_shader_program = g_shared_debug_draw_programs[device];
+    if(shared_shader_program.expired())
+    {
+        d->shader_program = std::make_shared<ShaderProgram>();
+        d->shader_program->setShaders(device, "DebugDraw_shader", g_debug_draw_vs, g_debug_draw_ps);
+        d->shader_program->addConstant<CommonConstantsVS>(device, "CommonConstantsVS");
+        shared_shader_program = d->shader_program;
+    }
+    else
+        d->shader_program = shared_shader_program.lock();
+
+    BufferDesc vb_desc;
+    vb_desc.Name           = "DebugDraw vertex buffer";
+    vb_desc.BindFlags      = BIND_VERTEX_BUFFER;
+    vb_desc.uiSizeInBytes  = d->buffer_vertices * sizeof(Vertex);
+    vb_desc.Usage          = USAGE_DYNAMIC;
+    vb_desc.CPUAccessFlags = CPU_ACCESS_WRITE;
+    device->CreateBuffer(vb_desc, nullptr, &d->vertex_buffer);
+}
+
+DebugDraw::~DebugDraw()
+{
+
+}
+
+void DebugDraw::line(const Vector3& p1, const Vector3& p2, const Color& color)
+{
+    std::uint32_t c = color.toUInt32();
+    line_vertices_.push_back(vertex(p1, c));
+    line_vertices_.push_back(vertex(p2, c));
+}
+
+void DebugDraw::lines(const Vector3* points, std::size_t num_points, const Color& color)
+{
+    std::uint32_t c = color.toUInt32();
+    num_points &= ~std::size_t(1);
+    for(std::size_t i=0; i<num_points; ++i)
+        line_vertices_.push_back(vertex(points[i], c));
+}
+
+void DebugDraw::polyline(const Vector3* points, std::size_t num_points, const Color& color, bool closed)
+{
+    if(num_points < 2)
+        return;
+
+    std::uint32_t c = color.toUInt32();
+    for(std::size_t i=1; i<num_points; ++i)
+    {
+        line_vertices_.push_back(vertex(points[i-1], c));
+        line_vertices_.push_back(vertex(points[i], c));
+    }
+
+    if(closed)
+    {
+        line_vertices_.push_back(vertex(points[num_points-1], c));
+        line_vertices_.push_back(vertex(points[0], c));
+    }
+}
+
+void DebugDraw::point(const Vector3& p, const Color& color)
+{
+    point_vertices_.push_back(vertex(p, color.toUInt32()));
+}
+
+void DebugDraw::points(const Vector3* points, std::size_t num_points, const Color& color)
+{
+    std::uint32_t c = color.toUInt32();
+    for(std::size_t i=0; i<num_points; ++i)
+        point_vertices_.push_back(vertex(points[i], c));
+}
+
+// the 12 edges of a box, whose corners are numbered by their bits (x,y,z)
+static const int g_box_edges[12][2] =
+{
+    {0,1}, {2,3}, {4,5}, {6,7}, // along x
+    {0,2}, {1,3}, {4,6}, {5,7}, // along y
+    {0,4}, {1,5}, {2,6}, {3,7}  // along z
+};
+
+void DebugDraw::box(const Vector3& p_min, const Vector3& p_max, const Color& color)
+{
+    Vector3 corners[8];
+    for(int i=0; i<8; ++i)
+        corners[i] = Vector3((i & 1) ? p_max.x() : p_min.x(),
+                             (i & 2) ? p_max.y() : p_min.y(),
+                             (i & 4) ? p_max.z() : p_min.z());
+
+    for(const auto& e : g_box_edges)
+        line(corners[e[0]], corners[e[1]], color);
+}
+
+void DebugDraw::box(const Transform& pose, const Vector3& size, const Color& color)
+{
+    Vector3 h = size * 0.5;
+
+    Vector3 corners[8];
+    for(int i=0; i<8; ++i)
+    {
+        Vector4 p((i & 1) ? h.x() : -h.x(),
+                  (i & 2) ? h.y() : -h.y(),
+                  (i & 4) ? h.z() : -h.z(), 1.0);
+        corners[i] = (pose * p).head<3>();
+    }
+
+    for(const auto& e : g_box_edges)
+        line(corners[e[0]], corners[e[1]], color);
+}
+
+void DebugDraw::sphere(const Vector3& center, Real radius, const Color& color, int num_segments)
+{
+    circle(center, Vector3::UnitX(), radius, color, num_segments);
+    circle(center, Vector3::UnitY(), radius, color, num_segments);
+    circle(center, Vector3::UnitZ(), radius, color, num_segments);
+}
+
+void DebugDraw::circle(const Vector3& center, const Vector3& normal, Real radius, const Color& color, int num_segments)
+{
+    if(num_segments < 3)
+        num_segments = 3;
+
+    Vector3 n = normal.normalized();
+    Vector3 u = n.unitOrthogonal() * radius;
+    Vector3 v = n.cross(u);
+
+    std::uint32_t c = color.toUInt32();
+    Vector3 prev = center + u;
+    for(int i=1; i<=num_segments; ++i)
+    {
+        Real a = 2.0 * M_PI * Real(i) / Real(num_segments);
+        Vector3 p = center + u * std::cos(a) + v * std::sin(a);
+        line_vertices_.push_back(vertex(prev, c));
+        line_vertices_.push_back(vertex(p, c));
+        prev = p;
+    }
+}
+
+void DebugDraw::axes(const Transform& pose, Real length)
+{
+    Vector3 o = pose.block<3,1>(0,3);
+    line(o, o + pose.block<3,1>(0,0) * length, colors::Red);
+    line(o, o + pose.block<3,1>(0,1) * length, colors::Green);
+    line(o, o + pose.block<3,1>(0,2) * length, colors::Blue);
+}
+
+void DebugDraw::frustum(const Transform& pose, const Frustum& frustum, const Color& color)
+{
+    Real near_plane = frustum.near_plane;
+    Real far_plane  = frustum.far_plane > 0.0f ? frustum.far_plane : frustum.near_plane * 100.0; // show infinite frustums up to some distance
+
+    // corners are numbered by their bits (x,y,z), where z selects the far plane (see Frustum::computeProjectionMatrix)
+    Vector3 corners[8];
+    for(int i=0; i<8; ++i)
+    {
+        Real dist   = (i & 4) ? far_plane : near_plane;
+        Real half_h = std::tan(frustum.fov * 0.5) * dist;
+        Real half_w = half_h * frustum.aspect;
+        Real left   = -frustum.principal.x() * 2.0 * half_w;
+        Real bottom = -frustum.principal.y() * 2.0 * half_h;
+
+        Vector4 p((i & 1) ? left + 2.0 * half_w : left,
+                  (i & 2) ? bottom + 2.0 * half_h : bottom,
+                  -dist, 1.0);
+        corners[i] = (pose * p).head<3>();
+    }
+
+    for(const auto& e : g_box_edges)
+        line(corners[e[0]], corners[e[1]], color);
+}
+
+void DebugDraw::frustum(const Camera& camera, const Color& color)
+{
+    if(!camera.getNode())
+        return;
+
+    frustum(camera.getNode()->getDerivedTransform(), camera.getFrustum(), color);
+}
+
+void DebugDraw::clear()
+{
+    line_vertices_.clear();
+    point_vertices_.clear();
+}
+
+void DebugDraw::reserve(std::size_t num_lines, std::size_t num_points)
+{
+    line_vertices_.reserve(num_lines*2);
+    point_vertices_.reserve(num_points);
+}
+
+void DebugDraw::setDepthTest(bool depth_test)
+{
+    if(depth_test == depth_test_)
+        return;
+
+    depth_test_ = depth_test;
+    d->pso_dirty = true;
+}
+
+void DebugDraw::render(SceneManager* manager)
+{
+    if(d->pso_dirty)
+    {
+        PipelineStateCreateInfo pso_create_info;
+        PipelineStateDesc& desc = pso_create_info.PSODesc;
+
+        desc.Name = "DebugDraw PSO";
+        desc.IsComputePipeline = false;
+        desc.GraphicsPipeline.NumRenderTargets  = 1;
+        desc.GraphicsPipeline.RTVFormats[0]     = manager->swapChain()->GetDesc().ColorBufferFormat;
+        desc.GraphicsPipeline.DSVFormat         = manager->swapChain()->GetDesc().DepthBufferFormat;
+        desc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+        desc.GraphicsPipeline.pVS = d->shader_program->getVertexShader();
+        desc.GraphicsPipeline.pPS = d->shader_program->getPixelShader();
+
+        desc.GraphicsPipeline.RasterizerDesc.CullMode = CULL_MODE_NONE;
+        desc.GraphicsPipeline.DepthStencilDesc.DepthEnable = depth_test_;
+
+        LayoutElement layout[] =
+        {
+            {0, 0, 3, VT_FLOAT32, false}, // pos
+            {1, 0, 4, VT_UINT8, true}     // color
+        };
+        desc.GraphicsPipeline.InputLayout.LayoutElements = layout;
+        desc.GraphicsPipeline.InputLayout.NumElements = _countof(layout);
+
+        d->line_pso.Release();
+        d->line_srb.Release();
+        desc.GraphicsPipeline.PrimitiveTopology = PRIMITIVE_TOPOLOGY_LINE_LIST;
+        manager->device()->CreatePipelineState(pso_create_info, &d->line_pso);
+        d->shader_program->bind(d->line_pso);
+        d->line_pso->CreateShaderResourceBinding(&d->line_srb, true);
+
+        d->point_pso.Release();
+        d->point_srb.Release();
+        desc.GraphicsPipeline.PrimitiveTopology = PRIMITIVE_TOPOLOGY_POINT_LIST;
+        manager->device()->CreatePipelineState(pso_create_info, &d->point_pso);
+        d->shader_program->bind(d->point_pso);
+        d->point_pso->CreateShaderResourceBinding(&d->point_srb, true);
+
+        d->pso_dirty = false;
+    }
+
+    if(!line_vertices_.empty() || !point_vertices_.empty())
+    {
+        {
+            auto constants = d->shader_program->mapConstant<CommonConstantsVS>(manager->context(), "CommonConstantsVS");
+            matrix_to_float4x4t(manager->getWorldViewProj(), constants->g_worldViewProj);
+            matrix_to_float4x4t(manager->getWorldView(), constants->g_worldView);
+            matrix_to_float4x4t(manager->getView(), constants->g_view);
+        }
+
+        draw(line_vertices_, d->line_pso, d->line_srb);
+        draw(point_vertices_, d->point_pso, d->point_srb);
+    }
+
+    if(auto_clear_)
+        clear();
+}
+
+void DebugDraw::draw(const std::vector<Vertex>& vertices, IPipelineState* pso, IShaderResourceBinding* srb)
+{
+    if(vertices.empty())
+        return;
+
+    IDeviceContext* context = manager_->context();
+
+    context->SetPipelineState(pso);
+    context->CommitShaderResources(srb, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    for(std::size_t first = 0; first < vertices.size(); first += d->buffer_vertices)
+    {
+        std::uint32_t count = static_cast<std::uint32_t>(std::min<std::size_t>(d->buffer_vertices, vertices.size() - first));
+
+        {
+            // DISCARD hands out a fresh region of the dynamic upload ring, previous draws keep their data
+            MapHelper<Vertex> mapped(context, d->vertex_buffer, MAP_WRITE, MAP_FLAG_DISCARD);
+            std::memcpy(static_cast<Vertex*>(mapped), vertices.data() + first, count * sizeof(Vertex));
+        }
+
+        Uint32   offset  = 0;
+        IBuffer* buffs[] = {d->vertex_buffer};
+        context->SetVertexBuffers(0, 1, buffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+
+        DrawAttribs attr;
+        attr.NumVertices = count;
+        attr.Flags = DRAW_FLAG_VERIFY_ALL;
+        context->Draw(attr);
+    }
+}
+
+}
@@ -2,6 +2,8 @@
 #include <dg/objects/gltf_mesh.hpp>
 
 #include <dg/core/conversion.hpp>
+#include <dg/core/mapped_file.hpp>
+#include <dg/scene/scene_manager.hpp>
 
 #include <DiligentCore/Common/interface/BasicMath.hpp>
 
@@ -25,23 +27,109 @@ namespace Diligent
 #include "Shaders/PostProcess/ToneMapping/public/ToneMappingStructures.fxh"
 }
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 namespace dg {
 
+namespace {
 
-struct GLTFMesh::Pimpl
+// returns the values of the "uri" properties of the glTF JSON, the images and buffers in other files
+std::vector<std::string> findURIs(const char* json, std::size_t size)
 {
-    std::unique_ptr<GLTF_PBR_Renderer>    renderer;
-    std::unique_ptr<GLTF::Model>          model;
+    static const char key[] = "\"uri\"";
+    const char* end = json + size;
 
-    RefCntAutoPtr<IBuffer>                camera_attribs_cb;
-    RefCntAutoPtr<IBuffer>                light_attribs_cb;
-    RefCntAutoPtr<ITextureView>           env_map_srv;
-    RefCntAutoPtr<IBuffer>                env_map_attribs_cb;
+    std::vector<std::string> uris;
+    for(const char* p = std::search(json, end, key, key + sizeof(key) - 1); p != end;
+        p = std::search(p, end, key, key + sizeof(key) - 1))
+    {
+        p += sizeof(key) - 1;
+        while(p != end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':'))
+            ++p;
+        if(p == end || *p != '"')
+            continue;
+
+        const char* begin = ++p;
+        p = std::find(p, end, '"');
+        uris.push_back(std::string(begin, p));
+    }
+    return uris;
+}
 
-    bool initialized = false;
-    bool use_local_frame = true;
+// reads the pages of the file and for .gltf files also of the external buffers and images into the page cache
+void prefetchModel(const std::string& filename, const std::atomic<bool>& cancelled)
+{
+    MappedFile file(filename);
+    file.prefetch();
 
-    std::string filename;
+    std::string ext = filename.size() >= 5 ? filename.substr(filename.size()-5) : std::string();
+    if(ext != ".gltf" && ext != ".GLTF")
+        return;
+
+    std::string dir;
+    std::size_t slash = filename.find_last_of("/\\");
+    if(slash != std::string::npos)
+        dir = filename.substr(0, slash+1);
+
+    for(const std::string& uri : findURIs(reinterpret_cast<const char*>(file.data()), file.size()))
+    {
+        if(cancelled)
+            return;
+        if(uri.compare(0, 5, "data:") == 0)
+            continue;
+
+        // missing resources are reported by the loader
+        try
+        {
+            MappedFile(dir + uri).prefetch();
+        }
+        catch(const std::exception&)
+        {
+        }
+    }
+}
+
+}
+
+/// State of an asynchronous load, that is shared by the mesh, the worker thread and the render task
+struct GLTFAsyncLoad
+{
+    std::atomic<bool> cancelled{false};
+
+    // written by the worker thread
+    std::mutex mutex;
+    bool prefetched = false;
+    std::exception_ptr error;
+
+    // accessed on the render thread only
+    int stage = 0;
+    bool finished = false;
+    std::promise<void> promise;
+    std::shared_future<void> future;
+    GLTFMesh::LoadCallback callback;
+
+    void finish(std::exception_ptr e)
+    {
+        finished = true;
+        if(e)
+            promise.set_exception(e);
+        else
+            promise.set_value();
+
+        if(!callback)
+            return;
+
+        std::string message;
+        if(e)
+        {
+            try { std::rethrow_exception(e); }
+            catch(const std::exception& ex) { message = ex.what(); }
+            catch(...) { message = "Unknown error"; }
+        }
+        callback(!e, message);
+    }
 };
 
 struct EnvMapRenderAttribs
@@ -54,129 +142,400 @@ struct EnvMapRenderAttribs
     float unusued2;
 };
 
-
-GLTFMesh::GLTFMesh()
+/**
+ * Renderer with its pipeline states, the precomputed IBL cubemaps and the camera and light buffers, that are
+ * shared by all glTF meshes of a scene manager. The buffers are written by the first mesh that is drawn in a frame.
+ */
+struct GLTFSharedRenderer
 {
-    d.reset(new Pimpl);
-}
+    std::unique_ptr<GLTF_PBR_Renderer> renderer;
 
-GLTFMesh::~GLTFMesh() = default;
+    RefCntAutoPtr<IBuffer>             camera_attribs_cb[2]; // world frame, local frame at the camera position
+    RefCntAutoPtr<IBuffer>             light_attribs_cb;
+    RefCntAutoPtr<IBuffer>             env_map_attribs_cb;
 
-void GLTFMesh::load(const std::string& filename)
-{
-    d->filename = filename;
-    d->initialized = false;
-}
+    RefCntAutoPtr<ITexture>            env_map; // of the precomputed cubemaps
+    RefCntAutoPtr<ITexture>            irradiance_map;
 
-void GLTFMesh::initialize(SceneManager* manager)
+    std::uint64_t camera_frame[2] = {~std::uint64_t(0), ~std::uint64_t(0)};
+    std::uint64_t light_frame = ~std::uint64_t(0);
+
+    /// Returns the renderer of the scene manager, it is created when it does not exist yet
+    static std::shared_ptr<GLTFSharedRenderer> get(SceneManager* manager);
+
+    GLTFSharedRenderer(SceneManager* manager);
+
+    /// Precomputes the IBL cubemaps again if the environment map of the scene manager has changed
+    void updateEnvironment(SceneManager* manager);
+
+    /// Copies the IBL cubemaps of the scene manager into the ones of the renderer, false if they do not match
+    bool copyCubemaps(SceneManager* manager);
+
+    IBuffer* cameraAttribs(SceneManager* manager, bool local_frame);
+    IBuffer* lightAttribs(SceneManager* manager);
+};
+
+std::shared_ptr<GLTFSharedRenderer> GLTFSharedRenderer::get(SceneManager* manager)
 {
-    RefCntAutoPtr<ITexture> env_map = manager->getEnvironmentMap();
+    std::shared_ptr<GLTFSharedRenderer> renderer = manager->getGLTFRenderer().lock();
+    if(!renderer)
+    {
+        renderer = std::make_shared<GLTFSharedRenderer>(manager);
+        manager->getGLTFRenderer() = renderer;
+    }
 
-    if(env_map)
-        d->env_map_srv = env_map->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE);
+    renderer->updateEnvironment(manager);
+    return renderer;
+}
 
+GLTFSharedRenderer::GLTFSharedRenderer(SceneManager* manager)
+{
     GLTF_PBR_Renderer::CreateInfo renderer_ci;
     renderer_ci.RTVFmt         = manager->swapChain()->GetDesc().ColorBufferFormat;
     renderer_ci.DSVFmt         = manager->swapChain()->GetDesc().DepthBufferFormat;
     renderer_ci.AllowDebugView = false;
     renderer_ci.UseIBL         = true;
     renderer_ci.FrontCCW       = true;
-    d->renderer.reset(new GLTF_PBR_Renderer(manager->device(), manager->context(), renderer_ci));
-
+    renderer.reset(new GLTF_PBR_Renderer(manager->device(), manager->context(), renderer_ci));
 
-    CreateUniformBuffer(manager->device(), sizeof(CameraAttribs), "Camera attribs buffer", &d->camera_attribs_cb);
-    CreateUniformBuffer(manager->device(), sizeof(LightAttribs), "Light attribs buffer", &d->light_attribs_cb);
-    CreateUniformBuffer(manager->device(), sizeof(EnvMapRenderAttribs), "Env map render attribs buffer", &d->env_map_attribs_cb);
+    CreateUniformBuffer(manager->device(), sizeof(CameraAttribs), "Camera attribs buffer", &camera_attribs_cb[0]);
+    CreateUniformBuffer(manager->device(), sizeof(CameraAttribs), "Local camera attribs buffer", &camera_attribs_cb[1]);
+    CreateUniformBuffer(manager->device(), sizeof(LightAttribs), "Light attribs buffer", &light_attribs_cb);
+    CreateUniformBuffer(manager->device(), sizeof(EnvMapRenderAttribs), "Env map render attribs buffer", &env_map_attribs_cb);
 
     StateTransitionDesc barriers [] =
     {
-        {d->camera_attribs_cb,  RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_CONSTANT_BUFFER, true},
-        {d->light_attribs_cb,   RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_CONSTANT_BUFFER, true},
-        {d->env_map_attribs_cb, RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_CONSTANT_BUFFER, true}//,
-        //{env_map,                RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_SHADER_RESOURCE, true}
+        {camera_attribs_cb[0], RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_CONSTANT_BUFFER, true},
+        {camera_attribs_cb[1], RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_CONSTANT_BUFFER, true},
+        {light_attribs_cb,     RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_CONSTANT_BUFFER, true},
+        {env_map_attribs_cb,   RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_CONSTANT_BUFFER, true}
     };
     manager->context()->TransitionResourceStates(_countof(barriers), barriers);
+}
+
+void GLTFSharedRenderer::updateEnvironment(SceneManager* manager)
+{
+    RefCntAutoPtr<ITexture> map = manager->getEnvironmentMap();
+    if(!map || (map == env_map && manager->getIrradianceMap() == irradiance_map))
+        return;
+
+    // the model bindings refer to the cubemaps of the renderer, which are overwritten here, hence they remain valid
+    env_map = map;
+    irradiance_map = manager->getIrradianceMap();
+    if(!copyCubemaps(manager))
+    {
+        renderer->PrecomputeCubemaps(manager->device(), manager->context(), env_map->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+        manager->getEnvironmentLoader().store(renderer->GetIrradianceCubeSRV()->GetTexture(),
+                                              renderer->GetPrefilteredEnvMapSRV()->GetTexture());
+    }
+}
 
-    if(d->env_map_srv)
-        d->renderer->PrecomputeCubemaps(manager->device(), manager->context(), d->env_map_srv);
+bool GLTFSharedRenderer::copyCubemaps(SceneManager* manager)
+{
+    ITexture* sources[2] = {manager->getIrradianceMap(), manager->getPrefilteredEnvironmentMap()};
+    ITexture* targets[2] = {renderer->GetIrradianceCubeSRV()->GetTexture(), renderer->GetPrefilteredEnvMapSRV()->GetTexture()};
 
-    d->model.reset(new GLTF::Model(manager->device(), manager->context(), d->filename));
+    for(int i=0; i<2; ++i)
+    {
+        if(!sources[i])
+            return false;
+
+        const TextureDesc& src = sources[i]->GetDesc();
+        const TextureDesc& dst = targets[i]->GetDesc();
+        if(src.Width != dst.Width || src.Height != dst.Height || src.Format != dst.Format ||
+           src.MipLevels != dst.MipLevels || src.ArraySize != dst.ArraySize)
+            return false;
+    }
 
-    d->renderer->InitializeResourceBindings(*d->model, d->camera_attribs_cb, d->light_attribs_cb);
+    for(int i=0; i<2; ++i)
+    {
+        const TextureDesc& desc = targets[i]->GetDesc();
+        for(std::uint32_t slice=0; slice<desc.ArraySize; ++slice)
+        {
+            for(std::uint32_t mip=0; mip<desc.MipLevels; ++mip)
+            {
+                CopyTextureAttribs copy(sources[i], RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                        targets[i], RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+                copy.SrcMipLevel = mip;
+                copy.SrcSlice = slice;
+                copy.DstMipLevel = mip;
+                copy.DstSlice = slice;
+                manager->context()->CopyTexture(copy);
+            }
+        }
+
+        StateTransitionDesc barrier{targets[i], RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_SHADER_RESOURCE, true};
+        manager->context()->TransitionResourceStates(1, &barrier);
+    }
 
-    d->initialized = true;
+    return true;
 }
 
-void GLTFMesh::useLocalWorldFrame(bool use_local_frame) 
+IBuffer* GLTFSharedRenderer::cameraAttribs(SceneManager* manager, bool local_frame)
 {
-    d->use_local_frame = use_local_frame;
+    int i = local_frame ? 1 : 0;
+    if(camera_frame[i] == manager->getFrameNumber())
+        return camera_attribs_cb[i];
+    camera_frame[i] = manager->getFrameNumber();
+
+    // the local frame is centered at the camera, hence it only differs from the view in the translation
+    Vector3 camera_position;
+    Matrix4 view_proj;
+    if(local_frame)
+    {
+        Matrix4 view_T_local = manager->getView();
+        view_T_local.block<3,1>(0,3).setZero();
+        camera_position.setZero();
+        view_proj = manager->getProj()*view_T_local;
+    }
+    else
+    {
+        camera_position = manager->getCameraWorldPosition();
+        view_proj = manager->getViewProj();
+    }
+
+    MapHelper<CameraAttribs> cam_attribs(manager->context(), camera_attribs_cb[i], MAP_WRITE, MAP_FLAG_DISCARD);
+
+    matrix_to_float4x4(manager->getProj(), cam_attribs->mProjT);
+    matrix_to_float4x4(view_proj, cam_attribs->mViewProjT);
+
+    Matrix4 view_proj_inv = view_proj.inverse();
+    matrix_to_float4x4(view_proj_inv, cam_attribs->mViewProjInvT);
+
+    float3 p;
+    vector_to_float3(camera_position, p);
+    cam_attribs->f4Position = float4(p, 1);
+
+    return camera_attribs_cb[i];
 }
 
-void GLTFMesh::render(SceneManager* manager)
+IBuffer* GLTFSharedRenderer::lightAttribs(SceneManager* manager)
 {
-    if(!d->initialized)
-        initialize(manager);
+    if(light_frame == manager->getFrameNumber())
+        return light_attribs_cb;
+    light_frame = manager->getFrameNumber();
 
-    SceneManager::GlobalLight light = manager->getGlobalLight();
+    const SceneManager::GlobalLight& light = manager->getGlobalLight();
 
-    Vector3 camera_local;
-    Matrix4 local_T_model;
-    Matrix4 view_proj_local;
-    
-    if(d->use_local_frame)
+    MapHelper<LightAttribs> light_attribs(manager->context(), light_attribs_cb, MAP_WRITE, MAP_FLAG_DISCARD);
+
+    vector_to_float4_w0(light.direction, light_attribs->f4Direction);
+
+    float4 light_color;
+    vector_to_float4(light.color.toVector(), light_color);
+    light_attribs->f4Intensity = light_color * light.intensity;
+
+    return light_attribs_cb;
+}
+
+
+struct GLTFMesh::Pimpl
+{
+    std::shared_ptr<GLTFSharedRenderer>   shared;
+    std::unique_ptr<GLTF::Model>          model;
+
+    bool initialized = false;
+    bool use_local_frame = true;
+    bool bindings_local_frame = true; // frame of the camera buffer in the resource bindings of the model
+
+    std::string filename;
+
+    std::shared_ptr<GLTFAsyncLoad> async_load;
+
+    void createRenderer(SceneManager* manager);
+    void createModel(SceneManager* manager);
+    void releaseModel();
+
+    void cancelLoad();
+
+    // render task of the asynchronous load, returns true when done
+    bool continueLoad(SceneManager* manager, GLTFAsyncLoad& load);
+};
+
+
+GLTFMesh::GLTFMesh()
+{
+    d.reset(new Pimpl);
+}
+
+GLTFMesh::~GLTFMesh()
+{
+    d->cancelLoad();
+    d->releaseModel();
+}
+
+void GLTFMesh::load(const std::string& filename)
+{
+    d->cancelLoad();
+    d->releaseModel();
+    d->filename = filename;
+    d->initialized = false;
+}
+
+void GLTFMesh::initialize(SceneManager* manager)
+{
+    d->createRenderer(manager);
+    d->createModel(manager);
+}
+
+std::shared_future<void> GLTFMesh::loadAsync(SceneManager* manager, const std::string& filename, LoadCallback callback)
+{
+    load(filename);
+
+    std::shared_ptr<GLTFAsyncLoad> state = std::make_shared<GLTFAsyncLoad>();
+    state->future = state->promise.get_future().share();
+    state->callback = std::move(callback);
+    d->async_load = state;
+
+    manager->getWorkerPool().enqueue([state, filename]()
+    {
+        std::exception_ptr error;
+        try
+        {
+            prefetchModel(filename, state->cancelled);
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->error = error;
+        state->prefetched = true;
+    });
+
+    // the task keeps the state alive, but must not touch the mesh after it was cancelled
+    Pimpl* pimpl = d.get();
+    manager->addRenderTask([state, pimpl](SceneManager* manager)
     {
-        Matrix4 view_T_world = manager->getView();
-        Matrix4 inv_view_T_world = view_T_world.inverse();
-        Matrix4 world_T_model = getNode()->getDerivedTransform();
-        Matrix4 world_T_local = Matrix4::Identity();
-        world_T_local.block<3,1>(0,3) = inv_view_T_world.block<3,1>(0,3);
+        if(state->cancelled)
+            return true;
+        return pimpl->continueLoad(manager, *state);
+    });
+
+    return state->future;
+}
+
+bool GLTFMesh::isLoading() const
+{
+    return d->async_load && !d->async_load->finished;
+}
 
-        Matrix4 view_T_local = view_T_world * world_T_local;
-        Matrix4 inv_view_T_local = view_T_local.inverse();
+void GLTFMesh::Pimpl::cancelLoad()
+{
+    if(!async_load)
+        return;
 
-        local_T_model = world_T_local.inverse()*world_T_model;
-        camera_local  = inv_view_T_local.block<3,1>(0,3);
-        view_proj_local = manager->getProj()*view_T_local;
+    async_load->cancelled = true;
+    if(!async_load->finished)
+    {
+        async_load->finished = true;
+        async_load->promise.set_exception(std::make_exception_ptr(std::runtime_error("Loading was cancelled")));
     }
-    else
+    async_load.reset();
+}
+
+bool GLTFMesh::Pimpl::continueLoad(SceneManager* manager, GLTFAsyncLoad& load)
+{
     {
-        local_T_model = getNode()->getDerivedTransform();
-        camera_local = manager->getCameraWorldPosition();
-        view_proj_local = manager->getViewProj();
+        std::lock_guard<std::mutex> lock(load.mutex);
+        if(!load.prefetched)
+            return false;
     }
 
-    { // map helper scope
-        MapHelper<CameraAttribs> cam_attribs(manager->context(), d->camera_attribs_cb, MAP_WRITE, MAP_FLAG_DISCARD);
+    if(load.error)
+    {
+        load.finish(load.error);
+        return true;
+    }
 
-        matrix_to_float4x4(manager->getProj(), cam_attribs->mProjT);
-        matrix_to_float4x4(view_proj_local, cam_attribs->mViewProjT);
-        
-        Matrix4 view_proj_inv =  view_proj_local.inverse();
-        matrix_to_float4x4(view_proj_inv, cam_attribs->mViewProjInvT);
+    // the renderer (including the precomputed cubemaps) and the model are created in separate frames
+    try
+    {
+        if(load.stage++ == 0)
+        {
+            createRenderer(manager);
+            return false;
+        }
 
-        float3 p;
-        vector_to_float3(camera_local, p);
-        cam_attribs->f4Position    = float4(p, 1);
+        createModel(manager);
+    }
+    catch(...)
+    {
+        load.finish(std::current_exception());
+        return true;
     }
 
-    { // map helper scope
-        MapHelper<LightAttribs> light_attribs(manager->context(), d->light_attribs_cb, MAP_WRITE, MAP_FLAG_DISCARD);
+    load.finish(nullptr);
+    return true;
+}
+
+void GLTFMesh::Pimpl::createRenderer(SceneManager* manager)
+{
+    shared = GLTFSharedRenderer::get(manager);
+}
+
+void GLTFMesh::Pimpl::createModel(SceneManager* manager)
+{
+    model.reset(new GLTF::Model(manager->device(), manager->context(), filename));
+
+    bindings_local_frame = use_local_frame;
+    shared->renderer->InitializeResourceBindings(*model, shared->camera_attribs_cb[use_local_frame ? 1 : 0],
+                                                 shared->light_attribs_cb);
+
+    initialized = true;
+}
+
+void GLTFMesh::Pimpl::releaseModel()
+{
+    // the bindings are stored in the shared renderer
+    if(model && shared)
+        shared->renderer->ReleaseResourceBindings(*model);
+
+    model.reset();
+    initialized = false;
+}
+
+void GLTFMesh::useLocalWorldFrame(bool use_local_frame) 
+{
+    d->use_local_frame = use_local_frame;
+}
+
+void GLTFMesh::render(SceneManager* manager)
+{
+    if(!d->initialized)
+    {
+        // not drawn while loading asynchronously or after a failed asynchronous load
+        if(d->async_load)
+            return;
+        initialize(manager);
+    }
 
-        float3 light_direction;
-        vector_to_float4_w0(light.direction, light_attribs->f4Direction);
+    d->shared->updateEnvironment(manager);
 
-        float4 light_color;
-        vector_to_float4(light.color.toVector(), light_color);
-        light_attribs->f4Intensity = light_color * light.intensity;
+    if(d->bindings_local_frame != d->use_local_frame)
+    {
+        d->shared->renderer->ReleaseResourceBindings(*d->model);
+        d->shared->renderer->InitializeResourceBindings(*d->model, d->shared->camera_attribs_cb[d->use_local_frame ? 1 : 0],
+                                                        d->shared->light_attribs_cb);
+        d->bindings_local_frame = d->use_local_frame;
     }
 
+    // written only by the first mesh in this frame
+    d->shared->cameraAttribs(manager, d->use_local_frame);
+    d->shared->lightAttribs(manager);
+
+    Matrix4 local_T_model = getNode()->getDerivedTransform();
+    if(d->use_local_frame)
+        local_T_model.block<3,1>(0,3) -= manager->getCameraWorldPosition();
+
     GLTF_PBR_Renderer::RenderInfo render_params;
 
     matrix_to_float4x4t(local_T_model, render_params.ModelTransform);
 
     render_params.IBLScale = 0.5;
     render_params.OcclusionStrength = 1.0;
-    d->renderer->Render(manager->context(), *d->model, render_params);
+    d->shared->renderer->Render(manager->context(), *d->model, render_params);
 }
 
 GLTF::Model* GLTFMesh::getGLTFModel()
@@ -0,0 +1,543 @@
+#include <dg/objects/heightmap_object.hpp>
+
+#include <dg/core/conversion.hpp>
+#include <dg/core/frustum.hpp>
+#include <dg/scene/mesh_buffers.hpp>
+#include <dg/scene/scene_manager.hpp>
+#include <dg/material/shader_program.hpp>
+#include <dg/material/common_constants.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/SwapChain.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/PipelineState.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Texture.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace dg {
+
+static const char* g_heightmap_vs =
+DG_COMMON_CONSTANTS_VS_CODE
+R"===(
+cbuffer HeightmapConstants
+{
+    float4 g_color;
+    float3 g_lightDirection; // in view space
+    float  g_ambient;
+    float2 g_cellSize;
+    float2 g_maxSample;      // columns-1, rows-1
+};
+
+Texture2D g_Heights;
+
+struct VSInput
+{
+    float3 Grid : ATTRIB0; // sample offset in the tile, 1 for skirt vertices
+    float3 Tile : ATTRIB1; // first sample of the tile, depth of the skirt
+};
+
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+float height(float2 s)
+{
+    s = clamp(s, float2(0.0, 0.0), g_maxSample);
+    return g_Heights.Load(int3(int(s.x), int(s.y), 0)).r;
+}
+
+void main(in  VSInput VSIn,
+          out PSInput PSIn)
+{
+    float2 s = min(VSIn.Grid.xy + VSIn.Tile.xy, g_maxSample);
+    float h = height(s);
+
+    // normal from the central differences of the full resolution heights
+    float dx = height(s + float2(1.0, 0.0)) - height(s - float2(1.0, 0.0));
+    float dy = height(s + float2(0.0, 1.0)) - height(s - float2(0.0, 1.0));
+    float3 normal = normalize(float3(-dx / (2.0*g_cellSize.x), -dy / (2.0*g_cellSize.y), 1.0));
+
+    // the skirt vertices are moved down by the height range of the tile
+    h -= VSIn.Grid.z * VSIn.Tile.z;
+
+    PSIn.Pos = mul(g_worldViewProj, float4(s * g_cellSize, h, 1.0));
+
+    float3 view_normal = normalize(mul(g_worldView, float4(normal, 0.0)).xyz);
+    float diffuse = saturate(dot(view_normal, -g_lightDirection));
+    PSIn.Color = float4(g_color.rgb * (g_ambient + (1.0 - g_ambient) * diffuse), g_color.a);
+}
+)===";
+
+static const char* g_heightmap_ps =
+R"===(
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+struct PSOutput
+{
+    float4 Color : SV_TARGET;
+};
+
+void main(in  PSInput  PSIn,
+          out PSOutput PSOut)
+{
+    PSOut.Color = PSIn.Color;
+}
+)===";
+
+struct HeightmapConstants
+{
+    float color[4];
+    float light_direction[3];
+    float ambient;
+    float cell_size[2];
+    float max_sample[2];
+};
+
+static std::map<IRenderDevice*, std::weak_ptr<ShaderProgram>> g_shared_heightmap_programs;
+
+struct HeightmapObject::Pimpl
+{
+    std::shared_ptr<ShaderProgram> shader_program;
+    RefCntAutoPtr<IPipelineState>         pso;
+    RefCntAutoPtr<IShaderResourceBinding> srb;
+
+    RefCntAutoPtr<ITexture> texture;
+
+    // grid mesh of a tile for each level of detail
+    std::vector<MeshBuffers::Ptr> meshes;
+
+    struct Instance
+    {
+        float x, y;        // first sample of the tile
+        float skirt_depth;
+    };
+
+    RefCntAutoPtr<IBuffer> instance_buffer;
+    std::uint32_t instance_capacity = 0;
+    std::vector<std::vector<Instance>> visible; // per level of detail
+};
+
+
+// grid of (cells+1)^2 vertices with a spacing of step samples and a skirt around the border
+static MeshBuffers::Ptr createTileMesh(IRenderDevice* device, std::uint32_t tile_size, std::uint32_t step)
+{
+    std::uint32_t n = tile_size / step;
+
+    std::vector<float> vertices;
+    std::vector<std::uint32_t> indices;
+
+    for(std::uint32_t j=0; j<=n; ++j)
+        for(std::uint32_t i=0; i<=n; ++i)
+        {
+            vertices.push_back(float(i*step));
+            vertices.push_back(float(j*step));
+            vertices.push_back(0.0f);
+        }
+
+    for(std::uint32_t j=0; j<n; ++j)
+        for(std::uint32_t i=0; i<n; ++i)
+        {
+            std::uint32_t v = j*(n+1) + i;
+            indices.insert(indices.end(), {v, v+1, v+n+1, v+n+1, v+1, v+n+2});
+        }
+
+    // the border as a closed loop: bottom, right, top and left edge
+    std::vector<std::uint32_t> border;
+    for(std::uint32_t i=0; i<n; ++i) border.push_back(i);
+    for(std::uint32_t j=0; j<n; ++j) border.push_back(j*(n+1) + n);
+    for(std::uint32_t i=n; i>0; --i) border.push_back(n*(n+1) + i);
+    for(std::uint32_t j=n; j>0; --j) border.push_back(j*(n+1));
+
+    std::uint32_t first_skirt = (n+1)*(n+1);
+    for(std::uint32_t v : border)
+    {
+        vertices.push_back(vertices[3*v+0]);
+        vertices.push_back(vertices[3*v+1]);
+        vertices.push_back(1.0f);
+    }
+
+    for(std::uint32_t k=0; k<border.size(); ++k)
+    {
+        std::uint32_t k1 = (k+1) % border.size();
+        std::uint32_t g0 = border[k],        g1 = border[k1];
+        std::uint32_t s0 = first_skirt + k,  s1 = first_skirt + k1;
+        indices.insert(indices.end(), {g0, g1, s0, s0, g1, s1});
+    }
+
+    std::vector<LayoutElement> layout = {LayoutElement{0, 0, 3, VT_FLOAT32, false}};
+
+    return MeshBuffers::create(device, "HeightmapObject tile LOD" + std::to_string(step), layout, PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+                               vertices.data(), 3*sizeof(float), static_cast<std::uint32_t>(vertices.size()/3),
+                               indices.data(), static_cast<std::uint32_t>(indices.size()));
+}
+
+
+HeightmapObject::HeightmapObject(SceneManager* manager, std::uint32_t tile_size) : manager_(manager), d(new Pimpl)
+{
+    tile_size_ = 4;
+    while(tile_size_ < tile_size && tile_size_ < 128)
+        tile_size_ *= 2;
+
+    // the coarsest level has 2x2 cells per tile
+    lod_levels_ = 1;
+    while((tile_size_ >> lod_levels_) >= 2)
+        ++lod_levels_;
+}
+
+HeightmapObject::~HeightmapObject()
+{
+
+}
+
+void HeightmapObject::setHeights(const float* heights, std::uint32_t columns, std::uint32_t rows, std::size_t stride)
+{
+    if(stride == 0)
+        stride = columns;
+
+    columns_ = columns;
+    rows_ = rows;
+    heights_.resize(std::size_t(columns)*rows);
+    for(std::uint32_t y=0; y<rows; ++y)
+        std::memcpy(&heights_[std::size_t(y)*columns], heights + y*stride, columns*sizeof(float));
+
+    // tiles share the samples at their borders
+    tiles_x_ = columns > 1 ? (columns - 2) / tile_size_ + 1 : 0;
+    tiles_y_ = rows > 1 ? (rows - 2) / tile_size_ + 1 : 0;
+    tiles_.resize(std::size_t(tiles_x_)*tiles_y_);
+
+    for(std::uint32_t ty=0; ty<tiles_y_; ++ty)
+        for(std::uint32_t tx=0; tx<tiles_x_; ++tx)
+        {
+            updateTileBounds(tx, ty);
+            tiles_[std::size_t(ty)*tiles_x_ + tx].dirty = false;
+        }
+
+    recreate_texture_ = true;
+    has_dirty_tiles_ = false;
+}
+
+void HeightmapObject::updateHeights(std::uint32_t x, std::uint32_t y, std::uint32_t columns, std::uint32_t rows,
+                                    const float* heights, std::size_t stride)
+{
+    if(columns > columns_ || x > columns_ - columns || rows > rows_ || y > rows_ - rows)
+        DG_THROW("The updated region is outside of the heightmap");
+
+    if(columns == 0 || rows == 0)
+        return;
+
+    if(stride == 0)
+        stride = columns;
+
+    for(std::uint32_t r=0; r<rows; ++r)
+        std::memcpy(&heights_[std::size_t(y+r)*columns_ + x], heights + r*stride, columns*sizeof(float));
+
+    // a single row or column has no tiles
+    if(tiles_.empty())
+        return;
+
+    // the samples at the borders of the tiles belong to both neighbors
+    std::uint32_t tx0 = x > 0 ? (x - 1) / tile_size_ : 0;
+    std::uint32_t ty0 = y > 0 ? (y - 1) / tile_size_ : 0;
+    std::uint32_t tx1 = std::min((x + columns - 1) / tile_size_, tiles_x_ - 1);
+    std::uint32_t ty1 = std::min((y + rows - 1) / tile_size_, tiles_y_ - 1);
+
+    for(std::uint32_t ty=ty0; ty<=ty1; ++ty)
+        for(std::uint32_t tx=tx0; tx<=tx1; ++tx)
+        {
+            updateTileBounds(tx, ty);
+            tiles_[std::size_t(ty)*tiles_x_ + tx].dirty = true;
+        }
+
+    has_dirty_tiles_ = true;
+}
+
+void HeightmapObject::updateTileBounds(std::uint32_t tx, std::uint32_t ty)
+{
+    Tile& tile = tiles_[std::size_t(ty)*tiles_x_ + tx];
+    tile.min_height = std::numeric_limits<float>::max();
+    tile.max_height = -std::numeric_limits<float>::max();
+
+    std::uint32_t x1 = std::min(tx*tile_size_ + tile_size_, columns_ - 1);
+    std::uint32_t y1 = std::min(ty*tile_size_ + tile_size_, rows_ - 1);
+
+    for(std::uint32_t y=ty*tile_size_; y<=y1; ++y)
+        for(std::uint32_t x=tx*tile_size_; x<=x1; ++x)
+        {
+            float h = heights_[std::size_t(y)*columns_ + x];
+            tile.min_height = std::min(tile.min_height, h);
+            tile.max_height = std::max(tile.max_height, h);
+        }
+}
+
+void HeightmapObject::uploadDirtyTiles(SceneManager* manager)
+{
+    IDeviceContext* context = manager->context();
+
+    // consecutive dirty tiles of a row are uploaded together
+    for(std::uint32_t ty=0; ty<tiles_y_; ++ty)
+    {
+        std::uint32_t tx = 0;
+        while(tx < tiles_x_)
+        {
+            if(!tiles_[std::size_t(ty)*tiles_x_ + tx].dirty)
+            {
+                ++tx;
+                continue;
+            }
+
+            std::uint32_t first = tx;
+            while(tx < tiles_x_ && tiles_[std::size_t(ty)*tiles_x_ + tx].dirty)
+                tiles_[std::size_t(ty)*tiles_x_ + tx++].dirty = false;
+
+            Box box;
+            box.MinX = first*tile_size_;
+            box.MaxX = std::min(tx*tile_size_ + 1, columns_);
+            box.MinY = ty*tile_size_;
+            box.MaxY = std::min((ty+1)*tile_size_ + 1, rows_);
+
+            TextureSubResData subres_data;
+            subres_data.pData  = &heights_[std::size_t(box.MinY)*columns_ + box.MinX];
+            subres_data.Stride = columns_ * sizeof(float);
+            context->UpdateTexture(d->texture, 0, 0, box, subres_data, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        }
+    }
+
+    has_dirty_tiles_ = false;
+}
+
+void HeightmapObject::render(SceneManager* manager)
+{
+    visible_tile_count_ = 0;
+
+    if(tiles_.empty())
+        return;
+
+    IRenderDevice* device = manager->device();
+    IDeviceContext* context = manager->context();
+
+    if(!d->pso)
+    {
+        std::weak_ptr<ShaderProgram>& shared_shader_program = g_shared_heightmap_programs[device];
+        if(shared_shader_program.expired())
+        {
+            d->shader_program = std::make_shared<ShaderProgram>();
+            d->shader_program->setShaders(device, "HeightmapObject_shader", g_heightmap_vs, g_heightmap_ps);
+            d->shader_program->addConstant<CommonConstantsVS>(device, "CommonConstantsVS");
+            d->shader_program->addConstant<HeightmapConstants>(device, "HeightmapConstants");
+            shared_shader_program = d->shader_program;
+        }
+        else
+            d->shader_program = shared_shader_program.lock();
+
+        PipelineStateCreateInfo pso_create_info;
+        PipelineStateDesc& desc = pso_create_info.PSODesc;
+
+        desc.Name = "HeightmapObject PSO";
+        desc.IsComputePipeline = false;
+        desc.GraphicsPipeline.NumRenderTargets  = 1;
+        desc.GraphicsPipeline.RTVFormats[0]     = manager->swapChain()->GetDesc().ColorBufferFormat;
+        desc.GraphicsPipeline.DSVFormat         = manager->swapChain()->GetDesc().DepthBufferFormat;
+        desc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+        desc.GraphicsPipeline.pVS = d->shader_program->getVertexShader();
+        desc.GraphicsPipeline.pPS = d->shader_program->getPixelShader();
+
+        desc.GraphicsPipeline.PrimitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        desc.GraphicsPipeline.RasterizerDesc.CullMode = CULL_MODE_NONE;
+        desc.GraphicsPipeline.DepthStencilDesc.DepthEnable = true;
+
+        LayoutElement layout[] =
+        {
+            {0, 0, 3, VT_FLOAT32, false},                                      // grid
+            {1, 1, 3, VT_FLOAT32, false, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE} // tile
+        };
+        desc.GraphicsPipeline.InputLayout.LayoutElements = layout;
+        desc.GraphicsPipeline.InputLayout.NumElements = _countof(layout);
+
+        static ShaderResourceVariableDesc vars[] =
+        {
+            {SHADER_TYPE_VERTEX, "g_Heights", SHADER_RESOURCE_VARIABLE_TYPE_MUTABLE}
+        };
+        desc.ResourceLayout.Variables    = vars;
+        desc.ResourceLayout.NumVariables = _countof(vars);
+
+        device->CreatePipelineState(pso_create_info, &d->pso);
+        d->shader_program->bind(d->pso);
+
+        for(std::uint32_t level=0; level<lod_levels_; ++level)
+            d->meshes.push_back(createTileMesh(device, tile_size_, 1u << level));
+    }
+
+    if(recreate_texture_)
+    {
+        TextureDesc desc;
+        desc.Name      = "HeightmapObject heights";
+        desc.Type      = RESOURCE_DIM_TEX_2D;
+        desc.Width     = columns_;
+        desc.Height    = rows_;
+        desc.MipLevels = 1;
+        desc.Usage     = USAGE_DEFAULT;
+        desc.BindFlags = BIND_SHADER_RESOURCE;
+        desc.Format    = TEX_FORMAT_R32_FLOAT;
+
+        TextureSubResData sub_data;
+        sub_data.pData  = heights_.data();
+        sub_data.Stride = columns_ * sizeof(float);
+
+        TextureData tex_data;
+        tex_data.pSubResources   = &sub_data;
+        tex_data.NumSubresources = 1;
+
+        d->texture.Release();
+        device->CreateTexture(desc, &tex_data, &d->texture);
+
+        // mutable variables are set once, hence a new texture gets a new SRB
+        d->srb.Release();
+        d->pso->CreateShaderResourceBinding(&d->srb, true);
+        d->srb->GetVariableByName(SHADER_TYPE_VERTEX, "g_Heights")->Set(d->texture->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+
+        recreate_texture_ = false;
+        has_dirty_tiles_ = false;
+        for(Tile& tile : tiles_)
+            tile.dirty = false;
+    }
+
+    if(has_dirty_tiles_)
+        uploadDirtyTiles(manager);
+
+    // select the visible tiles and their levels of detail
+
+    const Matrix4& world_view_proj = manager->getWorldViewProj();
+    const Matrix4& world_view = manager->getWorldView();
+    const Matrix4& proj = manager->getProj();
+
+    Real scale = world_view.block<3,3>(0,0).colwise().norm().maxCoeff();
+    Real pixels_per_unit = proj(1,1) * 0.5 * manager->swapChain()->GetDesc().Height * scale;
+    bool perspective = proj(3,2) != 0.0;
+    float cell_size = std::max(cell_size_.x(), cell_size_.y());
+
+    d->visible.resize(lod_levels_);
+    for(auto& instances : d->visible)
+        instances.clear();
+
+    for(std::uint32_t ty=0; ty<tiles_y_; ++ty)
+        for(std::uint32_t tx=0; tx<tiles_x_; ++tx)
+        {
+            const Tile& tile = tiles_[std::size_t(ty)*tiles_x_ + tx];
+
+            Vector3f min(tx*tile_size_*cell_size_.x(), ty*tile_size_*cell_size_.y(), tile.min_height);
+            Vector3f max(std::min(tx*tile_size_ + tile_size_, columns_ - 1)*cell_size_.x(),
+                         std::min(ty*tile_size_ + tile_size_, rows_ - 1)*cell_size_.y(), tile.max_height);
+
+            if(!isBoxVisible(world_view_proj, min, max))
+                continue;
+
+            // size of a cell on the screen at the point of the bounding sphere that is closest to the camera
+            Real pixels = cell_size * pixels_per_unit;
+            if(perspective)
+            {
+                Vector3 center = (0.5*(min+max)).cast<Real>();
+                Real radius = 0.5*(max-min).cast<Real>().norm();
+                Real distance = (world_view * center.homogeneous()).head<3>().norm() - radius*scale;
+                pixels /= std::max(distance, Real(1e-6));
+            }
+
+            std::uint32_t level = 0;
+            while(level+1 < lod_levels_ && Real(2u << level) * pixels <= lod_pixel_size_)
+                ++level;
+
+            d->visible[level].push_back({float(tx*tile_size_), float(ty*tile_size_), tile.max_height - tile.min_height});
+            ++visible_tile_count_;
+        }
+
+    if(visible_tile_count_ == 0)
+        return;
+
+    if(d->instance_capacity < tiles_.size())
+    {
+        d->instance_capacity = static_cast<std::uint32_t>(tiles_.size());
+
+        BufferDesc desc;
+        desc.Name           = "HeightmapObject instance buffer";
+        desc.Usage          = USAGE_DYNAMIC;
+        desc.BindFlags      = BIND_VERTEX_BUFFER;
+        desc.CPUAccessFlags = CPU_ACCESS_WRITE;
+        desc.uiSizeInBytes  = d->instance_capacity * sizeof(Pimpl::Instance);
+        d->instance_buffer.Release();
+        device->CreateBuffer(desc, nullptr, &d->instance_buffer);
+    }
+
+    {
+        MapHelper<Pimpl::Instance> instances(context, d->instance_buffer, MAP_WRITE, MAP_FLAG_DISCARD);
+        Pimpl::Instance* dst = instances;
+        for(const auto& level_instances : d->visible)
+        {
+            std::memcpy(dst, level_instances.data(), level_instances.size()*sizeof(Pimpl::Instance));
+            dst += level_instances.size();
+        }
+    }
+
+    {
+        auto constants = d->shader_program->mapConstant<CommonConstantsVS>(context, "CommonConstantsVS");
+        matrix_to_float4x4t(manager->getWorldViewProj(), constants->g_worldViewProj);
+        matrix_to_float4x4t(manager->getWorldView(), constants->g_worldView);
+        matrix_to_float4x4t(manager->getView(), constants->g_view);
+    }
+
+    {
+        Vector3 light = (manager->getView().block<3,3>(0,0) * manager->getGlobalLight().direction).normalized();
+
+        auto constants = d->shader_program->mapConstant<HeightmapConstants>(context, "HeightmapConstants");
+        constants->color[0] = color_.r;
+        constants->color[1] = color_.g;
+        constants->color[2] = color_.b;
+        constants->color[3] = color_.a;
+        constants->light_direction[0] = float(light.x());
+        constants->light_direction[1] = float(light.y());
+        constants->light_direction[2] = float(light.z());
+        constants->ambient = 0.3f;
+        constants->cell_size[0] = cell_size_.x();
+        constants->cell_size[1] = cell_size_.y();
+        constants->max_sample[0] = float(columns_ - 1);
+        constants->max_sample[1] = float(rows_ - 1);
+    }
+
+    context->SetPipelineState(d->pso);
+    context->CommitShaderResources(d->srb, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    std::uint32_t first_instance = 0;
+    for(std::uint32_t level=0; level<lod_levels_; ++level)
+    {
+        std::uint32_t count = static_cast<std::uint32_t>(d->visible[level].size());
+        if(count == 0)
+            continue;
+
+        const MeshBuffers& mesh = *d->meshes[level];
+
+        Uint32   offsets[] = {0, Uint32(first_instance * sizeof(Pimpl::Instance))};
+        IBuffer* buffs[] = {mesh.vertex_buffer, d->instance_buffer};
+        context->SetVertexBuffers(0, 2, buffs, offsets, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+        context->SetIndexBuffer(mesh.index_buffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+        DrawIndexedAttribs attr;
+        attr.IndexType    = mesh.index_type;
+        attr.NumIndices   = mesh.index_count;
+        attr.NumInstances = count;
+        attr.Flags = DRAW_FLAG_VERIFY_ALL;
+        context->DrawIndexed(attr);
+
+        first_instance += count;
+    }
+}
+
+}
@@ -4,6 +4,7 @@
 #include <dg/core/common.hpp>
 #include <dg/scene/node.hpp>
 #include <dg/scene/scene_manager.hpp>
+#include <dg/scene/mesh_buffers.hpp>
 
 #include <DiligentCore/Graphics/GraphicsEngine/interface/InputLayout.h>
 #include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
@@ -52,48 +53,73 @@ void ManualObject::begin(IMaterial::Ptr material, DepthStencilStateDesc depthSte
 
 void ManualObject::end()
 {
-    if(getNode())
-        getNode()->attach(current_section_.get());
+    if (!current_section_)
+        DG_THROW("You must call begin() before end()");
+
+    // the buffers are lent to the mesh data and returned afterwards to keep their capacity for the next section
+    MeshData data;
+    data.input_layout = current_section_->input_layout;
+    data.primitive_topology = current_section_->primitive_topology;
+    data.vertex_stride = static_cast<std::uint32_t>(vertex_size_);
+    data.vertex_count = static_cast<std::uint32_t>(vertex_count_);
+    buf_.resize(vertex_count_*vertex_size_);
+    data.vertices.swap(buf_);
+    idxbuf_.resize(index_count_);
+    data.indices.swap(idxbuf_);
+
+    prepare(data);
 
+    MeshBuffers::Ptr mesh = MeshBuffers::create(manager_->device(), "ManualObject", data);
+    std::unique_ptr<Section> section = std::move(current_section_);
+    addSection(std::move(section), *mesh);
 
-    //std::cout << "END: " << _buf.size() << ", " << _vertexSize << ", " << _vertexCount << std::endl;
-    //for(float d : _buf)
-    //    std::cout << d << std::endl;
+    buf_.swap(data.vertices);
+    idxbuf_.swap(data.indices);
+}
+
+std::function<void(MeshData&)> ManualObject::prepareFunction() const
+{
+    MeshOptimization optimization = mesh_optimization_;
+    bool generate_lods = generate_lods_;
+    LodOptions lod_options = lod_options_;
 
+    return [optimization, generate_lods, lod_options](MeshData& data)
+    {
+        if(optimization != MeshOptimization_None)
+            optimizeMesh(optimization, data);
 
-    BufferDesc vert_buff_desc;
-    vert_buff_desc.Name          = "ManualObject vertex buffer";
-    vert_buff_desc.Usage         = USAGE_STATIC;
-    vert_buff_desc.BindFlags     = BIND_VERTEX_BUFFER;
-    vert_buff_desc.uiSizeInBytes = vertex_size_*vertex_count_*sizeof(float);
+        if(generate_lods)
+            generateLods(data, lod_options);
+    };
+}
 
-    BufferData vb_data;
-    vb_data.pData    = buf_.data();
-    vb_data.DataSize = vert_buff_desc.uiSizeInBytes;
-    manager_->device()->CreateBuffer(vert_buff_desc, &vb_data, &current_section_->vertex_buffer);
+void ManualObject::addSection(IMaterial::Ptr material, const MeshData& data, const DepthStencilStateDesc& depth_stencil_desc)
+{
+    addSection(material, MeshBuffers::create(manager_->device(), "ManualObject", data), depth_stencil_desc);
+}
 
-    BufferDesc ind_buff_desc;
-    ind_buff_desc.Name          = "ManualObject index buffer";
-    ind_buff_desc.Usage         = USAGE_STATIC;
-    ind_buff_desc.BindFlags     = BIND_INDEX_BUFFER;
-    ind_buff_desc.uiSizeInBytes = index_count_*sizeof(std::uint32_t);
-    BufferData ib_data;
-    ib_data.pData    = idxbuf_.data();
-    ib_data.DataSize = ind_buff_desc.uiSizeInBytes;
-    manager_->device()->CreateBuffer(ind_buff_desc, &ib_data, &current_section_->index_buffer);
+void ManualObject::addSection(IMaterial::Ptr material, MeshBuffers::ConstPtr mesh, const DepthStencilStateDesc& depth_stencil_desc)
+{
+    std::unique_ptr<Section> section(new Section);
+    section->material = material;
+    section->render_order = render_order_;
+    section->depth_stencil_desc = depth_stencil_desc;
+    section->setPsoNeedsUpdate();
+    addSection(std::move(section), *mesh);
+}
 
-    current_section_->index_count = index_count_;
-    //std::cout << "VERTEXCOUNT: " << _vertexCount << std::endl;
-    //std::cout << "INDEXCOUNT: " << _indexCount << std::endl;
+void ManualObject::addSection(std::unique_ptr<Section> section, const MeshBuffers& mesh)
+{
+    mesh.applyTo(*section);
 
     // TODO:!!!
-    current_section_->rasterizer_desc.CullMode = CULL_MODE_NONE;
-    current_section_->rasterizer_desc.FrontCounterClockwise = true;
+    section->rasterizer_desc.CullMode = CULL_MODE_NONE;
+    section->rasterizer_desc.FrontCounterClockwise = true;
 
-    //_currentSection->_depthStencilDesc.DepthEnable = true;
-    //_currentSection->_depthStencilDesc.DepthWriteEnable = true;
+    if(getNode())
+        getNode()->attach(section.get());
 
-    sections_.push_back(std::move(current_section_));
+    sections_.push_back(std::move(section));
 }
 
 void ManualObject::position(float x, float y, float z)
@@ -103,15 +129,13 @@ void ManualObject::position(float x, float y, float z)
 
     if(vertex_count_==0)
     {
-        current_section_->input_layout.push_back(LayoutElement{0, 0, 3, VT_FLOAT32, false});
-        vertex_size_ += 3;
+        current_section_->input_layout.push_back(vertex_format_.positionElement());
+        vertex_size_ += vertex_format_.positionSize();
     }
 
     addVertex();
 
-    *buf_ptr_++ = x;
-    *buf_ptr_++ = y;
-    *buf_ptr_++ = z;
+    buf_ptr_ = vertex_format_.writePosition(buf_ptr_, x, y, z);
 }
 
 void ManualObject::normal(float x, float y, float z)
@@ -121,13 +145,11 @@ void ManualObject::normal(float x, float y, float z)
 
     if(vertex_count_==1)
     {
-        current_section_->input_layout.push_back(LayoutElement{1, 0, 3, VT_FLOAT32, false});
-        vertex_size_ += 3;
+        current_section_->input_layout.push_back(vertex_format_.normalElement());
+        vertex_size_ += vertex_format_.normalSize();
     }
 
-    *buf_ptr_++ = x;
-    *buf_ptr_++ = y;
-    *buf_ptr_++ = z;
+    buf_ptr_ = vertex_format_.writeNormal(buf_ptr_, x, y, z);
 }
 
 void ManualObject::color(const Color& col)
@@ -137,15 +159,11 @@ void ManualObject::color(const Color& col)
 
     if(vertex_count_==1)
     {
-        current_section_->input_layout.push_back(LayoutElement{2, 0, 4, VT_FLOAT32, false});
-        vertex_size_ += 4;
+        current_section_->input_layout.push_back(vertex_format_.colorElement());
+        vertex_size_ += vertex_format_.colorSize();
     }
 
-    *buf_ptr_++ = col.r;
-    *buf_ptr_++ = col.g;
-    *buf_ptr_++ = col.b;
-    *buf_ptr_++ = col.a;
-
+    buf_ptr_ = vertex_format_.writeColor(buf_ptr_, col);
 }
 
 void ManualObject::color(float r, float g, float b, float a)
@@ -160,12 +178,11 @@ void ManualObject::textureCoord(float u, float v)
 
     if(vertex_count_==1)
     {
-        current_section_->input_layout.push_back(LayoutElement{3, 0, 2, VT_FLOAT32, false});
-        vertex_size_ += 2;
+        current_section_->input_layout.push_back(vertex_format_.uvElement());
+        vertex_size_ += vertex_format_.uvSize();
     }
 
-    *buf_ptr_++ = u;
-    *buf_ptr_++ = v;
+    buf_ptr_ = vertex_format_.writeUV(buf_ptr_, u, v);
 }
 
 void ManualObject::index(std::uint32_t idx)
@@ -206,7 +223,7 @@ void ManualObject::addVertex()
     if(size > buf_.size())
     {
         //< "RESIZE before: " << _buf.size() << std::endl;
-        buf_.resize(std::max<std::size_t>(buf_.size()*2, 128));
+        buf_.resize(std::max<std::size_t>(buf_.size()*2, 512));
         //std::cout << "RESIZE after: " << _buf.size() << std::endl;
     }
 
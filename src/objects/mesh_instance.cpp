@@ -0,0 +1,69 @@
+#include <dg/objects/mesh_instance.hpp>
+
+#include <dg/scene/node.hpp>
+#include <dg/scene/scene_manager.hpp>
+
+namespace dg {
+
+MeshInstance::MeshInstance(SceneManager* manager, SharedMesh::Ptr mesh, IMaterial::Ptr material) :
+    Object(type_id<MeshInstance>()), manager_(manager), mesh_(std::move(mesh))
+{
+    if(!mesh_)
+        DG_THROW("MeshInstance requires a mesh");
+
+    for(const MeshBuffers::ConstPtr& buffers : mesh_->sections)
+    {
+        std::unique_ptr<Section> section(new Section);
+        buffers->applyTo(*section);
+
+        // like ManualObject, since the meshes of files often have inconsistent winding
+        section->rasterizer_desc.CullMode = CULL_MODE_NONE;
+        section->rasterizer_desc.FrontCounterClockwise = true;
+
+        sections_.push_back(std::move(section));
+    }
+
+    setMaterial(material);
+}
+
+MeshInstance::MeshInstance(SceneManager* manager, const std::string& filename, IMaterial::Ptr material) :
+    MeshInstance(manager, manager->getMeshManager().load(filename), material)
+{
+}
+
+MeshInstance::~MeshInstance()
+{
+}
+
+void MeshInstance::setMaterial(IMaterial::Ptr material)
+{
+    for(std::size_t i=0; i<sections_.size(); ++i)
+        setMaterial(i, material);
+}
+
+void MeshInstance::setMaterial(std::size_t section, IMaterial::Ptr material)
+{
+    Section& s = *sections_.at(section);
+    s.material = material ? material : manager_->getMeshManager().getDefaultMaterial();
+    s.setPsoNeedsUpdate();
+}
+
+void MeshInstance::setRenderOrder(RenderOrder order)
+{
+    for(auto& s : sections_)
+        s->setRenderOrder(order);
+}
+
+void MeshInstance::onAttached(Node* node)
+{
+    for(auto& s : sections_)
+        node->attach(s.get());
+}
+
+void MeshInstance::onDetached(Node* node)
+{
+    for(auto& s : sections_)
+        node->detach(s.get());
+}
+
+}
@@ -0,0 +1,189 @@
+#include <dg/objects/point_cloud_object.hpp>
+
+#include <dg/core/frustum.hpp>
+#include <dg/scene/scene_manager.hpp>
+#include <dg/internal/point_cloud_pipeline.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+
+#include <cstring>
+#include <limits>
+
+namespace dg {
+
+struct PointCloudObject::Chunk
+{
+    RefCntAutoPtr<IBuffer> buffer;
+    std::uint32_t count = 0;
+    Vector3f min = Vector3f::Constant(std::numeric_limits<float>::max());
+    Vector3f max = Vector3f::Constant(-std::numeric_limits<float>::max());
+};
+
+struct PointCloudObject::Pimpl
+{
+    PointCloudPipeline pipeline;
+    std::vector<Chunk> chunks;
+};
+
+
+PointCloudObject::PointCloudObject(SceneManager* manager, std::uint32_t chunk_size) :
+    manager_(manager), chunk_size_(std::max<std::uint32_t>(chunk_size, 1)), d(new Pimpl)
+{
+}
+
+PointCloudObject::~PointCloudObject()
+{
+
+}
+
+void PointCloudObject::setPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count)
+{
+    clear();
+    append(positions, colors, count, AttributeType::Color);
+}
+
+void PointCloudObject::setPoints(const Vector3f* positions, const float* intensities, std::size_t count)
+{
+    clear();
+    append(positions, intensities, count, AttributeType::Intensity);
+}
+
+void PointCloudObject::setPoints(const Vector3f* positions, std::size_t count, const Color& color)
+{
+    clear();
+    std::vector<std::uint32_t> colors(count, color.toUInt32());
+    append(positions, colors.data(), count, AttributeType::Color);
+}
+
+void PointCloudObject::appendPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count)
+{
+    append(positions, colors, count, AttributeType::Color);
+}
+
+void PointCloudObject::appendPoints(const Vector3f* positions, const float* intensities, std::size_t count)
+{
+    append(positions, intensities, count, AttributeType::Intensity);
+}
+
+void PointCloudObject::clear(bool release_memory)
+{
+    point_count_ = 0;
+
+    if(release_memory)
+    {
+        d->chunks.clear();
+        staging_ = std::vector<Point>();
+        return;
+    }
+
+    for(Chunk& chunk : d->chunks)
+    {
+        chunk.count = 0;
+        chunk.min = Vector3f::Constant(std::numeric_limits<float>::max());
+        chunk.max = Vector3f::Constant(-std::numeric_limits<float>::max());
+    }
+}
+
+void PointCloudObject::setColormap(Colormap colormap, float min_intensity, float max_intensity)
+{
+    colormap_ = colormap;
+    min_intensity_ = min_intensity;
+    max_intensity_ = max_intensity;
+}
+
+template <typename Attribute>
+void PointCloudObject::append(const Vector3f* positions, const Attribute* attributes, std::size_t count, AttributeType type)
+{
+    static_assert(sizeof(Attribute) == sizeof(std::uint32_t), "point attributes must have 4 bytes");
+
+    if(point_count_ > 0 && type != attribute_type_)
+        DG_THROW("Points with colors and points with intensities cannot be mixed");
+
+    attribute_type_ = type;
+
+    // fill the chunks piecewise, each piece is uploaded with a single buffer update
+    while(count > 0)
+    {
+        std::size_t first = point_count_;
+        std::size_t chunk_offset = first % chunk_size_;
+        std::size_t n = std::min<std::size_t>(count, chunk_size_ - chunk_offset);
+
+        staging_.resize(n);
+        for(std::size_t i=0; i<n; ++i)
+        {
+            Point& p = staging_[i];
+            p.x = positions[i].x();
+            p.y = positions[i].y();
+            p.z = positions[i].z();
+            std::memcpy(&p.attribute, &attributes[i], sizeof(p.attribute));
+        }
+
+        upload(first, n);
+
+        positions += n;
+        attributes += n;
+        count -= n;
+    }
+}
+
+void PointCloudObject::upload(std::size_t first, std::size_t count)
+{
+    std::size_t chunk_index = first / chunk_size_;
+    std::size_t chunk_offset = first % chunk_size_;
+
+    if(chunk_index >= d->chunks.size())
+        d->chunks.resize(chunk_index+1);
+
+    Chunk& chunk = d->chunks[chunk_index];
+    if(!chunk.buffer)
+    {
+        BufferDesc desc;
+        desc.Name          = "PointCloudObject chunk buffer";
+        desc.Usage         = USAGE_DEFAULT;
+        desc.BindFlags     = BIND_VERTEX_BUFFER;
+        desc.uiSizeInBytes = chunk_size_ * sizeof(Point);
+        manager_->device()->CreateBuffer(desc, nullptr, &chunk.buffer);
+    }
+
+    manager_->context()->UpdateBuffer(chunk.buffer, chunk_offset * sizeof(Point), count * sizeof(Point), staging_.data(),
+                                      RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    for(std::size_t i=0; i<count; ++i)
+    {
+        Vector3f p(staging_[i].x, staging_[i].y, staging_[i].z);
+        chunk.min = chunk.min.cwiseMin(p);
+        chunk.max = chunk.max.cwiseMax(p);
+    }
+
+    chunk.count = static_cast<std::uint32_t>(chunk_offset + count);
+    point_count_ = first + count;
+}
+
+void PointCloudObject::render(SceneManager* manager)
+{
+    if(point_count_ == 0)
+        return;
+
+    PointCloudPipeline::Parameters params;
+    params.use_intensity = attribute_type_ == AttributeType::Intensity;
+    params.colormap      = static_cast<int>(colormap_);
+    params.min_intensity = min_intensity_;
+    params.max_intensity = max_intensity_;
+    params.point_size    = point_size_;
+    params.round_points  = round_points_;
+
+    d->pipeline.begin(manager, params);
+
+    const Matrix4& world_view_proj = manager->getWorldViewProj();
+
+    for(const Chunk& chunk : d->chunks)
+    {
+        if(chunk.count == 0 || !isBoxVisible(world_view_proj, chunk.min, chunk.max))
+            continue;
+
+        d->pipeline.draw(manager->context(), chunk.buffer, chunk.count);
+    }
+}
+
+}
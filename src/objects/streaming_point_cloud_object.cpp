@@ -0,0 +1,309 @@
+#include <dg/objects/streaming_point_cloud_object.hpp>
+
+#include <dg/core/frustum.hpp>
+#include <dg/scene/scene_manager.hpp>
+#include <dg/internal/point_cloud_pipeline.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/SwapChain.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace dg {
+
+struct StreamingPointCloudObject::Pimpl
+{
+    PointCloudPipeline pipeline;
+
+    struct NodeState
+    {
+        RefCntAutoPtr<IBuffer> buffer;
+        std::size_t   size = 0;        // of the buffer in bytes
+        std::uint64_t last_drawn = 0;  // frame
+        std::uint64_t last_wanted = 0; // frame
+        bool          requested = false; // queued, being read or ready
+    };
+
+    std::vector<NodeState> nodes;
+    std::vector<std::uint32_t> resident;
+    std::size_t gpu_memory = 0;
+    std::uint64_t frame = 1;
+
+    struct Candidate
+    {
+        float priority; // projected size in pixels
+        std::uint32_t node;
+    };
+
+    std::vector<std::uint32_t> stack;
+    std::vector<std::uint32_t> visible;
+    std::vector<Candidate> wanted;
+    std::vector<std::uint32_t> ready; // read by the loader, not uploaded yet
+
+    // loader thread, reads the pages of the requested nodes from the file
+    std::thread loader;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::uint32_t> requests;
+    std::vector<std::uint32_t> loaded;
+    bool stop = false;
+
+    void load(const PointCloudOctree* octree)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true)
+        {
+            condition.wait(lock, [this]{ return stop || !requests.empty(); });
+            if(stop)
+                return;
+
+            std::uint32_t node = requests.front();
+            requests.pop_front();
+
+            lock.unlock();
+            octree->prefetch(node);
+            lock.lock();
+
+            loaded.push_back(node);
+        }
+    }
+};
+
+
+StreamingPointCloudObject::StreamingPointCloudObject(SceneManager* manager, const std::string& filename) :
+    StreamingPointCloudObject(manager, PointCloudOctree::open(filename))
+{
+}
+
+StreamingPointCloudObject::StreamingPointCloudObject(SceneManager* manager, PointCloudOctree::Ptr octree) :
+    manager_(manager), octree_(octree), d(new Pimpl)
+{
+    d->nodes.resize(octree_->getNodeCount());
+    d->loader = std::thread(&Pimpl::load, d.get(), octree_.get());
+}
+
+StreamingPointCloudObject::~StreamingPointCloudObject()
+{
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->stop = true;
+    }
+    d->condition.notify_all();
+    d->loader.join();
+}
+
+std::size_t StreamingPointCloudObject::getGpuMemoryUsage() const
+{
+    return d->gpu_memory;
+}
+
+std::size_t StreamingPointCloudObject::getResidentNodeCount() const
+{
+    return d->resident.size();
+}
+
+void StreamingPointCloudObject::setColormap(Colormap colormap, float min_intensity, float max_intensity)
+{
+    colormap_ = colormap;
+    min_intensity_ = min_intensity;
+    max_intensity_ = max_intensity;
+}
+
+bool StreamingPointCloudObject::makeRoom(std::size_t bytes)
+{
+    while(d->gpu_memory + bytes > gpu_memory_budget_)
+    {
+        // evict the least recently drawn node, nodes drawn in the last frame are kept to avoid thrashing
+        auto lru = d->resident.end();
+        for(auto it = d->resident.begin(); it != d->resident.end(); ++it)
+            if(d->nodes[*it].last_drawn + 1 < d->frame &&
+               (lru == d->resident.end() || d->nodes[*it].last_drawn < d->nodes[*lru].last_drawn))
+                lru = it;
+
+        if(lru == d->resident.end())
+            return false;
+
+        Pimpl::NodeState& state = d->nodes[*lru];
+        state.buffer.Release();
+        d->gpu_memory -= state.size;
+        state.size = 0;
+
+        *lru = d->resident.back();
+        d->resident.pop_back();
+    }
+    return true;
+}
+
+void StreamingPointCloudObject::upload(SceneManager* manager)
+{
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->ready.insert(d->ready.end(), d->loaded.begin(), d->loaded.end());
+        d->loaded.clear();
+    }
+
+    std::uint32_t uploads = 0;
+    std::size_t kept = 0;
+    for(std::uint32_t node : d->ready)
+    {
+        Pimpl::NodeState& state = d->nodes[node];
+
+        // keep the nodes for the next frames, if the upload limit is reached
+        if(uploads >= max_uploads_per_frame_ && state.last_wanted + 1 >= d->frame)
+        {
+            d->ready[kept++] = node;
+            continue;
+        }
+
+        state.requested = false;
+
+        // the node is not needed anymore (e.g. the camera moved) or does not fit in the budget
+        std::size_t size = std::size_t(octree_->getNode(node).point_count) * sizeof(PointCloudOctree::Point);
+        if(state.buffer || size == 0 || state.last_wanted + 1 < d->frame || !makeRoom(size))
+            continue;
+
+        BufferDesc desc;
+        desc.Name          = "StreamingPointCloudObject node buffer";
+        desc.Usage         = USAGE_STATIC;
+        desc.BindFlags     = BIND_VERTEX_BUFFER;
+        desc.uiSizeInBytes = static_cast<Uint32>(size);
+
+        // the points are uploaded directly from the mapped file
+        BufferData data;
+        data.pData    = octree_->getPoints(node);
+        data.DataSize = desc.uiSizeInBytes;
+        manager->device()->CreateBuffer(desc, &data, &state.buffer);
+
+        state.size = size;
+        d->gpu_memory += size;
+        d->resident.push_back(node);
+        ++uploads;
+    }
+    d->ready.resize(kept);
+}
+
+void StreamingPointCloudObject::traverse(SceneManager* manager)
+{
+    const Matrix4& world_view_proj = manager->getWorldViewProj();
+    const Matrix4& world_view = manager->getWorldView();
+    const Matrix4& proj = manager->getProj();
+
+    // size of one local unit on the screen in pixels at a distance of one (perspective) or anywhere (orthographic)
+    Real scale = world_view.block<3,3>(0,0).colwise().norm().maxCoeff();
+    Real pixels_per_unit = proj(1,1) * 0.5 * manager->swapChain()->GetDesc().Height * scale;
+    bool perspective = proj(3,2) != 0.0;
+
+    d->visible.clear();
+    d->wanted.clear();
+    d->stack.assign(1, 0);
+
+    visible_point_count_ = 0;
+
+    while(!d->stack.empty())
+    {
+        std::uint32_t i = d->stack.back();
+        d->stack.pop_back();
+
+        const PointCloudOctree::Node& node = octree_->getNode(i);
+        Vector3f min(node.min[0], node.min[1], node.min[2]);
+        Vector3f max(node.max[0], node.max[1], node.max[2]);
+        if(min.x() > max.x() || !isBoxVisible(world_view_proj, min, max))
+            continue;
+
+        Vector3 center = (0.5*(min+max)).cast<Real>();
+        Real radius = 0.5*(max-min).cast<Real>().norm();
+
+        Real pixels = pixels_per_unit;
+        if(perspective)
+        {
+            // at the point of the bounding sphere that is closest to the camera
+            Real distance = (world_view * center.homogeneous()).head<3>().norm() - radius*scale;
+            pixels /= std::max(distance, Real(1e-6));
+        }
+
+        Pimpl::NodeState& state = d->nodes[i];
+        if(!state.buffer)
+        {
+            state.last_wanted = d->frame;
+            if(!state.requested && node.point_count > 0)
+                d->wanted.push_back({static_cast<float>(radius*pixels), i});
+
+            // the children are refinements of this node, they are not drawn without it
+            if(node.point_count > 0)
+                continue;
+        }
+        else
+        {
+            state.last_drawn = d->frame;
+            d->visible.push_back(i);
+            visible_point_count_ += node.point_count;
+        }
+
+        if(node.spacing * pixels > screen_space_error_)
+            for(std::int32_t child : node.children)
+                if(child >= 0)
+                    d->stack.push_back(static_cast<std::uint32_t>(child));
+    }
+
+    visible_node_count_ = d->visible.size();
+}
+
+void StreamingPointCloudObject::request()
+{
+    std::sort(d->wanted.begin(), d->wanted.end(), [](const Pimpl::Candidate& a, const Pimpl::Candidate& b)
+    {
+        return a.priority > b.priority;
+    });
+
+    // the queue is replaced in every frame, so that it only contains the most important nodes for the current view
+    std::size_t count = std::min<std::size_t>(d->wanted.size(), 2*std::size_t(max_uploads_per_frame_));
+
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+
+        for(std::uint32_t node : d->requests)
+            d->nodes[node].requested = false;
+        d->requests.clear();
+
+        for(std::size_t i=0; i<count; ++i)
+        {
+            d->requests.push_back(d->wanted[i].node);
+            d->nodes[d->wanted[i].node].requested = true;
+        }
+    }
+
+    if(count > 0)
+        d->condition.notify_one();
+}
+
+void StreamingPointCloudObject::render(SceneManager* manager)
+{
+    ++d->frame;
+
+    upload(manager);
+    traverse(manager);
+    request();
+
+    if(d->visible.empty())
+        return;
+
+    PointCloudPipeline::Parameters params;
+    params.use_intensity = octree_->getAttributeType() == PointCloudOctree::AttributeType::Intensity;
+    params.colormap      = static_cast<int>(colormap_);
+    params.min_intensity = min_intensity_;
+    params.max_intensity = max_intensity_;
+    params.point_size    = point_size_;
+    params.round_points  = round_points_;
+
+    d->pipeline.begin(manager, params);
+
+    for(std::uint32_t i : d->visible)
+        d->pipeline.draw(manager->context(), d->nodes[i].buffer, octree_->getNode(i).point_count);
+}
+
+}
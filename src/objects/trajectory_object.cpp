@@ -0,0 +1,352 @@
+#include <dg/objects/trajectory_object.hpp>
+
+#include <dg/core/conversion.hpp>
+#include <dg/scene/scene_manager.hpp>
+#include <dg/material/shader_program.hpp>
+#include <dg/material/common_constants.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/SwapChain.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/PipelineState.h>
+
+namespace dg {
+
+static const char* g_trajectory_vs =
+DG_COMMON_CONSTANTS_VS_CODE
+R"===(
+cbuffer TrajectoryConstants
+{
+    float2 g_pixelToNdc;
+    float2 g_ndcToPixel;
+    float  g_halfWidth; // in pixels
+    float3 g_padding;
+};
+
+// one instance per segment, with the start and the end point from two streams of the same buffer
+struct VSInput
+{
+    float3 Pos0   : ATTRIB0;
+    float4 Color0 : ATTRIB1;
+    float3 Pos1   : ATTRIB2;
+    float4 Color1 : ATTRIB3;
+};
+
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+void main(in  VSInput VSIn,
+          in  uint    VertId : SV_VertexID,
+          out PSInput PSIn)
+{
+    float4 p0 = mul(g_worldViewProj, float4(VSIn.Pos0,1.0));
+    float4 p1 = mul(g_worldViewProj, float4(VSIn.Pos1,1.0));
+
+    // clip the segment in front of the camera, so that both ends can be projected
+    const float min_w = 1e-4;
+    if(p0.w < min_w && p1.w < min_w)
+    {
+        PSIn.Pos   = float4(0.0, 0.0, 2.0, 1.0); // outside of the clip volume
+        PSIn.Color = float4(0.0, 0.0, 0.0, 0.0);
+        return;
+    }
+    if(p0.w < min_w)
+        p0 = lerp(p0, p1, (min_w - p0.w) / (p1.w - p0.w));
+    else if(p1.w < min_w)
+        p1 = lerp(p1, p0, (min_w - p1.w) / (p0.w - p1.w));
+
+    float2 dir = p1.xy / p1.w * g_ndcToPixel - p0.xy / p0.w * g_ndcToPixel;
+    float len = length(dir);
+    dir = len > 1e-6 ? dir / len : float2(1.0, 0.0);
+    float2 normal = float2(-dir.y, dir.x);
+
+    // the 4 vertices of the triangle strip: (start,-1), (start,+1), (end,-1), (end,+1)
+    bool  end  = (VertId & 2u) != 0u;
+    float side = (VertId & 1u) != 0u ? 1.0 : -1.0;
+
+    // the quads are extended by half of the width at both ends to close the gaps at the joints
+    float2 offset = (normal * side + dir * (end ? 1.0 : -1.0)) * g_halfWidth;
+
+    float4 pos = end ? p1 : p0;
+    pos.xy += offset * g_pixelToNdc * pos.w;
+
+    PSIn.Pos   = pos;
+    PSIn.Color = end ? VSIn.Color1 : VSIn.Color0;
+}
+)===";
+
+static const char* g_trajectory_ps =
+R"===(
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+struct PSOutput
+{
+    float4 Color : SV_TARGET;
+};
+
+void main(in  PSInput  PSIn,
+          out PSOutput PSOut)
+{
+    PSOut.Color = PSIn.Color;
+}
+)===";
+
+struct TrajectoryConstants
+{
+    float pixel_to_ndc[2];
+    float ndc_to_pixel[2];
+    float half_width;
+    float padding[3];
+};
+
+static std::map<IRenderDevice*, std::weak_ptr<ShaderProgram>> g_shared_trajectory_programs;
+
+struct TrajectoryObject::Pimpl
+{
+    std::shared_ptr<ShaderProgram> shader_program;
+    RefCntAutoPtr<IPipelineState>         pso;
+    RefCntAutoPtr<IShaderResourceBinding> srb;
+
+    // capacity+1 points, the last one is a copy of the first one, so that the segment that wraps around the end
+    // of the ring can be drawn from consecutive points
+    RefCntAutoPtr<IBuffer> buffer;
+};
+
+
+TrajectoryObject::TrajectoryObject(SceneManager* manager, std::uint32_t max_points) :
+    manager_(manager), max_points_(max_points), d(new Pimpl)
+{
+}
+
+TrajectoryObject::~TrajectoryObject()
+{
+
+}
+
+void TrajectoryObject::append(const Vector3& position)
+{
+    pending_.push_back({float(position.x()), float(position.y()), float(position.z()), color_});
+}
+
+void TrajectoryObject::append(const Vector3& position, const Color& color)
+{
+    pending_.push_back({float(position.x()), float(position.y()), float(position.z()), color.toUInt32()});
+}
+
+void TrajectoryObject::append(const Vector3f* positions, const std::uint32_t* colors, std::size_t count)
+{
+    pending_.reserve(pending_.size() + count);
+    for(std::size_t i=0; i<count; ++i)
+        pending_.push_back({positions[i].x(), positions[i].y(), positions[i].z(), colors ? colors[i] : color_});
+}
+
+void TrajectoryObject::setPoints(const Vector3f* positions, const std::uint32_t* colors, std::size_t count)
+{
+    clear();
+    append(positions, colors, count);
+}
+
+void TrajectoryObject::clear()
+{
+    pending_.clear();
+    start_ = 0;
+    count_ = 0;
+}
+
+std::size_t TrajectoryObject::getPointCount() const
+{
+    std::size_t count = count_ + pending_.size();
+    return max_points_ > 0 ? std::min<std::size_t>(count, max_points_) : count;
+}
+
+void TrajectoryObject::reallocate(SceneManager* manager, std::uint32_t capacity)
+{
+    RefCntAutoPtr<IBuffer> buffer;
+
+    BufferDesc desc;
+    desc.Name          = "TrajectoryObject ring buffer";
+    desc.Usage         = USAGE_DEFAULT;
+    desc.BindFlags     = BIND_VERTEX_BUFFER;
+    desc.uiSizeInBytes = (capacity + 1) * sizeof(Point);
+    manager->device()->CreateBuffer(desc, nullptr, &buffer);
+
+    // copy the newest points to the start of the new buffer, in up to two pieces if they wrap around
+    std::uint32_t keep = std::min(count_, capacity);
+    if(keep > 0)
+    {
+        std::uint32_t begin = (start_ + count_ - keep) % capacity_;
+        std::uint32_t first = std::min(keep, capacity_ - begin);
+
+        IDeviceContext* context = manager->context();
+        context->CopyBuffer(d->buffer, begin * sizeof(Point), RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                            buffer, 0, first * sizeof(Point), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        if(keep > first)
+            context->CopyBuffer(d->buffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                buffer, first * sizeof(Point), (keep - first) * sizeof(Point), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    }
+
+    d->buffer = buffer;
+    capacity_ = capacity;
+    start_ = 0;
+    count_ = keep;
+}
+
+void TrajectoryObject::update(SceneManager* manager)
+{
+    if(max_points_ > 0)
+    {
+        if(capacity_ != max_points_)
+            reallocate(manager, max_points_);
+    }
+    else if(count_ + pending_.size() > capacity_ || !d->buffer)
+    {
+        std::size_t capacity = std::max<std::size_t>(capacity_ == 0 ? DEFAULT_CAPACITY : 2*capacity_, count_ + pending_.size());
+        reallocate(manager, static_cast<std::uint32_t>(capacity));
+    }
+
+    if(pending_.empty())
+        return;
+
+    // only the newest points remain if more points than the capacity are appended
+    const Point* points = pending_.data();
+    std::size_t count = pending_.size();
+    if(count > capacity_)
+    {
+        points += count - capacity_;
+        count = capacity_;
+    }
+
+    IDeviceContext* context = manager->context();
+
+    while(count > 0)
+    {
+        std::uint32_t pos = (start_ + count_) % capacity_;
+        std::uint32_t n = static_cast<std::uint32_t>(std::min<std::size_t>(count, capacity_ - pos));
+
+        context->UpdateBuffer(d->buffer, pos * sizeof(Point), n * sizeof(Point), points, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        if(pos == 0)
+            context->UpdateBuffer(d->buffer, capacity_ * sizeof(Point), sizeof(Point), points, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+        count_ += n;
+        if(count_ > capacity_)
+        {
+            // the oldest points were overwritten
+            start_ = (start_ + count_ - capacity_) % capacity_;
+            count_ = capacity_;
+        }
+
+        points += n;
+        count -= n;
+    }
+
+    pending_.clear();
+}
+
+void TrajectoryObject::render(SceneManager* manager)
+{
+    update(manager);
+
+    if(count_ < 2)
+        return;
+
+    IRenderDevice* device = manager->device();
+
+    if(!d->pso)
+    {
+        std::weak_ptr<ShaderProgram>& shared_shader_program = g_shared_trajectory_programs[device];
+        if(shared_shader_program.expired())
+        {
+            d->shader_program = std::make_shared<ShaderProgram>();
+            d->shader_program->setShaders(device, "TrajectoryObject_shader", g_trajectory_vs, g_trajectory_ps);
+            d->shader_program->addConstant<CommonConstantsVS>(device, "CommonConstantsVS");
+            d->shader_program->addConstant<TrajectoryConstants>(device, "TrajectoryConstants");
+            shared_shader_program = d->shader_program;
+        }
+        else
+            d->shader_program = shared_shader_program.lock();
+
+        PipelineStateCreateInfo pso_create_info;
+        PipelineStateDesc& desc = pso_create_info.PSODesc;
+
+        desc.Name = "TrajectoryObject PSO";
+        desc.IsComputePipeline = false;
+        desc.GraphicsPipeline.NumRenderTargets  = 1;
+        desc.GraphicsPipeline.RTVFormats[0]     = manager->swapChain()->GetDesc().ColorBufferFormat;
+        desc.GraphicsPipeline.DSVFormat         = manager->swapChain()->GetDesc().DepthBufferFormat;
+        desc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+        desc.GraphicsPipeline.pVS = d->shader_program->getVertexShader();
+        desc.GraphicsPipeline.pPS = d->shader_program->getPixelShader();
+
+        desc.GraphicsPipeline.PrimitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        desc.GraphicsPipeline.RasterizerDesc.CullMode = CULL_MODE_NONE;
+        desc.GraphicsPipeline.DepthStencilDesc.DepthEnable = true;
+
+        LayoutElement layout[] =
+        {
+            {0, 0, 3, VT_FLOAT32, false, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}, // start pos
+            {1, 0, 4, VT_UINT8, true, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE},    // start color
+            {2, 1, 3, VT_FLOAT32, false, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}, // end pos
+            {3, 1, 4, VT_UINT8, true, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}     // end color
+        };
+        desc.GraphicsPipeline.InputLayout.LayoutElements = layout;
+        desc.GraphicsPipeline.InputLayout.NumElements = _countof(layout);
+
+        device->CreatePipelineState(pso_create_info, &d->pso);
+        d->shader_program->bind(d->pso);
+        d->pso->CreateShaderResourceBinding(&d->srb, true);
+    }
+
+    IDeviceContext* context = manager->context();
+
+    {
+        auto constants = d->shader_program->mapConstant<CommonConstantsVS>(context, "CommonConstantsVS");
+        matrix_to_float4x4t(manager->getWorldViewProj(), constants->g_worldViewProj);
+        matrix_to_float4x4t(manager->getWorldView(), constants->g_worldView);
+        matrix_to_float4x4t(manager->getView(), constants->g_view);
+    }
+
+    {
+        const SwapChainDesc& sc_desc = manager->swapChain()->GetDesc();
+
+        auto constants = d->shader_program->mapConstant<TrajectoryConstants>(context, "TrajectoryConstants");
+        constants->pixel_to_ndc[0] = 2.0f / float(sc_desc.Width);
+        constants->pixel_to_ndc[1] = 2.0f / float(sc_desc.Height);
+        constants->ndc_to_pixel[0] = 0.5f * float(sc_desc.Width);
+        constants->ndc_to_pixel[1] = 0.5f * float(sc_desc.Height);
+        constants->half_width      = 0.5f * line_width_;
+    }
+
+    context->SetPipelineState(d->pso);
+    context->CommitShaderResources(d->srb, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    // segment i connects the points i and i+1 of the ring, the last point of the ring is connected to the copy
+    // of the first one
+    std::uint32_t segments = count_ - 1;
+    std::uint32_t first = std::min(segments, capacity_ - start_);
+    draw(manager, start_, first);
+    if(segments > first)
+        draw(manager, 0, segments - first);
+}
+
+void TrajectoryObject::draw(SceneManager* manager, std::uint32_t first_segment, std::uint32_t segment_count)
+{
+    Uint32   offsets[] = {Uint32(first_segment * sizeof(Point)), Uint32((first_segment + 1) * sizeof(Point))};
+    IBuffer* buffs[] = {d->buffer, d->buffer};
+    manager->context()->SetVertexBuffers(0, 2, buffs, offsets, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+
+    DrawAttribs attr;
+    attr.NumVertices  = 4;
+    attr.NumInstances = segment_count;
+    attr.Flags = DRAW_FLAG_VERIFY_ALL;
+    manager->context()->Draw(attr);
+}
+
+}
@@ -0,0 +1,460 @@
+#include <dg/objects/voxel_grid_object.hpp>
+
+#include <dg/core/conversion.hpp>
+#include <dg/core/frustum.hpp>
+#include <dg/scene/scene_manager.hpp>
+#include <dg/material/shader_program.hpp>
+#include <dg/material/common_constants.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/SwapChain.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/PipelineState.h>
+
+#include <bitset>
+
+namespace dg {
+
+static const char* g_voxel_grid_vs =
+DG_COMMON_CONSTANTS_VS_CODE
+R"===(
+cbuffer VoxelGridConstants
+{
+    float3 g_origin;
+    float  g_voxelSize;
+    float3 g_lightDirection; // in view space
+    float  g_ambient;
+};
+
+// one instance per visible face
+struct VSInput
+{
+    int4   Voxel : ATTRIB0; // voxel coordinates, face (+x,-x,+y,-y,+z,-z), 16 bit integers
+    float4 Color : ATTRIB1;
+};
+
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+void main(in  VSInput VSIn,
+          in  uint    VertId : SV_VertexID,
+          out PSInput PSIn)
+{
+    int face = VSIn.Voxel.w;
+    int axis = face / 2;
+    float sign = (face & 1) != 0 ? -1.0 : 1.0;
+
+    float3 normal, u, v;
+    if(axis == 0)
+    {
+        normal = float3(sign, 0.0, 0.0); u = float3(0.0, 1.0, 0.0); v = float3(0.0, 0.0, 1.0);
+    }
+    else if(axis == 1)
+    {
+        normal = float3(0.0, sign, 0.0); u = float3(0.0, 0.0, 1.0); v = float3(1.0, 0.0, 0.0);
+    }
+    else
+    {
+        normal = float3(0.0, 0.0, sign); u = float3(1.0, 0.0, 0.0); v = float3(0.0, 1.0, 0.0);
+    }
+
+    // the 4 vertices of the triangle strip are the corners of the face
+    float2 corner = float2((VertId & 1u) != 0u ? 0.5 : -0.5, (VertId & 2u) != 0u ? 0.5 : -0.5);
+    float3 pos = float3(VSIn.Voxel.xyz) + 0.5 + 0.5 * normal + corner.x * u + corner.y * v;
+
+    PSIn.Pos = mul(g_worldViewProj, float4(g_origin + pos * g_voxelSize, 1.0));
+
+    float3 view_normal = normalize(mul(g_worldView, float4(normal, 0.0)).xyz);
+    float diffuse = saturate(dot(view_normal, -g_lightDirection));
+    PSIn.Color = float4(VSIn.Color.rgb * (g_ambient + (1.0 - g_ambient) * diffuse), VSIn.Color.a);
+}
+)===";
+
+static const char* g_voxel_grid_ps =
+R"===(
+struct PSInput
+{
+    float4 Pos   : SV_POSITION;
+    float4 Color : COLOR0;
+};
+
+struct PSOutput
+{
+    float4 Color : SV_TARGET;
+};
+
+void main(in  PSInput  PSIn,
+          out PSOutput PSOut)
+{
+    PSOut.Color = PSIn.Color;
+}
+)===";
+
+struct VoxelGridConstants
+{
+    float origin[3];
+    float voxel_size;
+    float light_direction[3];
+    float ambient;
+};
+
+static std::map<IRenderDevice*, std::weak_ptr<ShaderProgram>> g_shared_voxel_grid_programs;
+
+static constexpr int BRICK_VOXELS = VoxelGridObject::BRICK_SIZE * VoxelGridObject::BRICK_SIZE * VoxelGridObject::BRICK_SIZE;
+
+struct VoxelGridObject::Brick
+{
+    int bx, by, bz;
+
+    std::bitset<BRICK_VOXELS> occupied;
+    std::uint32_t colors[BRICK_VOXELS];
+    std::uint32_t count = 0;
+    bool dirty = false;
+
+    RefCntAutoPtr<IBuffer> buffer;
+    std::uint32_t capacity = 0;   // in faces
+    std::uint32_t face_count = 0;
+
+    static int index(int x, int y, int z) { return (z*BRICK_SIZE + y)*BRICK_SIZE + x; }
+};
+
+struct VoxelGridObject::Pimpl
+{
+    std::shared_ptr<ShaderProgram> shader_program;
+    RefCntAutoPtr<IPipelineState>         pso;
+    RefCntAutoPtr<IShaderResourceBinding> srb;
+
+    struct Face
+    {
+        std::int16_t x, y, z, face;
+        std::uint32_t color;
+    };
+
+    std::vector<Face> faces; // staging
+};
+
+
+// floor division and modulo for negative coordinates
+static inline int brickCoord(int v) { return v >= 0 ? v / VoxelGridObject::BRICK_SIZE : (v + 1) / VoxelGridObject::BRICK_SIZE - 1; }
+static inline int localCoord(int v) { return v - brickCoord(v) * VoxelGridObject::BRICK_SIZE; }
+
+
+VoxelGridObject::VoxelGridObject(SceneManager* manager, float voxel_size) :
+    manager_(manager), voxel_size_(voxel_size), d(new Pimpl)
+{
+}
+
+VoxelGridObject::~VoxelGridObject()
+{
+
+}
+
+std::uint64_t VoxelGridObject::brickKey(int bx, int by, int bz)
+{
+    return (std::uint64_t(std::uint32_t(bx) & 0x1FFFFF) << 42) |
+           (std::uint64_t(std::uint32_t(by) & 0x1FFFFF) << 21) |
+            std::uint64_t(std::uint32_t(bz) & 0x1FFFFF);
+}
+
+VoxelGridObject::Brick* VoxelGridObject::findBrick(int bx, int by, int bz)
+{
+    auto it = bricks_.find(brickKey(bx, by, bz));
+    return it != bricks_.end() ? it->second.get() : nullptr;
+}
+
+const VoxelGridObject::Brick* VoxelGridObject::findBrick(int bx, int by, int bz) const
+{
+    auto it = bricks_.find(brickKey(bx, by, bz));
+    return it != bricks_.end() ? it->second.get() : nullptr;
+}
+
+void VoxelGridObject::markDirty(int bx, int by, int bz, int lx, int ly, int lz)
+{
+    auto mark = [this](Brick* brick)
+    {
+        if(brick && !brick->dirty)
+        {
+            brick->dirty = true;
+            dirty_bricks_.push_back(brick);
+        }
+    };
+
+    mark(findBrick(bx, by, bz));
+
+    // the faces of the neighbors at the common border depend on this voxel
+    if(lx == 0)            mark(findBrick(bx-1, by, bz));
+    if(lx == BRICK_SIZE-1) mark(findBrick(bx+1, by, bz));
+    if(ly == 0)            mark(findBrick(bx, by-1, bz));
+    if(ly == BRICK_SIZE-1) mark(findBrick(bx, by+1, bz));
+    if(lz == 0)            mark(findBrick(bx, by, bz-1));
+    if(lz == BRICK_SIZE-1) mark(findBrick(bx, by, bz+1));
+}
+
+void VoxelGridObject::setVoxel(int x, int y, int z, std::uint32_t color)
+{
+    int bx = brickCoord(x), by = brickCoord(y), bz = brickCoord(z);
+    int lx = localCoord(x), ly = localCoord(y), lz = localCoord(z);
+
+    std::unique_ptr<Brick>& slot = bricks_[brickKey(bx, by, bz)];
+    if(!slot)
+    {
+        slot.reset(new Brick);
+        slot->bx = bx;
+        slot->by = by;
+        slot->bz = bz;
+    }
+
+    Brick& brick = *slot;
+    int i = Brick::index(lx, ly, lz);
+    if(brick.occupied[i])
+    {
+        if(brick.colors[i] == color)
+            return;
+    }
+    else
+    {
+        brick.occupied[i] = true;
+        ++brick.count;
+        ++voxel_count_;
+    }
+    brick.colors[i] = color;
+
+    markDirty(bx, by, bz, lx, ly, lz);
+}
+
+void VoxelGridObject::setVoxels(const Eigen::Vector3i* voxels, const std::uint32_t* colors, std::size_t count)
+{
+    for(std::size_t i=0; i<count; ++i)
+        setVoxel(voxels[i].x(), voxels[i].y(), voxels[i].z(), colors ? colors[i] : color_);
+}
+
+void VoxelGridObject::clearVoxel(int x, int y, int z)
+{
+    int bx = brickCoord(x), by = brickCoord(y), bz = brickCoord(z);
+    int lx = localCoord(x), ly = localCoord(y), lz = localCoord(z);
+
+    Brick* brick = findBrick(bx, by, bz);
+    int i = Brick::index(lx, ly, lz);
+    if(!brick || !brick->occupied[i])
+        return;
+
+    brick->occupied[i] = false;
+    --brick->count;
+    --voxel_count_;
+
+    // empty bricks are removed in the next render()
+    markDirty(bx, by, bz, lx, ly, lz);
+}
+
+void VoxelGridObject::clearVoxels(const Eigen::Vector3i* voxels, std::size_t count)
+{
+    for(std::size_t i=0; i<count; ++i)
+        clearVoxel(voxels[i].x(), voxels[i].y(), voxels[i].z());
+}
+
+bool VoxelGridObject::isOccupied(int x, int y, int z) const
+{
+    const Brick* brick = findBrick(brickCoord(x), brickCoord(y), brickCoord(z));
+    return brick && brick->occupied[Brick::index(localCoord(x), localCoord(y), localCoord(z))];
+}
+
+void VoxelGridObject::clear()
+{
+    bricks_.clear();
+    dirty_bricks_.clear();
+    voxel_count_ = 0;
+    face_count_ = 0;
+}
+
+void VoxelGridObject::updateBrick(SceneManager* manager, Brick& brick)
+{
+    const int n = BRICK_SIZE;
+
+    // neighbors in the order of the faces: +x, -x, +y, -y, +z, -z
+    const Brick* neighbors[6] =
+    {
+        findBrick(brick.bx+1, brick.by, brick.bz), findBrick(brick.bx-1, brick.by, brick.bz),
+        findBrick(brick.bx, brick.by+1, brick.bz), findBrick(brick.bx, brick.by-1, brick.bz),
+        findBrick(brick.bx, brick.by, brick.bz+1), findBrick(brick.bx, brick.by, brick.bz-1)
+    };
+    const int offsets[6][3] = {{1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}};
+
+    std::vector<Pimpl::Face>& faces = d->faces;
+    faces.clear();
+
+    for(int z=0; z<n; ++z)
+    for(int y=0; y<n; ++y)
+    for(int x=0; x<n; ++x)
+    {
+        int i = Brick::index(x, y, z);
+        if(!brick.occupied[i])
+            continue;
+
+        for(int f=0; f<6; ++f)
+        {
+            int nx = x + offsets[f][0], ny = y + offsets[f][1], nz = z + offsets[f][2];
+
+            bool hidden;
+            if(nx >= 0 && nx < n && ny >= 0 && ny < n && nz >= 0 && nz < n)
+                hidden = brick.occupied[Brick::index(nx, ny, nz)];
+            else
+                hidden = neighbors[f] && neighbors[f]->occupied[Brick::index((nx+n)%n, (ny+n)%n, (nz+n)%n)];
+
+            if(hidden)
+                continue;
+
+            Pimpl::Face face;
+            face.x = static_cast<std::int16_t>(brick.bx*n + x);
+            face.y = static_cast<std::int16_t>(brick.by*n + y);
+            face.z = static_cast<std::int16_t>(brick.bz*n + z);
+            face.face = static_cast<std::int16_t>(f);
+            face.color = brick.colors[i];
+            faces.push_back(face);
+        }
+    }
+
+    face_count_ -= brick.face_count;
+    brick.face_count = static_cast<std::uint32_t>(faces.size());
+    face_count_ += brick.face_count;
+
+    if(faces.empty())
+        return;
+
+    // the buffers are allocated with some headroom, so that small changes can be uploaded in place
+    if(brick.face_count > brick.capacity)
+    {
+        brick.capacity = brick.face_count + brick.face_count/2;
+
+        BufferDesc desc;
+        desc.Name          = "VoxelGridObject brick buffer";
+        desc.Usage         = USAGE_DEFAULT;
+        desc.BindFlags     = BIND_VERTEX_BUFFER;
+        desc.uiSizeInBytes = brick.capacity * sizeof(Pimpl::Face);
+        brick.buffer.Release();
+        manager->device()->CreateBuffer(desc, nullptr, &brick.buffer);
+    }
+
+    manager->context()->UpdateBuffer(brick.buffer, 0, brick.face_count * sizeof(Pimpl::Face), faces.data(),
+                                     RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+}
+
+void VoxelGridObject::render(SceneManager* manager)
+{
+    for(Brick* brick : dirty_bricks_)
+    {
+        brick->dirty = false;
+
+        if(brick->count == 0)
+        {
+            face_count_ -= brick->face_count;
+            bricks_.erase(brickKey(brick->bx, brick->by, brick->bz));
+        }
+        else
+            updateBrick(manager, *brick);
+    }
+    dirty_bricks_.clear();
+
+    if(face_count_ == 0)
+        return;
+
+    IRenderDevice* device = manager->device();
+    IDeviceContext* context = manager->context();
+
+    if(!d->pso)
+    {
+        std::weak_ptr<ShaderProgram>& shared_shader_program = g_shared_voxel_grid_programs[device];
+        if(shared_shader_program.expired())
+        {
+            d->shader_program = std::make_shared<ShaderProgram>();
+            d->shader_program->setShaders(device, "VoxelGridObject_shader", g_voxel_grid_vs, g_voxel_grid_ps);
+            d->shader_program->addConstant<CommonConstantsVS>(device, "CommonConstantsVS");
+            d->shader_program->addConstant<VoxelGridConstants>(device, "VoxelGridConstants");
+            shared_shader_program = d->shader_program;
+        }
+        else
+            d->shader_program = shared_shader_program.lock();
+
+        PipelineStateCreateInfo pso_create_info;
+        PipelineStateDesc& desc = pso_create_info.PSODesc;
+
+        desc.Name = "VoxelGridObject PSO";
+        desc.IsComputePipeline = false;
+        desc.GraphicsPipeline.NumRenderTargets  = 1;
+        desc.GraphicsPipeline.RTVFormats[0]     = manager->swapChain()->GetDesc().ColorBufferFormat;
+        desc.GraphicsPipeline.DSVFormat         = manager->swapChain()->GetDesc().DepthBufferFormat;
+        desc.ResourceLayout.DefaultVariableType = SHADER_RESOURCE_VARIABLE_TYPE_STATIC;
+
+        desc.GraphicsPipeline.pVS = d->shader_program->getVertexShader();
+        desc.GraphicsPipeline.pPS = d->shader_program->getPixelShader();
+
+        desc.GraphicsPipeline.PrimitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        desc.GraphicsPipeline.RasterizerDesc.CullMode = CULL_MODE_NONE;
+        desc.GraphicsPipeline.DepthStencilDesc.DepthEnable = true;
+
+        LayoutElement layout[] =
+        {
+            {0, 0, 4, VT_INT16, false, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}, // voxel, face
+            {1, 0, 4, VT_UINT8, true, INPUT_ELEMENT_FREQUENCY_PER_INSTANCE}   // color
+        };
+        desc.GraphicsPipeline.InputLayout.LayoutElements = layout;
+        desc.GraphicsPipeline.InputLayout.NumElements = _countof(layout);
+
+        device->CreatePipelineState(pso_create_info, &d->pso);
+        d->shader_program->bind(d->pso);
+        d->pso->CreateShaderResourceBinding(&d->srb, true);
+    }
+
+    {
+        auto constants = d->shader_program->mapConstant<CommonConstantsVS>(context, "CommonConstantsVS");
+        matrix_to_float4x4t(manager->getWorldViewProj(), constants->g_worldViewProj);
+        matrix_to_float4x4t(manager->getWorldView(), constants->g_worldView);
+        matrix_to_float4x4t(manager->getView(), constants->g_view);
+    }
+
+    {
+        Vector3 light = (manager->getView().block<3,3>(0,0) * manager->getGlobalLight().direction).normalized();
+
+        auto constants = d->shader_program->mapConstant<VoxelGridConstants>(context, "VoxelGridConstants");
+        constants->origin[0] = origin_.x();
+        constants->origin[1] = origin_.y();
+        constants->origin[2] = origin_.z();
+        constants->voxel_size = voxel_size_;
+        constants->light_direction[0] = float(light.x());
+        constants->light_direction[1] = float(light.y());
+        constants->light_direction[2] = float(light.z());
+        constants->ambient = 0.3f;
+    }
+
+    context->SetPipelineState(d->pso);
+    context->CommitShaderResources(d->srb, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+    const Matrix4& world_view_proj = manager->getWorldViewProj();
+    float brick_size = BRICK_SIZE * voxel_size_;
+
+    for(const auto& entry : bricks_)
+    {
+        const Brick& brick = *entry.second;
+        if(brick.face_count == 0)
+            continue;
+
+        Vector3f min = origin_ + Vector3f(float(brick.bx), float(brick.by), float(brick.bz)) * brick_size;
+        Vector3f max = min + Vector3f::Constant(brick_size);
+        if(!isBoxVisible(world_view_proj, min, max))
+            continue;
+
+        Uint32   offset  = 0;
+        IBuffer* buffs[] = {brick.buffer};
+        context->SetVertexBuffers(0, 1, buffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
+
+        DrawAttribs attr;
+        attr.NumVertices  = 4;
+        attr.NumInstances = brick.face_count;
+        attr.Flags = DRAW_FLAG_VERIFY_ALL;
+        context->Draw(attr);
+    }
+}
+
+}
@@ -0,0 +1,210 @@
+#include <dg/scene/asset_pack.hpp>
+#include <dg/scene/scene_manager.hpp>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+namespace dg {
+
+static const char g_asset_pack_magic[4] = {'D','G','P','K'};
+
+static_assert(sizeof(AssetPack::Header) == 32, "unexpected asset pack header size");
+static_assert(sizeof(AssetPack::Entry) == 32, "unexpected asset pack entry size");
+
+// suffix of the temporary files, unique per write
+static std::atomic<unsigned int> g_tmp_counter(0);
+
+static std::uint64_t alignEntry(std::uint64_t offset)
+{
+    return (offset + AssetPack::ALIGNMENT - 1) / AssetPack::ALIGNMENT * AssetPack::ALIGNMENT;
+}
+
+
+AssetPack::Ptr AssetPack::open(const std::string& filename)
+{
+    return make(filename);
+}
+
+AssetPack::AssetPack(const std::string& filename) :
+    file_(std::make_shared<MappedFile>(filename))
+{
+    const std::uint8_t* data = file_->data();
+    std::size_t size = file_->size();
+
+    header_ = reinterpret_cast<const Header*>(data);
+    entries_ = reinterpret_cast<const Entry*>(data + sizeof(Header));
+
+    bool valid = size >= sizeof(Header) &&
+                 std::memcmp(header_->magic, g_asset_pack_magic, sizeof(g_asset_pack_magic)) == 0 &&
+                 header_->version == VERSION &&
+                 sizeof(Header) + std::uint64_t(header_->entry_count)*sizeof(Entry) <= size &&
+                 header_->names_offset <= size && header_->names_size <= size - header_->names_offset;
+
+    for(std::uint32_t i=0; valid && i<header_->entry_count; ++i)
+    {
+        const Entry& entry = entries_[i];
+        valid = std::uint64_t(entry.name_offset) + entry.name_size <= header_->names_size &&
+                entry.offset <= size && entry.size <= size - entry.offset;
+    }
+
+    if(!valid)
+        DG_THROW("Invalid asset pack " + filename);
+
+    names_ = reinterpret_cast<const char*>(data + header_->names_offset);
+}
+
+std::string AssetPack::getEntryName(std::size_t i) const
+{
+    return std::string(names_ + entries_[i].name_offset, entries_[i].name_size);
+}
+
+int AssetPack::find(EntryType type, const std::string& name) const
+{
+    for(std::uint32_t i=0; i<header_->entry_count; ++i)
+    {
+        const Entry& entry = entries_[i];
+        if(entry.type == std::uint32_t(type) && entry.name_size == name.size() &&
+           std::memcmp(names_ + entry.name_offset, name.data(), name.size()) == 0)
+            return int(i);
+    }
+    return -1;
+}
+
+MeshFile::Ptr AssetPack::getMeshFile(const std::string& name) const
+{
+    int i = find(ENTRY_MESH, name);
+    if(i < 0)
+        DG_THROW("No mesh " + name + " in asset pack " + getFilename());
+    return MeshFile::make(file_, entries_[i].offset, entries_[i].size);
+}
+
+KTXFile::Ptr AssetPack::getTexture(const std::string& name, EntryType type) const
+{
+    int i = find(type, name);
+    if(i < 0)
+        DG_THROW("No texture " + name + " in asset pack " + getFilename());
+    return KTXFile::make(file_, entries_[i].offset, entries_[i].size);
+}
+
+std::vector<MeshBuffers::Ptr> AssetPack::createMeshes(IRenderDevice* device, const std::string& name) const
+{
+    MeshFile::Ptr file = getMeshFile(name);
+
+    std::vector<MeshBuffers::Ptr> meshes;
+    for(std::size_t i=0; i<file->getMeshCount(); ++i)
+    {
+        MeshFile::MeshView view = file->getMesh(i);
+        MeshBuffers::Ptr mesh = MeshBuffers::create(device, name, view.input_layout, view.primitive_topology,
+                                                    view.vertices, view.vertex_stride, view.vertex_count,
+                                                    view.indices, view.index_count);
+        for(const MeshFile::MeshView::LodView& lod : view.lods)
+            mesh->addLod(device, name, lod.indices, lod.index_count, lod.error);
+        meshes.push_back(mesh);
+    }
+
+    return meshes;
+}
+
+void AssetPack::applyEnvironment(SceneManager* manager, const std::string& name) const
+{
+    RefCntAutoPtr<ITexture> map = getTexture(name, ENTRY_ENVIRONMENT_MAP)->createTexture(manager->device(), name);
+
+    RefCntAutoPtr<ITexture> irradiance_map;
+    RefCntAutoPtr<ITexture> prefiltered_map;
+    if(find(ENTRY_IRRADIANCE_MAP, name) >= 0 && find(ENTRY_PREFILTERED_MAP, name) >= 0)
+    {
+        irradiance_map = getTexture(name, ENTRY_IRRADIANCE_MAP)->createTexture(manager->device(), name + " irradiance");
+        prefiltered_map = getTexture(name, ENTRY_PREFILTERED_MAP)->createTexture(manager->device(), name + " prefiltered");
+    }
+
+    manager->setEnvironmentMap(map, irradiance_map, prefiltered_map);
+}
+
+
+void AssetPack::Writer::addMeshes(const std::string& name, std::vector<MeshData> meshes)
+{
+    // shared, as the function must be copyable
+    auto data = std::make_shared<std::vector<MeshData>>(std::move(meshes));
+    items_.push_back(Item{ENTRY_MESH, name, [data](std::FILE* f) { return MeshFile::write(f, 0, *data); }});
+}
+
+void AssetPack::Writer::addTexture(EntryType type, const std::string& name, const TextureDesc& desc,
+                                   std::vector<std::vector<std::uint8_t>> levels)
+{
+    auto data = std::make_shared<std::vector<std::vector<std::uint8_t>>>(std::move(levels));
+    items_.push_back(Item{type, name, [desc, data](std::FILE* f) { return KTXFile::write(f, desc, *data); }});
+}
+
+void AssetPack::Writer::addFile(EntryType type, const std::string& name, const std::string& filename)
+{
+    items_.push_back(Item{type, name, [filename](std::FILE* f)
+    {
+        MappedFile file(filename);
+        return std::fwrite(file.data(), 1, file.size(), f) == file.size();
+    }});
+}
+
+void AssetPack::Writer::write(const std::string& filename) const
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, g_asset_pack_magic, sizeof(g_asset_pack_magic));
+    header.version = VERSION;
+    header.entry_count = static_cast<std::uint32_t>(items_.size());
+    header.names_offset = sizeof(Header) + items_.size()*sizeof(Entry);
+
+    std::vector<Entry> entries(items_.size());
+    std::string names;
+    for(std::size_t i=0; i<items_.size(); ++i)
+    {
+        std::memset(&entries[i], 0, sizeof(Entry));
+        entries[i].type = items_[i].type;
+        entries[i].name_offset = static_cast<std::uint32_t>(names.size());
+        entries[i].name_size = static_cast<std::uint32_t>(items_[i].name.size());
+        names += items_[i].name;
+    }
+    header.names_size = names.size();
+
+    std::string tmp_filename = filename + ".tmp" + std::to_string(::getpid()) + "." + std::to_string(g_tmp_counter++);
+    std::FILE* f = std::fopen(tmp_filename.c_str(), "wb");
+    if(!f)
+        DG_THROW("Cannot create asset pack " + filename);
+
+    // the entries first, their offsets and sizes are known afterwards
+    bool ok = true;
+    std::uint64_t offset = header.names_offset + header.names_size;
+    for(std::size_t i=0; ok && i<items_.size(); ++i)
+    {
+        entries[i].offset = alignEntry(offset);
+        try
+        {
+            ok = std::fseek(f, long(entries[i].offset), SEEK_SET) == 0 && items_[i].write(f);
+        }
+        catch(const std::exception&)
+        {
+            ok = false; // e.g. a missing source file
+        }
+
+        long end = std::ftell(f);
+        ok = ok && end >= 0;
+        entries[i].size = std::uint64_t(end) - entries[i].offset;
+        offset = std::uint64_t(end);
+    }
+
+    ok = ok && std::fseek(f, 0, SEEK_SET) == 0 &&
+         std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+         std::fwrite(entries.data(), sizeof(Entry), entries.size(), f) == entries.size() &&
+         std::fwrite(names.data(), 1, names.size(), f) == names.size();
+
+    ok = std::fclose(f) == 0 && ok;
+    if(!ok || std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmp_filename.c_str());
+        DG_THROW("Cannot write asset pack " + filename);
+    }
+}
+
+}
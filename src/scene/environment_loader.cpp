@@ -0,0 +1,338 @@
+#include <dg/scene/environment_loader.hpp>
+#include <dg/scene/asset_pack.hpp>
+#include <dg/scene/scene_manager.hpp>
+
+#include <dg/core/cache_directory.hpp>
+#include <dg/core/hash.hpp>
+#include <dg/core/mapped_file.hpp>
+#include <dg/material/ktx_file.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/Fence.h>
+#include <DiligentCore/Graphics/GraphicsAccessories/interface/GraphicsAccessories.hpp>
+#include <DiligentTools/TextureLoader/interface/TextureLoader.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <mutex>
+
+namespace dg {
+
+namespace {
+
+using Levels = std::vector<std::vector<std::uint8_t>>;
+
+std::uint32_t sliceCount(const TextureDesc& desc)
+{
+    return desc.Type == RESOURCE_DIM_TEX_3D ? 1 : desc.ArraySize;
+}
+
+// appends the subresource without row padding, in the layout of KTXFile::write()
+void appendSubresource(std::vector<std::uint8_t>& level, const TextureDesc& desc, std::uint32_t mip,
+                       const void* data, std::size_t stride, std::size_t depth_stride)
+{
+    MipLevelProperties properties = GetMipLevelProperties(desc, mip);
+    std::size_t row_size = properties.RowSize;
+    std::size_t rows = row_size > 0 ? properties.DepthSliceSize / row_size : 0; // of blocks
+
+    const std::uint8_t* src = static_cast<const std::uint8_t*>(data);
+    for(std::uint32_t z=0; z<properties.Depth; ++z)
+        for(std::size_t row=0; row<rows; ++row)
+        {
+            const std::uint8_t* p = src + z*depth_stride + row*stride;
+            level.insert(level.end(), p, p + row_size);
+        }
+}
+
+}
+
+struct EnvironmentLoader::CacheEntry
+{
+    std::string filename; // of the asset pack
+    std::string key;      // hash of the source file, the name of the entries
+
+    // the decoded environment map, not stored for KTX files
+    bool     has_map = false;
+    TextureDesc map_desc;
+    Levels   map_levels;
+};
+
+/// State of an asynchronous load, that is shared by the loader, the worker thread and the render task
+struct EnvironmentLoader::PendingLoad
+{
+    std::uint64_t id = 0;
+    std::string filename;
+    LoadCallback callback;
+
+    // written by the worker thread
+    std::mutex mutex;
+    bool loaded = false;
+    std::string error;
+
+    KTXFile::Ptr map_file; // the source, if it is a KTX file, or the cached map
+    RefCntAutoPtr<ITextureLoader> map_loader;
+    KTXFile::Ptr irradiance_file;
+    KTXFile::Ptr prefiltered_file;
+    std::shared_ptr<CacheEntry> cache_entry; // if the cubemaps are not cached
+};
+
+
+EnvironmentLoader::EnvironmentLoader(SceneManager* manager) :
+    manager_(manager)
+{
+}
+
+std::string EnvironmentLoader::defaultCacheDirectory()
+{
+    return userCacheDirectory("environments");
+}
+
+void EnvironmentLoader::loadAsync(const std::string& filename, LoadCallback callback)
+{
+    std::shared_ptr<PendingLoad> load = std::make_shared<PendingLoad>();
+    load->id = ++load_count_;
+    load->filename = filename;
+    load->callback = std::move(callback);
+
+    std::string cache_directory = cache_directory_.empty() ? defaultCacheDirectory() : cache_directory_;
+    manager_->getWorkerPool().enqueue([load, cache_directory]()
+    {
+        std::string error;
+        try
+        {
+            MappedFile::Ptr source = std::make_shared<MappedFile>(load->filename);
+
+            // the hash of the contents, as environment maps are often replaced by files with the same name
+            char key[32];
+            std::snprintf(key, sizeof(key), "%016llx",
+                          static_cast<unsigned long long>(hash_bytes(source->data(), source->size())));
+
+            // empty if there is no cache directory
+            std::string cache_filename = cache_directory.empty() ? std::string() : cache_directory + "/" + key + ".dgibl";
+            bool is_ktx = KTXFile::isKTXFile(load->filename);
+
+            AssetPack::Ptr pack;
+            try
+            {
+                if(!cache_filename.empty() && ::access(cache_filename.c_str(), R_OK) == 0)
+                    pack = AssetPack::open(cache_filename);
+            }
+            catch(const std::exception&)
+            {
+                // an invalid or outdated cache file is replaced
+            }
+
+            if(pack && pack->find(AssetPack::ENTRY_IRRADIANCE_MAP, key) >= 0 &&
+               pack->find(AssetPack::ENTRY_PREFILTERED_MAP, key) >= 0 &&
+               (is_ktx || pack->find(AssetPack::ENTRY_ENVIRONMENT_MAP, key) >= 0))
+            {
+                load->irradiance_file = pack->getTexture(key, AssetPack::ENTRY_IRRADIANCE_MAP);
+                load->prefiltered_file = pack->getTexture(key, AssetPack::ENTRY_PREFILTERED_MAP);
+                load->map_file = is_ktx ? KTXFile::make(source, 0, source->size()) :
+                                          pack->getTexture(key, AssetPack::ENTRY_ENVIRONMENT_MAP);
+                load->irradiance_file->prefetch();
+                load->prefiltered_file->prefetch();
+                load->map_file->prefetch();
+            }
+            else
+            {
+                std::shared_ptr<CacheEntry> entry = std::make_shared<CacheEntry>();
+                entry->filename = cache_filename;
+                entry->key = key;
+
+                if(is_ktx)
+                {
+                    load->map_file = KTXFile::make(source, 0, source->size());
+                    load->map_file->prefetch();
+                }
+                else
+                {
+                    CreateTextureLoaderFromFile(load->filename.c_str(), IMAGE_FILE_FORMAT_UNKNOWN,
+                                                TextureLoadInfo{"SceneManager Environment Map"}, &load->map_loader);
+                    if(!load->map_loader)
+                        DG_THROW("Cannot load environment map " + load->filename);
+
+                    entry->has_map = true;
+                    entry->map_desc = load->map_loader->GetTextureDesc();
+                    entry->map_desc.Name = nullptr;
+                    entry->map_levels.resize(entry->map_desc.MipLevels);
+                    for(std::uint32_t mip=0; mip<entry->map_desc.MipLevels; ++mip)
+                        for(std::uint32_t slice=0; slice<sliceCount(entry->map_desc); ++slice)
+                        {
+                            const TextureSubResData& data = load->map_loader->GetSubresourceData(mip, slice);
+                            appendSubresource(entry->map_levels[mip], entry->map_desc, mip, data.pData,
+                                              std::size_t(data.Stride), std::size_t(data.DepthStride));
+                        }
+                }
+
+                if(!cache_filename.empty())
+                    load->cache_entry = entry;
+            }
+        }
+        catch(const std::exception& e)
+        {
+            error = e.what();
+        }
+
+        std::lock_guard<std::mutex> lock(load->mutex);
+        load->error = error;
+        load->loaded = true;
+    });
+
+    // the scene manager owns this loader and its tasks, hence the task cannot outlive the loader
+    manager_->addRenderTask([this, load](SceneManager*)
+    {
+        {
+            std::lock_guard<std::mutex> lock(load->mutex);
+            if(!load->loaded)
+                return false;
+        }
+        finishLoad(load);
+        return true;
+    });
+}
+
+void EnvironmentLoader::finishLoad(const std::shared_ptr<PendingLoad>& load)
+{
+    std::string error = load->error;
+    if(error.empty() && load->id != load_count_)
+        error = "Superseded by a later environment map";
+
+    if(error.empty())
+    {
+        try
+        {
+            IRenderDevice* device = manager_->device();
+
+            RefCntAutoPtr<ITexture> map;
+            if(load->map_file)
+                map = load->map_file->createTexture(device, "SceneManager Environment Map");
+            else
+                load->map_loader->CreateTexture(device, &map);
+            if(!map)
+                DG_THROW("Cannot create environment map " + load->filename);
+
+            RefCntAutoPtr<ITexture> irradiance_map;
+            RefCntAutoPtr<ITexture> prefiltered_map;
+            if(load->irradiance_file && load->prefiltered_file)
+            {
+                irradiance_map = load->irradiance_file->createTexture(device, "SceneManager Irradiance Map");
+                prefiltered_map = load->prefiltered_file->createTexture(device, "SceneManager Prefiltered Map");
+            }
+
+            manager_->setEnvironmentMap(map, irradiance_map, prefiltered_map);
+            uncached_map_ = load->cache_entry ? map : RefCntAutoPtr<ITexture>();
+            uncached_entry_ = load->cache_entry;
+        }
+        catch(const std::exception& e)
+        {
+            error = e.what();
+        }
+    }
+
+    if(load->callback)
+        load->callback(error);
+}
+
+void EnvironmentLoader::store(ITexture* irradiance_map, ITexture* prefiltered_map)
+{
+    if(!uncached_entry_ || manager_->getEnvironmentMap() != uncached_map_)
+        return;
+
+    std::shared_ptr<CacheEntry> entry = uncached_entry_;
+    uncached_entry_.reset();
+    uncached_map_.Release();
+
+    IRenderDevice* device = manager_->device();
+    IDeviceContext* context = manager_->context();
+
+    // copies that the CPU can read, once the GPU has finished them
+    ITexture* sources[2] = {irradiance_map, prefiltered_map};
+    RefCntAutoPtr<ITexture> staging[2];
+    for(int i=0; i<2; ++i)
+    {
+        TextureDesc desc = sources[i]->GetDesc();
+        desc.Name = "EnvironmentLoader readback";
+        desc.Usage = USAGE_STAGING;
+        desc.BindFlags = BIND_NONE;
+        desc.CPUAccessFlags = CPU_ACCESS_READ;
+        desc.MiscFlags = MISC_TEXTURE_FLAG_NONE;
+        device->CreateTexture(desc, nullptr, &staging[i]);
+        if(!staging[i])
+            return;
+
+        for(std::uint32_t slice=0; slice<sliceCount(desc); ++slice)
+            for(std::uint32_t mip=0; mip<desc.MipLevels; ++mip)
+            {
+                CopyTextureAttribs copy(sources[i], RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                        staging[i], RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+                copy.SrcMipLevel = mip;
+                copy.SrcSlice = slice;
+                copy.DstMipLevel = mip;
+                copy.DstSlice = slice;
+                context->CopyTexture(copy);
+            }
+    }
+
+    RefCntAutoPtr<IFence> fence;
+    device->CreateFence(FenceDesc{}, &fence);
+    if(!fence)
+        return;
+    context->SignalFence(fence, 1);
+    context->Flush();
+
+    manager_->addRenderTask([entry, staging, fence](SceneManager* manager)
+    {
+        if(fence->GetCompletedValue() < 1)
+            return false;
+
+        TextureDesc descs[2];
+        Levels levels[2];
+        for(int i=0; i<2; ++i)
+        {
+            descs[i] = staging[i]->GetDesc();
+            levels[i].resize(descs[i].MipLevels);
+            for(std::uint32_t mip=0; mip<descs[i].MipLevels; ++mip)
+                for(std::uint32_t slice=0; slice<sliceCount(descs[i]); ++slice)
+                {
+                    MappedTextureSubresource data;
+                    manager->context()->MapTextureSubresource(staging[i], mip, slice, MAP_READ, MAP_FLAG_DO_NOT_WAIT,
+                                                              nullptr, data);
+                    if(!data.pData)
+                        return true; // the cache is optional
+
+                    appendSubresource(levels[i][mip], descs[i], mip, data.pData,
+                                      std::size_t(data.Stride), std::size_t(data.DepthStride));
+                    manager->context()->UnmapTextureSubresource(staging[i], mip, slice);
+                }
+        }
+
+        // the names point to the staging textures, which are not needed by the writer
+        descs[0].Name = descs[1].Name = nullptr;
+
+        manager->getWorkerPool().enqueue([entry, descs, levels]() mutable
+        {
+            try
+            {
+                AssetPack::Writer writer;
+                if(entry->has_map)
+                    writer.addTexture(AssetPack::ENTRY_ENVIRONMENT_MAP, entry->key, entry->map_desc,
+                                      std::move(entry->map_levels));
+                writer.addTexture(AssetPack::ENTRY_IRRADIANCE_MAP, entry->key, descs[0], std::move(levels[0]));
+                writer.addTexture(AssetPack::ENTRY_PREFILTERED_MAP, entry->key, descs[1], std::move(levels[1]));
+                createDirectories(entry->filename.substr(0, entry->filename.find_last_of('/')));
+                writer.write(entry->filename);
+            }
+            catch(const std::exception&)
+            {
+                // the cache is optional, e.g. the directory may not be writable
+            }
+        });
+
+        return true;
+    });
+}
+
+}
@@ -0,0 +1,117 @@
+#include <dg/scene/mesh_buffers.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+
+namespace dg {
+
+MeshBuffers::Ptr MeshBuffers::create(IRenderDevice* device, const std::string& name,
+                                     const std::vector<LayoutElement>& input_layout, PRIMITIVE_TOPOLOGY topology,
+                                     const void* vertices, std::uint32_t vertex_stride, std::uint32_t vertex_count,
+                                     const std::uint32_t* indices, std::uint32_t index_count)
+{
+    Ptr mesh = make();
+
+    mesh->input_layout = input_layout;
+    mesh->primitive_topology = topology;
+    mesh->vertex_count = vertex_count;
+
+    std::string vb_name = name + " vertex buffer";
+
+    BufferDesc vert_buff_desc;
+    vert_buff_desc.Name          = vb_name.c_str();
+    vert_buff_desc.Usage         = USAGE_STATIC;
+    vert_buff_desc.BindFlags     = BIND_VERTEX_BUFFER;
+    vert_buff_desc.uiSizeInBytes = vertex_stride*vertex_count;
+
+    BufferData vb_data;
+    vb_data.pData    = vertices;
+    vb_data.DataSize = vert_buff_desc.uiSizeInBytes;
+    device->CreateBuffer(vert_buff_desc, &vb_data, &mesh->vertex_buffer);
+
+    // use 16 bit indices whenever they are sufficient
+    mesh->index_count = index_count;
+    mesh->index_type = indexTypeForVertexCount(vertex_count);
+
+    std::vector<std::uint8_t> packed_indices;
+    std::string ib_name = name + " index buffer";
+
+    BufferDesc ind_buff_desc;
+    ind_buff_desc.Name          = ib_name.c_str();
+    ind_buff_desc.Usage         = USAGE_STATIC;
+    ind_buff_desc.BindFlags     = BIND_INDEX_BUFFER;
+    ind_buff_desc.uiSizeInBytes = index_count*indexSize(mesh->index_type);
+
+    BufferData ib_data;
+    ib_data.pData    = packIndices(indices, index_count, mesh->index_type, packed_indices);
+    ib_data.DataSize = ind_buff_desc.uiSizeInBytes;
+    device->CreateBuffer(ind_buff_desc, &ib_data, &mesh->index_buffer);
+
+    int position_offset = findPositionOffset(input_layout);
+    if(position_offset >= 0)
+        computeBoundingSphere(static_cast<const std::uint8_t*>(vertices) + position_offset, vertex_count, vertex_stride,
+                              mesh->bounds_center, mesh->bounds_radius);
+
+    return mesh;
+}
+
+void MeshBuffers::addLod(IRenderDevice* device, const std::string& name, const std::uint32_t* indices, std::uint32_t index_count, float error)
+{
+    Renderable::LodLevel lod;
+    lod.index_count = index_count;
+    lod.error = error;
+
+    std::vector<std::uint8_t> packed_indices;
+    std::string ib_name = name + " LOD" + std::to_string(lods.size()+1) + " index buffer";
+
+    BufferDesc ind_buff_desc;
+    ind_buff_desc.Name          = ib_name.c_str();
+    ind_buff_desc.Usage         = USAGE_STATIC;
+    ind_buff_desc.BindFlags     = BIND_INDEX_BUFFER;
+    ind_buff_desc.uiSizeInBytes = index_count*indexSize(index_type);
+
+    BufferData ib_data;
+    ib_data.pData    = packIndices(indices, index_count, index_type, packed_indices);
+    ib_data.DataSize = ind_buff_desc.uiSizeInBytes;
+    device->CreateBuffer(ind_buff_desc, &ib_data, &lod.index_buffer);
+
+    lods.push_back(std::move(lod));
+}
+
+MeshBuffers::Ptr MeshBuffers::create(IRenderDevice* device, const std::string& name, const MeshData& data)
+{
+    Ptr mesh = create(device, name, data.input_layout, data.primitive_topology,
+                      data.vertices.data(), data.vertex_stride, data.vertex_count,
+                      data.indices.data(), static_cast<std::uint32_t>(data.indices.size()));
+
+    for(const MeshLod& lod : data.lods)
+        mesh->addLod(device, name, lod.indices.data(), static_cast<std::uint32_t>(lod.indices.size()), lod.error);
+
+    return mesh;
+}
+
+void MeshBuffers::applyTo(Renderable& r) const
+{
+    r.vertex_buffer = vertex_buffer;
+    r.index_buffer = index_buffer;
+    r.index_count = index_count;
+    r.index_type = index_type;
+    r.input_layout = input_layout;
+    r.primitive_topology = primitive_topology;
+    r.bounds_center = bounds_center;
+    r.bounds_radius = bounds_radius;
+    r.lods = lods;
+}
+
+std::size_t MeshBuffers::getSizeInBytes() const
+{
+    std::size_t size = 0;
+    if(vertex_buffer)
+        size += vertex_buffer->GetDesc().uiSizeInBytes;
+    if(index_buffer)
+        size += index_buffer->GetDesc().uiSizeInBytes;
+    for(const Renderable::LodLevel& lod : lods)
+        size += lod.index_buffer->GetDesc().uiSizeInBytes;
+    return size;
+}
+
+}
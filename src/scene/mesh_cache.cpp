@@ -0,0 +1,139 @@
+#include <dg/scene/mesh_cache.hpp>
+
+#include <dg/geometry/mesh_data.hpp>
+
+namespace dg {
+
+namespace {
+
+// seed of the second hash of the signatures, which differs from the seed of the key hashes
+const std::size_t g_signature_seed = 0x9e3779b97f4a7c15ULL;
+
+template <typename T>
+void hashSignature(std::size_t& seed, const std::vector<T>& values)
+{
+    hash_combine(seed, values.size());
+    seed = hash_bytes(values.data(), values.size()*sizeof(T), seed);
+}
+
+}
+
+MeshBuffers::Ptr MeshCache::get(IRenderDevice* device, const IGeometry& geometry,
+                                const std::vector<Color>& colors, const VertexFormat& format, MeshOptimization optimization)
+{
+    std::size_t key_hash = hashGeometry(geometry);
+    hash_combine(key_hash, hashOptions(colors, format, optimization));
+
+    Signature signature = optionsSignature(colors, format, optimization);
+    signature.vertex_count = geometry.getPositions().size();
+    signature.index_count = geometry.getIndices().size();
+    signature.byte_size = geometry.getPositions().size()*sizeof(Vector3) + geometry.getNormals().size()*sizeof(Vector3) +
+                          geometry.getUVs().size()*sizeof(Vector2f) + geometry.getIndices().size()*sizeof(std::uint32_t);
+    hashSignature(signature.content_hash, geometry.getPositions());
+    hashSignature(signature.content_hash, geometry.getNormals());
+    hashSignature(signature.content_hash, geometry.getUVs());
+    hashSignature(signature.content_hash, geometry.getIndices());
+
+    MeshBuffers::Ptr mesh = find(type_id<IGeometry>(), key_hash, signature);
+    if(mesh)
+        return mesh;
+
+    return insert(type_id<IGeometry>(), key_hash, signature, create(device, geometry, colors, format, optimization));
+}
+
+MeshBuffers::Ptr MeshCache::find(TypeId type, std::size_t key_hash, const Signature& signature)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = meshes_.find(Key(type, key_hash));
+    if(it==meshes_.end() || !(it->second.signature == signature))
+        return nullptr;
+
+    return it->second.mesh.lock();
+}
+
+MeshBuffers::Ptr MeshCache::insert(TypeId type, std::size_t key_hash, const Signature& signature, MeshBuffers::Ptr mesh)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Entry& entry = meshes_[Key(type, key_hash)];
+    MeshBuffers::Ptr existing = entry.mesh.lock();
+    if(existing)
+    {
+        // a collision of the hashes keeps the mesh in use, the given mesh is used without being cached
+        return entry.signature == signature ? existing : mesh;
+    }
+
+    entry.mesh = mesh;
+    entry.signature = signature;
+
+    // remove the entries of released meshes from time to time, so that the map does not grow unbounded
+    if(++inserts_since_purge_ >= 64)
+        purgeLocked();
+
+    return mesh;
+}
+
+std::size_t MeshCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::size_t count = 0;
+    for(const auto& p : meshes_)
+        if(!p.second.mesh.expired())
+            ++count;
+    return count;
+}
+
+void MeshCache::purge()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    purgeLocked();
+}
+
+void MeshCache::purgeLocked()
+{
+    for(auto it = meshes_.begin(); it!=meshes_.end(); )
+    {
+        if(it->second.mesh.expired())
+            it = meshes_.erase(it);
+        else
+            ++it;
+    }
+    inserts_since_purge_ = 0;
+}
+
+MeshBuffers::Ptr MeshCache::create(IRenderDevice* device, const IGeometry& geometry,
+                                   const std::vector<Color>& colors, const VertexFormat& format, MeshOptimization optimization)
+{
+    MeshData data = MeshData::fromGeometry(geometry, colors, format);
+    optimizeMesh(optimization, data);
+    return MeshBuffers::create(device, "GeometryObject", data);
+}
+
+std::size_t MeshCache::hashOptions(const std::vector<Color>& colors, const VertexFormat& format, MeshOptimization optimization)
+{
+    std::size_t seed = 0;
+    hash_combine(seed, colors.size());
+    hash_combine(seed, hash_bytes(colors.data(), colors.size()*sizeof(Color)));
+    hash_combine(seed, static_cast<int>(format.normal));
+    hash_combine(seed, static_cast<int>(format.color));
+    hash_combine(seed, static_cast<int>(format.uv));
+    hash_combine(seed, static_cast<int>(optimization));
+    return seed;
+}
+
+MeshCache::Signature MeshCache::optionsSignature(const std::vector<Color>& colors, const VertexFormat& format,
+                                                MeshOptimization optimization)
+{
+    Signature signature;
+    signature.content_hash = g_signature_seed;
+    hashSignature(signature.content_hash, colors);
+    hash_combine(signature.content_hash, static_cast<int>(format.normal));
+    hash_combine(signature.content_hash, static_cast<int>(format.color));
+    hash_combine(signature.content_hash, static_cast<int>(format.uv));
+    hash_combine(signature.content_hash, static_cast<int>(optimization));
+    return signature;
+}
+
+}
@@ -0,0 +1,257 @@
+#include <dg/scene/mesh_manager.hpp>
+
+#include <dg/scene/scene_manager.hpp>
+#include <dg/material/unlit_material.hpp>
+
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+
+namespace dg {
+
+std::size_t SharedMesh::getSizeInBytes() const
+{
+    std::size_t size = 0;
+    for(const MeshBuffers::ConstPtr& section : sections)
+        size += section->getSizeInBytes();
+    return size;
+}
+
+
+/// State of an asynchronous load, that is shared by the manager, the worker thread and the render task
+struct MeshManager::PendingLoad
+{
+    std::string key;
+
+    // written by the worker thread
+    std::mutex mutex;
+    bool loaded = false;
+    MeshLoader loader;
+    std::exception_ptr error;
+
+    // accessed on the render thread only
+    SharedMesh::Ptr mesh;
+    std::promise<SharedMesh::Ptr> promise;
+    std::shared_future<SharedMesh::Ptr> future;
+    std::vector<LoadCallback> callbacks;
+
+    void finish(SharedMesh::Ptr result, std::exception_ptr e)
+    {
+        std::string message;
+        if(e)
+        {
+            promise.set_exception(e);
+            try { std::rethrow_exception(e); }
+            catch(const std::exception& ex) { message = ex.what(); }
+            catch(...) { message = "Unknown error"; }
+        }
+        else
+            promise.set_value(result);
+
+        for(const LoadCallback& callback : callbacks)
+            callback(result, message);
+    }
+};
+
+
+MeshManager::MeshManager(SceneManager* manager) : manager_(manager)
+{
+}
+
+MeshManager::~MeshManager() = default;
+
+std::string MeshManager::resourceKey(const std::string& filename)
+{
+    char path[PATH_MAX];
+    if(realpath(filename.c_str(), path))
+        return path;
+
+    return filename;
+}
+
+SharedMesh::Ptr MeshManager::load(const std::string& filename)
+{
+    std::string key = resourceKey(filename);
+
+    SharedMesh::Ptr mesh = find(key);
+    if(mesh)
+        return mesh;
+
+    MeshLoader loader(filename, settings_);
+    loader.load(false, nullptr, &manager_->getWorkerPool());
+
+    mesh = SharedMesh::make();
+    mesh->filename = filename;
+    for(std::size_t i=0; i<loader.getMeshCount(); ++i)
+        mesh->sections.push_back(loader.upload(manager_->device(), i));
+
+    return insert(key, mesh);
+}
+
+SharedMesh::Ptr MeshManager::load(const AssetPack& pack, const std::string& name)
+{
+    // the pack and the name of the entry, which is not a valid path and cannot collide with a file
+    std::string key = resourceKey(pack.getFilename()) + ":" + name;
+
+    SharedMesh::Ptr mesh = find(key);
+    if(mesh)
+        return mesh;
+
+    mesh = SharedMesh::make();
+    mesh->filename = key;
+    for(const MeshBuffers::Ptr& section : pack.createMeshes(manager_->device(), name))
+        mesh->sections.push_back(section);
+
+    return insert(key, mesh);
+}
+
+std::shared_future<SharedMesh::Ptr> MeshManager::loadAsync(const std::string& filename, LoadCallback callback)
+{
+    std::string key = resourceKey(filename);
+
+    SharedMesh::Ptr mesh = find(key);
+    if(mesh)
+    {
+        std::promise<SharedMesh::Ptr> promise;
+        promise.set_value(mesh);
+        if(callback)
+            callback(mesh, std::string());
+        return promise.get_future().share();
+    }
+
+    auto it = pending_.find(key);
+    if(it != pending_.end())
+    {
+        if(callback)
+            it->second->callbacks.push_back(std::move(callback));
+        return it->second->future;
+    }
+
+    std::shared_ptr<PendingLoad> load = std::make_shared<PendingLoad>();
+    load->key = key;
+    load->future = load->promise.get_future().share();
+    if(callback)
+        load->callbacks.push_back(std::move(callback));
+    load->loader = MeshLoader(filename, settings_);
+    load->mesh = SharedMesh::make();
+    load->mesh->filename = filename;
+    pending_[key] = load;
+
+    WorkerPool* pool = &manager_->getWorkerPool();
+    pool->enqueue([load, pool]()
+    {
+        std::exception_ptr error;
+        try
+        {
+            load->loader.load(true, nullptr, pool);
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(load->mutex);
+        load->error = error;
+        load->loaded = true;
+    });
+
+    // the scene manager owns this manager and its tasks, hence the task cannot outlive the manager
+    manager_->addRenderTask([this, load](SceneManager*) { return uploadSections(*load); });
+
+    return load->future;
+}
+
+bool MeshManager::uploadSections(PendingLoad& load)
+{
+    {
+        std::lock_guard<std::mutex> lock(load.mutex);
+        if(!load.loaded)
+            return false;
+    }
+
+    std::exception_ptr error = load.error;
+
+    // at least one section per frame, the others within the upload budget
+    bool uploaded = false;
+    while(!error && load.mesh->sections.size() < load.loader.getMeshCount())
+    {
+        if(uploaded && manager_->getRemainingUploadBudget()==0)
+            return false;
+
+        try
+        {
+            std::size_t i = load.mesh->sections.size();
+            manager_->consumeUploadBudget(load.loader.getMeshSize(i));
+            load.mesh->sections.push_back(load.loader.upload(manager_->device(), i));
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+        uploaded = true;
+    }
+
+    pending_.erase(load.key);
+
+    if(error)
+        load.finish(nullptr, error);
+    else
+        load.finish(insert(load.key, load.mesh), nullptr);
+
+    return true;
+}
+
+SharedMesh::Ptr MeshManager::find(const std::string& filename)
+{
+    auto it = meshes_.find(resourceKey(filename));
+    if(it == meshes_.end())
+        return nullptr;
+
+    SharedMesh::Ptr mesh = it->second.lock();
+    if(!mesh)
+        meshes_.erase(it);
+
+    return mesh;
+}
+
+SharedMesh::Ptr MeshManager::insert(const std::string& key, SharedMesh::Ptr mesh)
+{
+    // a synchronous load of the same file may have finished while the asynchronous one was pending
+    SharedMesh::WeakPtr& entry = meshes_[key];
+    SharedMesh::Ptr existing = entry.lock();
+    if(existing)
+        return existing;
+
+    entry = mesh;
+    return mesh;
+}
+
+std::size_t MeshManager::size() const
+{
+    std::size_t count = 0;
+    for(const auto& p : meshes_)
+        if(!p.second.expired())
+            ++count;
+    return count;
+}
+
+void MeshManager::purge()
+{
+    for(auto it = meshes_.begin(); it != meshes_.end(); )
+    {
+        if(it->second.expired())
+            it = meshes_.erase(it);
+        else
+            ++it;
+    }
+}
+
+IMaterial::Ptr MeshManager::getDefaultMaterial()
+{
+    if(!default_material_)
+        default_material_ = UnlitMaterial::make(manager_->device());
+
+    return default_material_;
+}
+
+}
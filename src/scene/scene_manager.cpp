@@ -9,6 +9,7 @@
 #include <dg/core/conversion.hpp>
 #include <dg/material/material.hpp>
 #include <dg/material/common_constants.hpp>
+#include <dg/material/ktx_file.hpp>
 
 #include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
 #include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
@@ -16,6 +17,9 @@
 
 #include <DiligentTools/TextureLoader/interface/TextureUtilities.h>
 
+#include <cmath>
+#include <limits>
+
 
 #define FIRST_(a, ...) a
 #define SECOND_(a, b, ...) b
@@ -80,7 +84,7 @@
 
 namespace dg {
 
-SceneManager::SceneManager()
+SceneManager::SceneManager() : mesh_manager_(this), texture_streamer_(this), environment_loader_(this)
 {
     root_ = Node::make();
     default_camera_node_ = getRoot()->createChild();
@@ -103,12 +107,28 @@ void SceneManager::setDevice(IRenderDevice* device, IDeviceContext* context, ISw
 
 void SceneManager::setEnvironmentMap(const std::string& filename)
 {
-    CreateTextureFromFile(filename.c_str(), TextureLoadInfo{"SceneManager Environment Map"}, device(), &environment_map_);
-    StateTransitionDesc barriers [] =
+    RefCntAutoPtr<ITexture> map;
+    if(KTXFile::isKTXFile(filename))
+        map = KTXFile(filename).createTexture(device(), "SceneManager Environment Map");
+    else
+        CreateTextureFromFile(filename.c_str(), TextureLoadInfo{"SceneManager Environment Map"}, device(), &map);
+    setEnvironmentMap(map);
+}
+
+void SceneManager::setEnvironmentMap(RefCntAutoPtr<ITexture> map, RefCntAutoPtr<ITexture> irradiance_map,
+                                     RefCntAutoPtr<ITexture> prefiltered_map)
+{
+    environment_map_ = map;
+    irradiance_map_ = irradiance_map;
+    prefiltered_map_ = prefiltered_map;
+
+    for(ITexture* texture : {environment_map_.RawPtr(), irradiance_map_.RawPtr(), prefiltered_map_.RawPtr()})
     {
-        {environment_map_, RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_SHADER_RESOURCE, true}
-    };
-    context()->TransitionResourceStates(_countof(barriers), barriers);
+        if(!texture)
+            continue;
+        StateTransitionDesc barrier{texture, RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_SHADER_RESOURCE, true};
+        context()->TransitionResourceStates(1, &barrier);
+    }
 }
 
 RefCntAutoPtr<ITexture> SceneManager::getEnvironmentMap() const
@@ -118,6 +138,12 @@ RefCntAutoPtr<ITexture> SceneManager::getEnvironmentMap() const
 
 void SceneManager::render()
 {
+    ++frame_number_;
+
+    runRenderTasks();
+
+    texture_streamer_.update();
+
     clearRenderQueues();
 
     getRoot()->updateTransforms();
@@ -187,6 +213,21 @@ void SceneManager::collectRenderables(Node* node)
         collectRenderables(child);
 }
 
+void SceneManager::runRenderTasks()
+{
+    uploaded_in_frame_ = 0;
+
+    // tasks may add new tasks, which are run in the next frame
+    std::vector<std::function<bool(SceneManager*)>> tasks;
+    tasks.swap(render_tasks_);
+
+    for(std::size_t i=0; i<tasks.size(); ++i)
+    {
+        if(!tasks[i](this))
+            render_tasks_.push_back(std::move(tasks[i]));
+    }
+}
+
 void SceneManager::clearRenderQueues()
 {
     for(auto &p : renderQueues_)
@@ -233,6 +274,23 @@ void SceneManager::render(Renderable* r, const Matrices& matrices)
         r->pso_needs_update_ = false;
     }
 
+    // rebinds textures that were replaced (e.g. streamed mip levels or a new video frame)
+    std::uint64_t texture_version = r->material->getTextureVersion();
+    if(r->texture_version_ != texture_version)
+    {
+        r->material->bindSRB(r->srb_);
+        r->texture_version_ = texture_version;
+    }
+
+    // requests the resolution of streamed textures for the next frames
+    if(StreamedTexture* texture = r->material->getStreamedTexture())
+    {
+        Real pixels_per_unit = pixelsPerUnit(r, matrices);
+        float pixels = r->bounds_radius > 0.0f && std::isfinite(pixels_per_unit) ?
+                       float(2.0*r->bounds_radius*pixels_per_unit) : std::numeric_limits<float>::max();
+        texture->requestResolution(pixels, frame_number_);
+    }
+
     {
         auto constants = r->material->shader_program_->mapConstant<dg::CommonConstantsVS>(context(), "CommonConstantsVS");
         matrix_to_float4x4t(current_render_matrices_->world_view_proj, constants->g_worldViewProj);
@@ -248,11 +306,16 @@ void SceneManager::render(Renderable* r, const Matrices& matrices)
         last_material_in_render_ = r->material.get();
     }
 
+    // the levels of detail share the vertex buffer and only have their own index buffers
+    int lod = selectLod(r, matrices);
+    IBuffer* index_buffer = lod < 0 ? r->index_buffer.RawPtr() : r->lods[lod].index_buffer.RawPtr();
+    Uint32 index_count = lod < 0 ? r->index_count : r->lods[lod].index_count;
+
     // Bind vertex and index buffers
     Uint32   offset   = 0;
     IBuffer* buffs[] = {r->vertex_buffer};
     context()->SetVertexBuffers(0, 1, buffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION, SET_VERTEX_BUFFERS_FLAG_RESET);
-    context()->SetIndexBuffer(r->index_buffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+    context()->SetIndexBuffer(index_buffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
 
     // Set the pipeline state
     if(r->pso_ != last_pso_in_render_)
@@ -263,20 +326,60 @@ void SceneManager::render(Renderable* r, const Matrices& matrices)
     context()->CommitShaderResources(r->srb_, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
 
     DrawIndexedAttribs attr;     // This is an indexed draw call
-    attr.IndexType  = VT_UINT32; // Index type
-    attr.NumIndices = r->index_count;
+    attr.IndexType  = r->index_type; // Index type
+    attr.NumIndices = index_count;
     attr.Flags = DRAW_FLAG_VERIFY_ALL;
     context()->DrawIndexed(attr);
 
     current_render_matrices_ = prev_render_matrices;
 }
 
+Real SceneManager::pixelsPerUnit(const Renderable* r, const Matrices& matrices) const
+{
+    Vector3 center = (matrices.world_view * Vector4(r->bounds_center.x(), r->bounds_center.y(), r->bounds_center.z(), 1.0)).head<3>();
+    Real scale = matrices.world_view.block<3,3>(0,0).colwise().norm().maxCoeff();
+
+    // size of one local unit on the screen in pixels at the point of the bounding sphere that is closest to the camera
+    Real pixels_per_unit = matrices.proj(1,1) * 0.5 * swap_chain_->GetDesc().Height * scale;
+
+    bool perspective = matrices.proj(3,2) != 0.0;
+    if(perspective)
+    {
+        Real distance = center.norm() - r->bounds_radius*scale;
+        if(distance <= 0.0)
+            return std::numeric_limits<Real>::infinity();
+        pixels_per_unit /= distance;
+    }
+
+    return pixels_per_unit;
+}
+
+int SceneManager::selectLod(const Renderable* r, const Matrices& matrices) const
+{
+    if(r->lods.empty() || r->bounds_radius <= 0.0f || lod_pixel_error_ <= 0.0f)
+        return -1;
+
+    // the full resolution if the camera is inside the bounding sphere
+    Real pixels_per_unit = pixelsPerUnit(r, matrices);
+    if(!std::isfinite(pixels_per_unit))
+        return -1;
+
+    for(int i=int(r->lods.size())-1; i>=0; --i)
+        if(r->lods[i].error * pixels_per_unit <= lod_pixel_error_)
+            return i;
+
+    return -1;
+}
+
 void SceneManager::render(RawRenderable* r, const Matrices& matrices)
 {
     const Matrices* prev_render_matrices = current_render_matrices_;
     current_render_matrices_ = &matrices;
     r->render(this);
     current_render_matrices_ = prev_render_matrices;
+
+    // raw renderables bind their own pipeline states
+    last_pso_in_render_ = nullptr;
 }
 
 }
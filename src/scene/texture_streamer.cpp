@@ -0,0 +1,258 @@
+#include <dg/scene/texture_streamer.hpp>
+#include <dg/scene/scene_manager.hpp>
+
+#include <DiligentCore/Graphics/GraphicsEngine/interface/RenderDevice.h>
+#include <DiligentCore/Graphics/GraphicsEngine/interface/DeviceContext.h>
+#include <DiligentCore/Graphics/GraphicsAccessories/interface/GraphicsAccessories.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dg {
+
+// textures that were not drawn for this many frames fall back to their coarse mip levels
+static const std::uint64_t g_unused_frames = 120;
+
+// maximum number of files that are read by prefetch tasks at the same time
+static const int g_max_prefetches = 4;
+
+
+StreamedTexture::StreamedTexture(KTXFile::Ptr file, const std::string& name) :
+    file_(std::move(file)), name_(name), prefetched_mip_(0), prefetch_pending_(false)
+{
+}
+
+void StreamedTexture::requestResolution(float pixels, std::uint64_t frame)
+{
+    if(frame != request_frame_)
+    {
+        request_frame_ = frame;
+        requested_pixels_ = pixels;
+    }
+    else
+        requested_pixels_ = std::max(requested_pixels_, pixels);
+}
+
+std::size_t StreamedTexture::getSize(std::uint32_t first_mip) const
+{
+    std::size_t size = 0;
+    for(std::uint32_t mip=first_mip; mip<file_->getDesc().MipLevels; ++mip)
+        size += file_->getLevelSize(mip);
+    return size;
+}
+
+
+TextureStreamer::TextureStreamer(SceneManager* manager) :
+    manager_(manager)
+{
+}
+
+StreamedTexture::Ptr TextureStreamer::load(const std::string& filename)
+{
+    return load(KTXFile::open(filename), filename);
+}
+
+StreamedTexture::Ptr TextureStreamer::load(KTXFile::Ptr file, const std::string& name)
+{
+    StreamedTexture::Ptr texture = StreamedTexture::make(std::move(file), name);
+
+    const TextureDesc& desc = texture->file_->getDesc();
+    std::uint32_t base_mip = 0;
+    while(base_mip+1 < desc.MipLevels && std::max(desc.Width >> base_mip, desc.Height >> base_mip) > initial_size_)
+        ++base_mip;
+
+    texture->base_mip_ = base_mip;
+    texture->target_mip_ = base_mip;
+    texture->prefetched_mip_ = base_mip;
+    replaceTexture(*texture, base_mip);
+
+    textures_.push_back(texture);
+    return texture;
+}
+
+std::size_t TextureStreamer::getResidentSize() const
+{
+    std::size_t size = 0;
+    for(const StreamedTexture::WeakPtr& weak_texture : textures_)
+    {
+        StreamedTexture::Ptr texture = weak_texture.lock();
+        if(texture)
+            size += texture->getResidentSize();
+    }
+    return size;
+}
+
+void TextureStreamer::update()
+{
+    std::uint64_t frame = manager_->getFrameNumber();
+
+    std::vector<StreamedTexture::Ptr> textures;
+    textures.reserve(textures_.size());
+    for(const StreamedTexture::WeakPtr& weak_texture : textures_)
+    {
+        StreamedTexture::Ptr texture = weak_texture.lock();
+        if(texture)
+            textures.push_back(texture);
+    }
+    textures_.assign(textures.begin(), textures.end());
+
+    // the mip level whose size matches the requested resolution on the screen
+    std::size_t total_size = 0;
+    int prefetches = 0;
+    for(const StreamedTexture::Ptr& texture : textures)
+    {
+        std::uint32_t mip = texture->base_mip_;
+        if(texture->request_frame_ + g_unused_frames >= frame && texture->requested_pixels_ > 0.0f)
+        {
+            const TextureDesc& desc = texture->file_->getDesc();
+            float level = std::floor(std::log2(float(std::max(desc.Width, desc.Height)) / texture->requested_pixels_));
+            mip = std::uint32_t(std::min(std::max(level, 0.0f), float(texture->base_mip_)));
+        }
+
+        texture->target_mip_ = mip;
+        total_size += texture->getSize(mip);
+        prefetches += texture->prefetch_pending_ ? 1 : 0;
+    }
+
+    // reduce the least recently drawn and then the smallest textures on the screen first, until the budget is met
+    if(total_size > memory_budget_)
+    {
+        std::vector<StreamedTexture*> order;
+        for(const StreamedTexture::Ptr& texture : textures)
+            order.push_back(texture.get());
+
+        std::sort(order.begin(), order.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+        {
+            if(a->request_frame_ != b->request_frame_)
+                return a->request_frame_ < b->request_frame_;
+            return a->requested_pixels_ < b->requested_pixels_;
+        });
+
+        for(std::size_t i=0; i<order.size() && total_size > memory_budget_; ++i)
+        {
+            StreamedTexture* texture = order[i];
+            while(total_size > memory_budget_ && texture->target_mip_ < texture->base_mip_)
+            {
+                total_size -= texture->file_->getLevelSize(texture->target_mip_);
+                ++texture->target_mip_;
+            }
+        }
+    }
+
+    bool uploaded = false;
+    for(const StreamedTexture::Ptr& texture : textures)
+    {
+        // streaming out only copies on the GPU
+        if(texture->target_mip_ > texture->resident_mip_)
+        {
+            replaceTexture(*texture, texture->target_mip_);
+            continue;
+        }
+
+        if(texture->target_mip_ == texture->resident_mip_)
+            continue;
+
+        // the levels are uploaded when their pages are read, to not block the render thread on I/O
+        if(texture->prefetched_mip_ > texture->target_mip_)
+        {
+            if(!texture->prefetch_pending_ && prefetches < g_max_prefetches)
+            {
+                prefetch(texture, texture->target_mip_);
+                ++prefetches;
+            }
+            if(texture->prefetched_mip_ >= texture->resident_mip_)
+                continue;
+        }
+
+        // as many levels as fit into the upload budget, at least one level per frame
+        std::size_t budget = manager_->getRemainingUploadBudget();
+        std::uint32_t mip = texture->resident_mip_;
+        std::size_t size = 0;
+        while(mip > std::max(texture->target_mip_, std::uint32_t(texture->prefetched_mip_)))
+        {
+            std::size_t level_size = texture->file_->getLevelSize(mip-1);
+            if(size + level_size > budget && (size > 0 || uploaded))
+                break;
+            size += level_size;
+            --mip;
+        }
+
+        if(mip < texture->resident_mip_)
+        {
+            replaceTexture(*texture, mip);
+            manager_->consumeUploadBudget(size);
+            uploaded = true;
+        }
+    }
+}
+
+void TextureStreamer::replaceTexture(StreamedTexture& texture, std::uint32_t first_mip)
+{
+    const TextureDesc& file_desc = texture.file_->getDesc();
+    const std::vector<TextureSubResData>& subresources = texture.file_->getSubresources();
+    std::uint32_t mip_levels = file_desc.MipLevels;
+
+    TextureDesc desc = file_desc;
+    desc.Name = texture.name_.c_str();
+    desc.Usage = USAGE_DEFAULT;
+    desc.Width = std::max(file_desc.Width >> first_mip, 1u);
+    desc.Height = std::max(file_desc.Height >> first_mip, 1u);
+    if(desc.Type == RESOURCE_DIM_TEX_3D)
+        desc.Depth = std::max(file_desc.Depth >> first_mip, 1u);
+    desc.MipLevels = mip_levels - first_mip;
+
+    RefCntAutoPtr<ITexture> new_texture;
+    manager_->device()->CreateTexture(desc, nullptr, &new_texture);
+    if(!new_texture)
+        DG_THROW("Cannot create streamed texture " + texture.name_);
+
+    IDeviceContext* context = manager_->context();
+    for(std::uint32_t slice=0; slice<texture.file_->getSliceCount(); ++slice)
+    {
+        for(std::uint32_t mip=first_mip; mip<mip_levels; ++mip)
+        {
+            // resident levels are copied on the GPU, the others are uploaded from the mapped file
+            if(texture.texture_ && mip >= texture.resident_mip_)
+            {
+                CopyTextureAttribs copy(texture.texture_, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                        new_texture, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+                copy.SrcMipLevel = mip - texture.resident_mip_;
+                copy.SrcSlice = slice;
+                copy.DstMipLevel = mip - first_mip;
+                copy.DstSlice = slice;
+                context->CopyTexture(copy);
+            }
+            else
+            {
+                MipLevelProperties level = GetMipLevelProperties(desc, mip - first_mip);
+                Box box(0, level.LogicalWidth, 0, level.LogicalHeight);
+                box.MaxZ = level.Depth;
+                context->UpdateTexture(new_texture, mip - first_mip, slice, box, subresources[mip + slice*mip_levels],
+                                       RESOURCE_STATE_TRANSITION_MODE_NONE, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            }
+        }
+    }
+
+    StateTransitionDesc barrier{new_texture, RESOURCE_STATE_UNKNOWN, RESOURCE_STATE_SHADER_RESOURCE, true};
+    context->TransitionResourceStates(1, &barrier);
+
+    texture.texture_ = new_texture;
+    texture.resident_mip_ = first_mip;
+    ++texture.version_;
+}
+
+void TextureStreamer::prefetch(const StreamedTexture::Ptr& texture, std::uint32_t first_mip)
+{
+    texture->prefetch_pending_ = true;
+
+    // the task keeps the texture, and with it the mapped file, alive until the pages are read
+    manager_->getWorkerPool().enqueue([texture, first_mip]()
+    {
+        std::uint32_t end_mip = texture->prefetched_mip_;
+        texture->file_->prefetchLevels(first_mip, end_mip - first_mip);
+        texture->prefetched_mip_ = first_mip;
+        texture->prefetch_pending_ = false;
+    });
+}
+
+}
@@ -0,0 +1,759 @@
+// Bakes meshes, textures and environment maps into an asset pack (see AssetPack), that is memory mapped at runtime.
+//
+//  - meshes are imported with Assimp, optimized and simplified to levels of detail like by MeshManager
+//  - textures must be KTX 1.0 or 2.0 files, uncompressed RGBA8 textures with a single level get a mip chain and
+//    are compressed to BC1 (opaque) or BC3, other textures are stored as they are
+//  - environment maps must be KTX cubemaps (RGBA8, RGBA16F or RGBA32F), the diffuse and specular IBL cubemaps are
+//    prefiltered in the size and format of the GLTF PBR renderer
+//
+// usage: dg-bake -o assets.dgpack [-m name=mesh.dae] [-t name=texture.ktx] [-e name=environment.ktx] ...
+//        dg-bake --info file.dgpack|file.ktx|file.ktx2
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+#include <dg/scene/asset_pack.hpp>
+#include <dg/material/ktx_file.hpp>
+#include <dg/internal/mesh_loader.hpp>
+#include <dg/geometry/vertex_format.hpp>
+
+using namespace dg;
+
+// IBL cubemaps as created by GLTF_PBR_Renderer, they are only used if they match
+static const std::uint32_t IRRADIANCE_SIZE = 64;
+static const std::uint32_t PREFILTERED_SIZE = 256;
+
+static const std::uint32_t PREFILTER_SAMPLES = 64;
+
+
+// ---- pixels ---------------------------------------------------------------------------------------------------
+
+struct Pixel
+{
+    float r, g, b, a;
+};
+
+using Image = std::vector<Pixel>;
+
+static float srgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(float c)
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+static float halfToFloat(std::uint16_t h)
+{
+    std::uint32_t sign = std::uint32_t(h & 0x8000) << 16;
+    std::uint32_t exponent = (h >> 10) & 0x1F;
+    std::uint32_t mantissa = h & 0x3FF;
+
+    float value;
+    if(exponent == 0)
+        value = std::ldexp(float(mantissa), -24);
+    else if(exponent == 31)
+        value = mantissa ? NAN : INFINITY;
+    else
+        value = std::ldexp(float(mantissa | 0x400), int(exponent) - 25);
+
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits |= sign;
+    std::memcpy(&value, &bits, sizeof(bits));
+    return value;
+}
+
+// decodes a tightly packed slice of a supported format to linear floats
+static bool decode(const TextureSubResData& data, TEXTURE_FORMAT format, std::uint32_t width, std::uint32_t height, Image& image)
+{
+    image.resize(std::size_t(width) * height);
+    for(std::uint32_t y=0; y<height; ++y)
+    {
+        const std::uint8_t* row = static_cast<const std::uint8_t*>(data.pData) + std::size_t(y) * data.Stride;
+        for(std::uint32_t x=0; x<width; ++x)
+        {
+            Pixel& p = image[std::size_t(y) * width + x];
+            switch(format)
+            {
+                case TEX_FORMAT_RGBA8_UNORM:
+                case TEX_FORMAT_RGBA8_UNORM_SRGB:
+                {
+                    const std::uint8_t* c = row + 4*x;
+                    bool srgb = format == TEX_FORMAT_RGBA8_UNORM_SRGB;
+                    p.r = srgb ? srgbToLinear(c[0] / 255.0f) : c[0] / 255.0f;
+                    p.g = srgb ? srgbToLinear(c[1] / 255.0f) : c[1] / 255.0f;
+                    p.b = srgb ? srgbToLinear(c[2] / 255.0f) : c[2] / 255.0f;
+                    p.a = c[3] / 255.0f;
+                    break;
+                }
+                case TEX_FORMAT_RGBA16_FLOAT:
+                {
+                    std::uint16_t c[4];
+                    std::memcpy(c, row + 8*x, sizeof(c));
+                    p = Pixel{halfToFloat(c[0]), halfToFloat(c[1]), halfToFloat(c[2]), halfToFloat(c[3])};
+                    break;
+                }
+                case TEX_FORMAT_RGBA32_FLOAT:
+                    std::memcpy(&p, row + 16*x, sizeof(p));
+                    break;
+                default:
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+// half the size with a box filter, odd sizes repeat the last row or column
+static Image downsample(const Image& src, std::uint32_t width, std::uint32_t height)
+{
+    std::uint32_t w = std::max(width / 2, 1u);
+    std::uint32_t h = std::max(height / 2, 1u);
+
+    Image dst(std::size_t(w) * h);
+    for(std::uint32_t y=0; y<h; ++y)
+    {
+        for(std::uint32_t x=0; x<w; ++x)
+        {
+            std::uint32_t x0 = std::min(2*x, width-1), x1 = std::min(2*x+1, width-1);
+            std::uint32_t y0 = std::min(2*y, height-1), y1 = std::min(2*y+1, height-1);
+            const Pixel& a = src[std::size_t(y0)*width + x0];
+            const Pixel& b = src[std::size_t(y0)*width + x1];
+            const Pixel& c = src[std::size_t(y1)*width + x0];
+            const Pixel& d = src[std::size_t(y1)*width + x1];
+            dst[std::size_t(y)*w + x] = Pixel{0.25f*(a.r+b.r+c.r+d.r), 0.25f*(a.g+b.g+c.g+d.g),
+                                              0.25f*(a.b+b.b+c.b+d.b), 0.25f*(a.a+b.a+c.a+d.a)};
+        }
+    }
+    return dst;
+}
+
+// runs f(i) for i in [0, count) on all hardware threads
+template<typename F>
+static void parallelFor(std::size_t count, F f)
+{
+    std::atomic<std::size_t> next(0);
+    std::vector<std::thread> threads;
+    for(unsigned t=0; t<std::max(std::thread::hardware_concurrency(), 1u); ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            for(std::size_t i = next++; i < count; i = next++)
+                f(i);
+        });
+    }
+    for(std::thread& thread : threads)
+        thread.join();
+}
+
+
+// ---- block compression ----------------------------------------------------------------------------------------
+
+static std::uint16_t toRGB565(const float c[3])
+{
+    return std::uint16_t((std::lround(c[0] * 31.0f) << 11) | (std::lround(c[1] * 63.0f) << 5) | std::lround(c[2] * 31.0f));
+}
+
+static void fromRGB565(std::uint16_t v, float c[3])
+{
+    c[0] = ((v >> 11) & 31) / 31.0f;
+    c[1] = ((v >> 5) & 63) / 63.0f;
+    c[2] = (v & 31) / 31.0f;
+}
+
+// BC1 color block of 16 RGB colors in [0,1] (always the four color mode), endpoints from the inset bounding box
+static void encodeColorBlock(const float colors[16][4], std::uint8_t* block)
+{
+    float lo[3] = {1, 1, 1}, hi[3] = {0, 0, 0};
+    for(int i=0; i<16; ++i)
+    {
+        for(int c=0; c<3; ++c)
+        {
+            lo[c] = std::min(lo[c], colors[i][c]);
+            hi[c] = std::max(hi[c], colors[i][c]);
+        }
+    }
+    for(int c=0; c<3; ++c)
+    {
+        float inset = (hi[c] - lo[c]) / 16.0f;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    std::uint16_t c0 = toRGB565(hi), c1 = toRGB565(lo);
+    if(c0 < c1)
+        std::swap(c0, c1);
+
+    std::uint32_t indices = 0;
+    if(c0 != c1)
+    {
+        float palette[4][3];
+        fromRGB565(c0, palette[0]);
+        fromRGB565(c1, palette[1]);
+        for(int c=0; c<3; ++c)
+        {
+            palette[2][c] = (2.0f*palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f*palette[1][c]) / 3.0f;
+        }
+
+        for(int i=0; i<16; ++i)
+        {
+            int best = 0;
+            float best_dist = 1e30f;
+            for(int p=0; p<4; ++p)
+            {
+                float dr = colors[i][0]-palette[p][0], dg = colors[i][1]-palette[p][1], db = colors[i][2]-palette[p][2];
+                float dist = dr*dr + dg*dg + db*db;
+                if(dist < best_dist)
+                {
+                    best_dist = dist;
+                    best = p;
+                }
+            }
+            indices |= std::uint32_t(best) << (2*i);
+        }
+    }
+
+    block[0] = std::uint8_t(c0);
+    block[1] = std::uint8_t(c0 >> 8);
+    block[2] = std::uint8_t(c1);
+    block[3] = std::uint8_t(c1 >> 8);
+    for(int i=0; i<4; ++i)
+        block[4+i] = std::uint8_t(indices >> (8*i));
+}
+
+// BC3 alpha block (eight alpha mode)
+static void encodeAlphaBlock(const float colors[16][4], std::uint8_t* block)
+{
+    int a0 = 0, a1 = 255;
+    int alpha[16];
+    for(int i=0; i<16; ++i)
+    {
+        alpha[i] = int(std::lround(colors[i][3] * 255.0f));
+        a0 = std::max(a0, alpha[i]);
+        a1 = std::min(a1, alpha[i]);
+    }
+
+    std::uint64_t indices = 0;
+    if(a0 != a1)
+    {
+        int palette[8] = {a0, a1};
+        for(int p=2; p<8; ++p)
+            palette[p] = ((8-p)*a0 + (p-1)*a1) / 7;
+
+        for(int i=0; i<16; ++i)
+        {
+            int best = 0;
+            for(int p=1; p<8; ++p)
+                if(std::abs(alpha[i] - palette[p]) < std::abs(alpha[i] - palette[best]))
+                    best = p;
+            indices |= std::uint64_t(best) << (3*i);
+        }
+    }
+
+    block[0] = std::uint8_t(a0);
+    block[1] = std::uint8_t(a1);
+    for(int i=0; i<6; ++i)
+        block[2+i] = std::uint8_t(indices >> (8*i));
+}
+
+// compresses the (linear) image, the colors are encoded in sRGB if srgb is set
+static std::vector<std::uint8_t> compress(const Image& image, std::uint32_t width, std::uint32_t height, bool alpha, bool srgb)
+{
+    std::uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    std::size_t block_size = alpha ? 16 : 8;
+
+    std::vector<std::uint8_t> data(std::size_t(blocks_x) * blocks_y * block_size);
+    for(std::uint32_t by=0; by<blocks_y; ++by)
+    {
+        for(std::uint32_t bx=0; bx<blocks_x; ++bx)
+        {
+            float colors[16][4];
+            for(int i=0; i<16; ++i)
+            {
+                std::uint32_t x = std::min(bx*4 + i%4, width-1), y = std::min(by*4 + i/4, height-1);
+                const Pixel& p = image[std::size_t(y)*width + x];
+                float rgb[3] = {p.r, p.g, p.b};
+                for(int c=0; c<3; ++c)
+                {
+                    float v = std::min(std::max(rgb[c], 0.0f), 1.0f);
+                    colors[i][c] = srgb ? linearToSrgb(v) : v;
+                }
+                colors[i][3] = std::min(std::max(p.a, 0.0f), 1.0f);
+            }
+
+            std::uint8_t* block = data.data() + (std::size_t(by)*blocks_x + bx) * block_size;
+            if(alpha)
+            {
+                encodeAlphaBlock(colors, block);
+                encodeColorBlock(colors, block + 8);
+            }
+            else
+                encodeColorBlock(colors, block);
+        }
+    }
+    return data;
+}
+
+static std::vector<std::uint8_t> encodeRGBA8(const Image& image, bool srgb)
+{
+    std::vector<std::uint8_t> data(image.size() * 4);
+    for(std::size_t i=0; i<image.size(); ++i)
+    {
+        const float c[4] = {image[i].r, image[i].g, image[i].b, image[i].a};
+        for(int k=0; k<4; ++k)
+        {
+            float v = std::min(std::max(c[k], 0.0f), 1.0f);
+            data[4*i+k] = std::uint8_t(std::lround((srgb && k < 3 ? linearToSrgb(v) : v) * 255.0f));
+        }
+    }
+    return data;
+}
+
+
+// ---- textures -------------------------------------------------------------------------------------------------
+
+static void bakeTexture(AssetPack::Writer& writer, const std::string& name, const std::string& filename)
+{
+    KTXFile file(filename);
+    const TextureDesc& desc = file.getDesc();
+
+    bool rgba8 = desc.Format == TEX_FORMAT_RGBA8_UNORM || desc.Format == TEX_FORMAT_RGBA8_UNORM_SRGB;
+    if(!rgba8 || desc.Type != RESOURCE_DIM_TEX_2D || desc.MipLevels > 1)
+    {
+        writer.addFile(AssetPack::ENTRY_TEXTURE, name, filename);
+        return;
+    }
+
+    bool srgb = desc.Format == TEX_FORMAT_RGBA8_UNORM_SRGB;
+    Image image;
+    decode(file.getSubresources()[0], desc.Format, desc.Width, desc.Height, image);
+
+    bool alpha = false;
+    for(const Pixel& p : image)
+        alpha = alpha || p.a < 1.0f;
+
+    // block compression requires sizes that are a multiple of the blocks
+    bool compressed = desc.Width % 4 == 0 && desc.Height % 4 == 0;
+
+    TextureDesc baked = desc;
+    baked.MipLevels = 1;
+    while((std::max(desc.Width, desc.Height) >> baked.MipLevels) > 0)
+        ++baked.MipLevels;
+    if(compressed)
+        baked.Format = alpha ? (srgb ? TEX_FORMAT_BC3_UNORM_SRGB : TEX_FORMAT_BC3_UNORM)
+                             : (srgb ? TEX_FORMAT_BC1_UNORM_SRGB : TEX_FORMAT_BC1_UNORM);
+
+    std::vector<std::vector<std::uint8_t>> levels;
+    std::uint32_t width = desc.Width, height = desc.Height;
+    for(std::uint32_t mip=0; mip<baked.MipLevels; ++mip)
+    {
+        levels.push_back(compressed ? compress(image, width, height, alpha, srgb) : encodeRGBA8(image, srgb));
+        image = downsample(image, width, height);
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    writer.addTexture(AssetPack::ENTRY_TEXTURE, name, baked, std::move(levels));
+}
+
+
+// ---- environment maps -----------------------------------------------------------------------------------------
+
+struct Cubemap
+{
+    std::uint32_t size = 0;
+    std::vector<Image> faces[6]; // per face the mip chain
+};
+
+// direction of the texel center (x, y) of the face in the D3D cube layout
+static Vector3f texelDirection(int face, std::uint32_t x, std::uint32_t y, std::uint32_t size)
+{
+    float u = 2.0f * (x + 0.5f) / size - 1.0f;
+    float v = 2.0f * (y + 0.5f) / size - 1.0f;
+
+    Vector3f dir;
+    switch(face)
+    {
+        case 0:  dir = Vector3f(1, -v, -u); break;
+        case 1:  dir = Vector3f(-1, -v, u); break;
+        case 2:  dir = Vector3f(u, 1, v); break;
+        case 3:  dir = Vector3f(u, -1, -v); break;
+        case 4:  dir = Vector3f(u, -v, 1); break;
+        default: dir = Vector3f(-u, -v, -1); break;
+    }
+    return dir.normalized();
+}
+
+static Pixel sampleFace(const Image& image, std::uint32_t size, float u, float v)
+{
+    // bilinear, clamped at the edges of the face
+    float fx = std::min(std::max((u * 0.5f + 0.5f) * size - 0.5f, 0.0f), float(size - 1));
+    float fy = std::min(std::max((v * 0.5f + 0.5f) * size - 0.5f, 0.0f), float(size - 1));
+    std::uint32_t x0 = std::uint32_t(fx), y0 = std::uint32_t(fy);
+    std::uint32_t x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+    float tx = fx - x0, ty = fy - y0;
+
+    const Pixel& a = image[std::size_t(y0)*size + x0];
+    const Pixel& b = image[std::size_t(y0)*size + x1];
+    const Pixel& c = image[std::size_t(y1)*size + x0];
+    const Pixel& d = image[std::size_t(y1)*size + x1];
+    auto lerp2 = [tx, ty](float a, float b, float c, float d) { return (a*(1-tx) + b*tx)*(1-ty) + (c*(1-tx) + d*tx)*ty; };
+    return Pixel{lerp2(a.r, b.r, c.r, d.r), lerp2(a.g, b.g, c.g, d.g), lerp2(a.b, b.b, c.b, d.b), 1.0f};
+}
+
+static Pixel sampleCube(const Cubemap& cube, const Vector3f& dir, float lod)
+{
+    Vector3f a = dir.cwiseAbs();
+    int face;
+    float u, v;
+    if(a.x() >= a.y() && a.x() >= a.z())
+    {
+        face = dir.x() > 0 ? 0 : 1;
+        u = (dir.x() > 0 ? -dir.z() : dir.z()) / a.x();
+        v = -dir.y() / a.x();
+    }
+    else if(a.y() >= a.z())
+    {
+        face = dir.y() > 0 ? 2 : 3;
+        u = dir.x() / a.y();
+        v = (dir.y() > 0 ? dir.z() : -dir.z()) / a.y();
+    }
+    else
+    {
+        face = dir.z() > 0 ? 4 : 5;
+        u = (dir.z() > 0 ? dir.x() : -dir.x()) / a.z();
+        v = -dir.y() / a.z();
+    }
+
+    // trilinear between the mips
+    const std::vector<Image>& mips = cube.faces[face];
+    lod = std::min(std::max(lod, 0.0f), float(mips.size() - 1));
+    std::uint32_t level = std::uint32_t(lod);
+    float t = lod - level;
+
+    Pixel p0 = sampleFace(mips[level], std::max(cube.size >> level, 1u), u, v);
+    if(t == 0.0f || level + 1 >= mips.size())
+        return p0;
+
+    Pixel p1 = sampleFace(mips[level + 1], std::max(cube.size >> (level + 1), 1u), u, v);
+    return Pixel{p0.r*(1-t) + p1.r*t, p0.g*(1-t) + p1.g*t, p0.b*(1-t) + p1.b*t, 1.0f};
+}
+
+static Cubemap loadCubemap(const std::string& filename)
+{
+    KTXFile file(filename);
+    const TextureDesc& desc = file.getDesc();
+    if(desc.Type != RESOURCE_DIM_TEX_CUBE || desc.Width != desc.Height)
+        DG_THROW("Environment map " + filename + " is not a cubemap");
+
+    Cubemap cube;
+    cube.size = desc.Width;
+    const std::vector<TextureSubResData>& subresources = file.getSubresources();
+    for(int face=0; face<6; ++face)
+    {
+        Image image;
+        if(!decode(subresources[face * desc.MipLevels], desc.Format, desc.Width, desc.Height, image))
+            DG_THROW("Unsupported format of environment map " + filename);
+
+        // own mip chain, for the filtered sampling
+        std::uint32_t size = cube.size;
+        cube.faces[face].push_back(image);
+        while(size > 1)
+        {
+            image = downsample(image, size, size);
+            size /= 2;
+            cube.faces[face].push_back(image);
+        }
+    }
+    return cube;
+}
+
+static Vector3f tangentToWorld(const Vector3f& v, const Vector3f& n)
+{
+    Vector3f up = std::fabs(n.z()) < 0.999f ? Vector3f(0, 0, 1) : Vector3f(1, 0, 0);
+    Vector3f tx = up.cross(n).normalized();
+    Vector3f ty = n.cross(tx);
+    return tx * v.x() + ty * v.y() + n * v.z();
+}
+
+// cosine weighted integral of the hemisphere around the normal
+static Pixel irradiance(const Cubemap& cube, const Vector3f& n)
+{
+    const int phi_steps = 64, theta_steps = 16;
+
+    // from a mip, where the steps are about a texel
+    float lod = std::max(std::log2(cube.size / 16.0f), 0.0f);
+
+    Pixel sum{0, 0, 0, 0};
+    for(int i=0; i<phi_steps; ++i)
+    {
+        float phi = 2.0f * float(M_PI) * (i + 0.5f) / phi_steps;
+        for(int j=0; j<theta_steps; ++j)
+        {
+            float theta = 0.5f * float(M_PI) * (j + 0.5f) / theta_steps;
+            Vector3f dir(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+            Pixel p = sampleCube(cube, tangentToWorld(dir, n), lod);
+            float w = std::cos(theta) * std::sin(theta);
+            sum.r += p.r * w;
+            sum.g += p.g * w;
+            sum.b += p.b * w;
+        }
+    }
+
+    float scale = float(M_PI) / (phi_steps * theta_steps);
+    return Pixel{sum.r * scale, sum.g * scale, sum.b * scale, 1.0f};
+}
+
+static float radicalInverse(std::uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return float(bits) * 2.3283064365386963e-10f;
+}
+
+// GGX importance sampling with N = V = R and filtered samples (split sum approximation)
+static Pixel prefilter(const Cubemap& cube, const Vector3f& n, float roughness)
+{
+    if(roughness == 0.0f)
+        return sampleCube(cube, n, 0.0f);
+
+    float alpha = roughness * roughness;
+    float texel_solid_angle = 4.0f * float(M_PI) / (6.0f * cube.size * cube.size);
+
+    Pixel sum{0, 0, 0, 0};
+    float weight = 0.0f;
+    for(std::uint32_t i=0; i<PREFILTER_SAMPLES; ++i)
+    {
+        float xi0 = float(i) / PREFILTER_SAMPLES, xi1 = radicalInverse(i);
+        float phi = 2.0f * float(M_PI) * xi0;
+        float cos_theta = std::sqrt((1.0f - xi1) / (1.0f + (alpha*alpha - 1.0f) * xi1));
+        float sin_theta = std::sqrt(1.0f - cos_theta*cos_theta);
+        Vector3f h = tangentToWorld(Vector3f(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta), n);
+        Vector3f l = 2.0f * n.dot(h) * h - n;
+
+        float n_dot_l = n.dot(l);
+        if(n_dot_l <= 0.0f)
+            continue;
+
+        // the mip, where a texel covers the solid angle of the sample
+        float n_dot_h = cos_theta;
+        float d = alpha*alpha / (float(M_PI) * std::pow(n_dot_h*n_dot_h * (alpha*alpha - 1.0f) + 1.0f, 2.0f));
+        float pdf = d / 4.0f;
+        float sample_solid_angle = 1.0f / (PREFILTER_SAMPLES * pdf);
+        float lod = 0.5f * std::log2(sample_solid_angle / texel_solid_angle) + 1.0f;
+
+        Pixel p = sampleCube(cube, l, lod);
+        sum.r += p.r * n_dot_l;
+        sum.g += p.g * n_dot_l;
+        sum.b += p.b * n_dot_l;
+        weight += n_dot_l;
+    }
+
+    return Pixel{sum.r / weight, sum.g / weight, sum.b / weight, 1.0f};
+}
+
+static void bakeEnvironment(AssetPack::Writer& writer, const std::string& name, const std::string& filename)
+{
+    Cubemap cube = loadCubemap(filename);
+    writer.addFile(AssetPack::ENTRY_ENVIRONMENT_MAP, name, filename);
+
+    // irradiance as RGBA32F with one level
+    {
+        TextureDesc desc;
+        desc.Type = RESOURCE_DIM_TEX_CUBE;
+        desc.Width = desc.Height = IRRADIANCE_SIZE;
+        desc.ArraySize = 6;
+        desc.MipLevels = 1;
+        desc.Format = TEX_FORMAT_RGBA32_FLOAT;
+
+        std::vector<std::vector<std::uint8_t>> levels(1, std::vector<std::uint8_t>(6 * IRRADIANCE_SIZE * IRRADIANCE_SIZE * sizeof(Pixel)));
+        Pixel* pixels = reinterpret_cast<Pixel*>(levels[0].data());
+        parallelFor(6 * IRRADIANCE_SIZE, [&](std::size_t row)
+        {
+            int face = int(row / IRRADIANCE_SIZE);
+            std::uint32_t y = std::uint32_t(row % IRRADIANCE_SIZE);
+            for(std::uint32_t x=0; x<IRRADIANCE_SIZE; ++x)
+                pixels[row * IRRADIANCE_SIZE + x] = irradiance(cube, texelDirection(face, x, y, IRRADIANCE_SIZE));
+        });
+        writer.addTexture(AssetPack::ENTRY_IRRADIANCE_MAP, name, desc, std::move(levels));
+    }
+
+    // prefiltered as RGBA16F with all levels, the roughness increases linearly with the level
+    {
+        TextureDesc desc;
+        desc.Type = RESOURCE_DIM_TEX_CUBE;
+        desc.Width = desc.Height = PREFILTERED_SIZE;
+        desc.ArraySize = 6;
+        desc.MipLevels = 1;
+        while((PREFILTERED_SIZE >> desc.MipLevels) > 0)
+            ++desc.MipLevels;
+        desc.Format = TEX_FORMAT_RGBA16_FLOAT;
+
+        std::vector<std::vector<std::uint8_t>> levels;
+        for(std::uint32_t mip=0; mip<desc.MipLevels; ++mip)
+        {
+            std::uint32_t size = std::max(PREFILTERED_SIZE >> mip, 1u);
+            float roughness = float(mip) / (desc.MipLevels - 1);
+
+            levels.emplace_back(6 * std::size_t(size) * size * 4 * sizeof(std::uint16_t));
+            std::uint16_t* texels = reinterpret_cast<std::uint16_t*>(levels.back().data());
+            parallelFor(6 * size, [&](std::size_t row)
+            {
+                int face = int(row / size);
+                std::uint32_t y = std::uint32_t(row % size);
+                for(std::uint32_t x=0; x<size; ++x)
+                {
+                    Pixel p = prefilter(cube, texelDirection(face, x, y, size), roughness);
+                    std::uint16_t* t = texels + (row * size + x) * 4;
+                    t[0] = floatToHalf(p.r);
+                    t[1] = floatToHalf(p.g);
+                    t[2] = floatToHalf(p.b);
+                    t[3] = floatToHalf(1.0f);
+                }
+            });
+        }
+        writer.addTexture(AssetPack::ENTRY_PREFILTERED_MAP, name, desc, std::move(levels));
+    }
+}
+
+
+// ---- meshes ---------------------------------------------------------------------------------------------------
+
+static void bakeMesh(AssetPack::Writer& writer, const std::string& name, const std::string& filename)
+{
+    MeshLoadSettings settings;
+    settings.cache_enabled = false;
+
+    MeshLoader loader(filename, settings);
+    loader.load();
+    writer.addMeshes(name, loader.takeMeshes());
+}
+
+
+// ---- info -----------------------------------------------------------------------------------------------------
+
+static void printKTX(const KTXFile::Ptr& file)
+{
+    const TextureDesc& desc = file->getDesc();
+    std::printf("    KTX %u, format %d, %u x %u, %u slices, %u mips, supercompression %d\n", file->getVersion(),
+                int(desc.Format), desc.Width, desc.Height, file->getSliceCount(), desc.MipLevels,
+                int(file->getSupercompression()));
+}
+
+static void printInfo(const std::string& filename)
+{
+    if(KTXFile::isKTXFile(filename))
+    {
+        std::printf("%s\n", filename.c_str());
+        printKTX(KTXFile::open(filename));
+        return;
+    }
+
+    static const char* type_names[] = {"", "mesh", "texture", "environment map", "irradiance map", "prefiltered map"};
+
+    AssetPack::Ptr pack = AssetPack::open(filename);
+    std::printf("%s: %zu entries\n", filename.c_str(), pack->getEntryCount());
+    for(std::size_t i=0; i<pack->getEntryCount(); ++i)
+    {
+        const AssetPack::Entry& entry = pack->getEntry(i);
+        std::string name = pack->getEntryName(i);
+        std::printf("  %-16s %-32s %12llu bytes\n", entry.type < 6 ? type_names[entry.type] : "unknown", name.c_str(),
+                    static_cast<unsigned long long>(entry.size));
+
+        if(entry.type == AssetPack::ENTRY_MESH)
+        {
+            MeshFile::Ptr meshes = pack->getMeshFile(name);
+            for(std::size_t m=0; m<meshes->getMeshCount(); ++m)
+            {
+                MeshFile::MeshView view = meshes->getMesh(m);
+                std::printf("    mesh %zu: %u vertices, %u indices, %zu lods\n", m, view.vertex_count, view.index_count,
+                            view.lods.size());
+            }
+        }
+        else
+            printKTX(pack->getTexture(name, AssetPack::EntryType(entry.type)));
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    if(argc == 3 && std::string(argv[1]) == "--info")
+    {
+        try
+        {
+            printInfo(argv[2]);
+            return 0;
+        }
+        catch(const std::exception& e)
+        {
+            std::fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+    }
+
+    std::string output;
+    AssetPack::Writer writer;
+    try
+    {
+        for(int i=1; i<argc; ++i)
+        {
+            std::string option = argv[i];
+            if(i + 1 >= argc)
+                DG_THROW("Missing argument of " + option);
+            std::string arg = argv[++i];
+
+            if(option == "-o")
+            {
+                output = arg;
+                continue;
+            }
+
+            std::size_t eq = arg.find('=');
+            if(eq == std::string::npos)
+                DG_THROW("Expected name=file for " + option);
+            std::string name = arg.substr(0, eq), filename = arg.substr(eq + 1);
+
+            std::printf("baking %s\n", filename.c_str());
+            if(option == "-m")
+                bakeMesh(writer, name, filename);
+            else if(option == "-t")
+                bakeTexture(writer, name, filename);
+            else if(option == "-e")
+                bakeEnvironment(writer, name, filename);
+            else
+                DG_THROW("Unknown option " + option);
+        }
+
+        if(output.empty() || writer.getEntryCount() == 0)
+        {
+            std::fprintf(stderr, "usage: %s -o assets.dgpack [-m name=mesh] [-t name=texture.ktx] [-e name=environment.ktx] ...\n"
+                                 "       %s --info file.dgpack|file.ktx|file.ktx2\n", argv[0], argv[0]);
+            return 1;
+        }
+
+        writer.write(output);
+        printInfo(output);
+    }
+    catch(const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
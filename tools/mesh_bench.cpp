@@ -0,0 +1,110 @@
+// Benchmark of the mesh optimizations: reports the ACMR (average cache miss ratio) of the post-transform
+// vertex cache and the vertex fetch efficiency before and after optimizing some generated meshes.
+//
+// usage: mesh_bench [grid_size]
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include <dg/geometry/box_geometry.hpp>
+#include <dg/geometry/sphere_geometry.hpp>
+#include <dg/geometry/mesh_data.hpp>
+#include <dg/geometry/mesh_optimizer.hpp>
+
+using namespace dg;
+
+// regular grid (like a height field or a depth scan), with the triangles in random order as they
+// often come out of reconstruction or CAD tessellation
+static MeshData makeShuffledGrid(int size)
+{
+    Geometry grid;
+    for(int y=0; y<=size; ++y)
+        for(int x=0; x<=size; ++x)
+            grid.getPositions().push_back(Vector3(x, y, 0.1*std::sin(0.1*x)*std::cos(0.1*y)));
+
+    MeshData data = MeshData::fromGeometry(grid);
+
+    std::vector<std::uint32_t> tris;
+    for(int y=0; y<size; ++y)
+    {
+        for(int x=0; x<size; ++x)
+        {
+            std::uint32_t i = y*(size+1)+x;
+            tris.insert(tris.end(), {i, i+1, i+size+2,   i, i+size+2, i+size+1});
+        }
+    }
+
+    std::vector<std::size_t> order(tris.size()/3);
+    for(std::size_t i=0; i<order.size(); ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    for(std::size_t t : order)
+        data.indices.insert(data.indices.end(), tris.begin()+3*t, tris.begin()+3*t+3);
+
+    return data;
+}
+
+// simulates a small direct mapped cache with 64 byte lines for the vertex fetches and returns the ratio of the
+// fetched bytes to the size of the vertex buffer (1 is optimal)
+static double overfetch(const MeshData& data)
+{
+    const std::size_t line_size = 64;
+    const std::size_t line_count = 128;
+
+    std::vector<std::size_t> lines(line_count, std::size_t(-1));
+    std::size_t fetched = 0;
+
+    for(std::uint32_t v : data.indices)
+    {
+        std::size_t begin = std::size_t(v)*data.vertex_stride / line_size;
+        std::size_t end = (std::size_t(v+1)*data.vertex_stride - 1) / line_size;
+        for(std::size_t line = begin; line <= end; ++line)
+        {
+            if(lines[line % line_count] != line)
+            {
+                lines[line % line_count] = line;
+                fetched += line_size;
+            }
+        }
+    }
+
+    return double(fetched) / double(std::size_t(data.vertex_count)*data.vertex_stride);
+}
+
+static void bench(const std::string& name, MeshData data)
+{
+    const std::size_t tri_count = data.indices.size()/3;
+
+    float acmr16 = computeACMR(data.indices.data(), data.indices.size(), data.vertex_count, 16);
+    float acmr32 = computeACMR(data.indices.data(), data.indices.size(), data.vertex_count, 32);
+    double fetch = overfetch(data);
+
+    auto start = std::chrono::steady_clock::now();
+    optimizeMesh(MeshOptimization_All, data);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // the ACMR is bounded below by vertices/triangles, which is ~0.5 for closed regular meshes
+    std::printf("%-16s %9zu tris  ACMR(16) %.3f -> %.3f  ACMR(32) %.3f -> %.3f  ATVR(16) %.3f  overfetch %6.2f -> %5.2f  %8.1f ms\n",
+                name.c_str(), tri_count,
+                acmr16, computeACMR(data.indices.data(), data.indices.size(), data.vertex_count, 16),
+                acmr32, computeACMR(data.indices.data(), data.indices.size(), data.vertex_count, 32),
+                computeACMR(data.indices.data(), data.indices.size(), data.vertex_count, 16) * tri_count / data.vertex_count,
+                fetch, overfetch(data), ms);
+}
+
+int main(int argc, char** argv)
+{
+    int grid_size = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+    bench("sphere 48x32",   MeshData::fromGeometry(SphereGeometry(SphereGeometry::Params(1.0f, 48, 32))));
+    bench("sphere 512x256", MeshData::fromGeometry(SphereGeometry(SphereGeometry::Params(1.0f, 512, 256))));
+    bench("box 64^3",       MeshData::fromGeometry(BoxGeometry(BoxGeometry::Params(1.0f, 1.0f, 1.0f, 64, 64, 64))));
+    bench("shuffled grid",  makeShuffledGrid(grid_size));
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Benchmark of the pixel conversion kernels of DynamicTexture: converts camera sized images of each data format to
+// RGBA8 with every kernel that the CPU supports, checks the results against the scalar kernel and reports the
+// time per image and the throughput.
+//
+// usage: tex_convert_bench [width height [iterations]]
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dg/material/dynamic_texture.hpp>
+
+using namespace dg;
+
+static const char* formatName(DynamicTexture::DataFormat format)
+{
+    switch(format)
+    {
+        case DynamicTexture::GREY8:  return "GREY8";
+        case DynamicTexture::GREY16: return "GREY16";
+        case DynamicTexture::RGB8:   return "RGB8";
+        case DynamicTexture::RGBA8:  return "RGBA8";
+        case DynamicTexture::GREY_ALPHA8:  return "GREY_ALPHA8";
+        case DynamicTexture::GREY_ALPHA16: return "GREY_ALPHA16";
+        default:                           return "unknown"; // decoded on the GPU, not converted
+    }
+}
+
+static std::uint32_t bytesPerPixel(DynamicTexture::DataFormat format)
+{
+    switch(format)
+    {
+        case DynamicTexture::GREY8:  return 1;
+        case DynamicTexture::GREY16: return 2;
+        case DynamicTexture::RGB8:   return 3;
+        case DynamicTexture::RGBA8:  return 4;
+        case DynamicTexture::GREY_ALPHA8:  return 2;
+        case DynamicTexture::GREY_ALPHA16: return 4;
+        default:                           return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::uint32_t width = argc > 2 ? std::uint32_t(std::atoi(argv[1])) : 3840;
+    std::uint32_t height = argc > 2 ? std::uint32_t(std::atoi(argv[2])) : 2160;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 50;
+
+    std::printf("%ux%u, %d iterations\n", width, height, iterations);
+    std::printf("%-8s %-8s %10s %10s %8s\n", "format", "kernel", "ms/image", "MPixel/s", "speedup");
+
+    std::mt19937 random(42);
+    for(DynamicTexture::DataFormat format : {DynamicTexture::GREY8, DynamicTexture::GREY16, DynamicTexture::RGB8, DynamicTexture::RGBA8})
+    {
+        // rows with some padding, as camera drivers often deliver them
+        std::uint32_t stride = (width*bytesPerPixel(format) + 63) / 64 * 64;
+        std::vector<std::uint8_t> src(std::size_t(stride)*height);
+        for(std::uint8_t& byte : src)
+            byte = std::uint8_t(random());
+
+        DynamicTexture::ImageData data{src.data(), stride, width, height, format};
+        std::uint32_t dest_stride = width*4;
+
+        std::vector<std::uint8_t> reference(std::size_t(dest_stride)*height);
+        DynamicTexture::convert(data, reference.data(), dest_stride, DynamicTexture::KERNEL_SCALAR);
+
+        double scalar_ms = 0.0;
+        for(DynamicTexture::ConvertKernel kernel : DynamicTexture::getSupportedKernels())
+        {
+            std::vector<std::uint8_t> dest(reference.size());
+            DynamicTexture::convert(data, dest.data(), dest_stride, kernel);
+            if(std::memcmp(dest.data(), reference.data(), dest.size()) != 0)
+            {
+                std::printf("%-8s %-8s differs from the scalar kernel\n", formatName(format), DynamicTexture::getKernelName(kernel));
+                return 1;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for(int i=0; i<iterations; ++i)
+                DynamicTexture::convert(data, dest.data(), dest_stride, kernel);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            if(kernel == DynamicTexture::KERNEL_SCALAR)
+                scalar_ms = ms;
+
+            std::printf("%-8s %-8s %10.3f %10.1f %7.2fx\n", formatName(format), DynamicTexture::getKernelName(kernel),
+                        ms, double(width)*height / (ms*1000.0), scalar_ms / ms);
+        }
+    }
+
+    return 0;
+}